@@ -0,0 +1,143 @@
+#pragma once
+#include "OrderCommand.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/**
+ * Shape of the synthetic order flow.
+ * Weights are relative; they do not need to sum to anything in particular.
+ */
+struct OrderFlowConfig {
+    // Command mix
+    double addWeight{ 60 };       // passive limit orders
+    double cancelWeight{ 30 };    // cancels of live orders
+    double modifyWeight{ 5 };     // size/price amendments
+    double tradeWeight{ 5 };      // marketable IOC orders
+
+    // Prices are drawn around midPrice, in ticks
+    Price midPrice{ 10000 };
+    Price tickSize{ 1 };
+    double priceStdDevTicks{ 10 };   // normal distribution; <= 0 means uniform over bookDepth
+
+    // Orders sit within this many ticks of the mid on each side
+    Price bookDepth{ 50 };
+
+    Quantity minQuantity{ 1 };
+    Quantity maxQuantity{ 100 };
+
+    double stopFraction{ 0 };        // fraction of adds that carry a stop price
+
+    std::uint64_t seed{ 1 };
+};
+
+/**
+ * Deterministic generator of add/cancel/modify/trade commands.
+ *
+ * Keeps a list of IDs it has added so cancels and modifies mostly hit live
+ * orders (some will have been filled already, like in real flow).
+ */
+class OrderFlowGenerator {
+public:
+    explicit OrderFlowGenerator(const OrderFlowConfig& config)
+        : config_{ config }, rng_{ config.seed },
+          mix_{ { config.addWeight, config.cancelWeight, config.modifyWeight, config.tradeWeight } },
+          offset_{ 0.0, std::max(config.priceStdDevTicks, 1.0) },
+          quantity_{ config.minQuantity, config.maxQuantity } { }
+
+    OrderCommand Next() {
+        auto kind = live_.empty() ? 0 : mix_(rng_);
+        auto side = (rng_() & 1) ? Side::Buy : Side::Sell;
+
+        switch (kind) {
+        case 1: {
+            // Cancel a random live order (swap-remove keeps this O(1))
+            auto slot = rng_() % live_.size();
+            auto orderID = live_[slot].orderID;
+            live_[slot] = live_.back();
+            live_.pop_back();
+            return OrderCommand::Cancel(orderID);
+        }
+        case 2: {
+            const auto& live = live_[rng_() % live_.size()];
+            return OrderCommand::Modify(OrderModify{ live.orderID, live.side, PassivePrice(live.side), quantity_(rng_) });
+        }
+        case 3: {
+            auto through = static_cast<Price>(config_.bookDepth * config_.tickSize);
+            auto price = side == Side::Buy ? config_.midPrice + through : config_.midPrice - through;
+            return OrderCommand::Add(OrderType::FillAndKill, nextID_++, side, price, quantity_(rng_));
+        }
+        default: {
+            auto orderID = nextID_++;
+            auto price = PassivePrice(side);
+            std::optional<Price> stopPrice;
+            if (config_.stopFraction > 0 && unit_(rng_) < config_.stopFraction) {
+                auto away = static_cast<Price>(1 + rng_() % config_.bookDepth) * config_.tickSize;
+                stopPrice = side == Side::Buy ? config_.midPrice + away : config_.midPrice - away;
+            } else {
+                live_.push_back({ orderID, side });
+            }
+            return OrderCommand::Add(OrderType::GoodTillCancel, orderID, side, price, quantity_(rng_), stopPrice);
+        }
+        }
+    }
+
+    std::vector<OrderCommand> Generate(std::size_t count) {
+        std::vector<OrderCommand> commands;
+        commands.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+            commands.push_back(Next());
+        return commands;
+    }
+
+    /**
+     * Resting orders on both sides, levelsPerSide levels deep, not crossing.
+     */
+    std::vector<OrderCommand> SeedBook(Price levelsPerSide, std::size_t ordersPerLevel) {
+        std::vector<OrderCommand> commands;
+        for (Price level = 1; level <= levelsPerSide; ++level) {
+            for (std::size_t i = 0; i < ordersPerLevel; ++i) {
+                auto bidID = nextID_++;
+                auto askID = nextID_++;
+                commands.push_back(OrderCommand::Add(OrderType::GoodTillCancel, bidID, Side::Buy,
+                    config_.midPrice - level * config_.tickSize, quantity_(rng_)));
+                commands.push_back(OrderCommand::Add(OrderType::GoodTillCancel, askID, Side::Sell,
+                    config_.midPrice + level * config_.tickSize, quantity_(rng_)));
+                live_.push_back({ bidID, Side::Buy });
+                live_.push_back({ askID, Side::Sell });
+            }
+        }
+        return commands;
+    }
+
+private:
+    // Non-crossing price on the given side of the mid
+    Price PassivePrice(Side side) {
+        Price ticks;
+        if (config_.priceStdDevTicks > 0)
+            ticks = 1 + static_cast<Price>(std::abs(offset_(rng_)));
+        else
+            ticks = 1 + static_cast<Price>(rng_() % config_.bookDepth);
+        ticks = std::min(ticks, config_.bookDepth);
+
+        return side == Side::Buy ? config_.midPrice - ticks * config_.tickSize
+                                 : config_.midPrice + ticks * config_.tickSize;
+    }
+
+    OrderFlowConfig config_;
+    std::mt19937_64 rng_;
+    std::discrete_distribution<int> mix_;
+    std::normal_distribution<double> offset_;
+    std::uniform_int_distribution<Quantity> quantity_;
+    std::uniform_real_distribution<double> unit_{ 0.0, 1.0 };
+
+    struct LiveOrder {
+        OrderID orderID;
+        Side side;
+    };
+
+    OrderID nextID_{ 1 };
+    std::vector<LiveOrder> live_;
+};
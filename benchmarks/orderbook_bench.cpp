@@ -0,0 +1,1057 @@
+#include <benchmark/benchmark.h>
+#include "Orderbook.h"
+#include "MatchingEngine.h"
+#include "Journal.h"
+#include "DepthPublisher.h"
+#include "MarketByOrderFeed.h"
+#include "OrderEntry.h"
+#include "OrderPipeline.h"
+#include <filesystem>
+#include "OrderFlowGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+// ===============================
+//            Helpers
+// ===============================
+
+constexpr Price Mid = 10000;
+constexpr std::size_t BatchSize = 10000;
+
+// Range argument 1 selects the level container: 0 = std::map, 1 = ladder
+template <typename Book = Orderbook>
+static Book MakeBook(std::int64_t ladder) {
+    if (ladder)
+        return Book{LadderConfig{Mid - 5000, 1, 10000}};
+    return Book{};
+}
+
+template <typename Book>
+static void Apply(Book& book, const std::vector<OrderCommand>& commands) {
+    Trades trades;
+    book.ProcessBatch(commands, trades);
+}
+
+// Adds p50/p99/p99.9/max counters for per-command latencies in nanoseconds
+static void ReportLatencies(benchmark::State& state, std::vector<std::uint64_t>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    auto Percentile = [&](double p) {
+        return static_cast<double>(latencies[static_cast<std::size_t>(p * (latencies.size() - 1))]);
+    };
+
+    state.counters["p50_ns"] = Percentile(0.50);
+    state.counters["p99_ns"] = Percentile(0.99);
+    state.counters["p99.9_ns"] = Percentile(0.999);
+    state.counters["max_ns"] = static_cast<double>(latencies.back());
+}
+
+static void LadderArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"depth", "ladder"});
+    for (std::int64_t depth : {10, 1000})
+        for (std::int64_t ladder : {0, 1})
+            bench->Args({depth, ladder});
+}
+
+// ===============================
+//        Single-op benchmarks
+// ===============================
+
+// Adds BatchSize non-crossing orders spread over `depth` levels per side
+static void BM_AddOrderResting(benchmark::State& state) {
+    auto depth = static_cast<Price>(state.range(0));
+    std::mt19937_64 rng{1};
+
+    std::vector<Order> orders;
+    orders.reserve(BatchSize);
+    for (OrderID id = 1; id <= BatchSize; ++id) {
+        auto side = (id & 1) ? Side::Buy : Side::Sell;
+        Price offset = 1 + Price(rng() % depth);
+        orders.emplace_back(OrderType::GoodTillCancel, id, side,
+                            side == Side::Buy ? Mid - offset : Mid + offset, 10);
+    }
+
+    Trades trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>(MakeBook(state.range(1)));
+        state.ResumeTiming();
+
+        for (const auto& order : orders)
+            book->AddOrder(order, trades);
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_AddOrderResting)->Apply(LadderArgs);
+
+// Each item is one aggressive IOC that fully fills against the best ask
+static void BM_AddOrderCrossing(benchmark::State& state) {
+    auto depth = static_cast<Price>(state.range(0));
+
+    std::vector<Order> makers, takers;
+    for (OrderID id = 1; id <= BatchSize; ++id) {
+        makers.emplace_back(OrderType::GoodTillCancel, id, Side::Sell, Mid + Price(id % depth), 10);
+        takers.emplace_back(OrderType::FillAndKill, BatchSize + id, Side::Buy, Mid + depth, 10);
+    }
+
+    Trades trades;
+    trades.reserve(2 * BatchSize);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>(MakeBook(state.range(1)));
+        book->AddOrders(makers, trades);
+        trades.clear();
+        state.ResumeTiming();
+
+        for (const auto& taker : takers)
+            book->AddOrder(taker, trades);
+
+        state.PauseTiming();
+        trades.clear();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_AddOrderCrossing)->Apply(LadderArgs);
+
+// Crossing takers against other owners' makers; range 0: 1 = CancelOldest enabled,
+// so every fill pays the owner check without it ever firing, 0 = prevention off
+static void BM_SelfTradePreventionCheck(benchmark::State& state) {
+    constexpr Price Depth = 10;
+
+    std::vector<Order> makers, takers;
+    for (OrderID id = 1; id <= BatchSize; ++id) {
+        makers.emplace_back(OrderType::GoodTillCancel, id, Side::Sell, Mid + Price(id % Depth), 10, std::nullopt,
+                            OwnerID(1 + id % 4));
+        takers.emplace_back(OrderType::FillAndKill, BatchSize + id, Side::Buy, Mid + Depth, 10, std::nullopt, 5);
+    }
+
+    Trades trades;
+    trades.reserve(2 * BatchSize);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        book->SetSelfTradePrevention(state.range(0) ? SelfTradePrevention::CancelOldest : SelfTradePrevention::None);
+        book->AddOrders(makers, trades);
+        trades.clear();
+        state.ResumeTiming();
+
+        for (const auto& taker : takers)
+            book->AddOrder(taker, trades);
+
+        state.PauseTiming();
+        trades.clear();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_SelfTradePreventionCheck)->ArgName("stp")->Arg(0)->Arg(1);
+
+// Orders collected during an auction, alternating sides over a band of `crossed`
+// levels that all cross; every add re-prices the indicative uncross
+static void BM_AuctionCollect(benchmark::State& state) {
+    auto crossed = static_cast<Price>(state.range(0));
+
+    std::vector<Order> orders;
+    for (OrderID id = 1; id <= BatchSize; ++id)
+        orders.emplace_back(OrderType::GoodTillCancel, id, id % 2 ? Side::Buy : Side::Sell,
+                            Mid + Price(id * 7 % crossed), 10);
+
+    Trades trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        book->StartAuction(Mid);
+        state.ResumeTiming();
+
+        book->AddOrders(orders, trades);
+        benchmark::DoNotOptimize(book->GetIndicativeUncross());
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_AuctionCollect)->ArgName("crossed")->Arg(10)->Arg(100);
+
+// Uncrossing the book BM_AuctionCollect builds, in bulk
+static void BM_AuctionUncross(benchmark::State& state) {
+    auto crossed = static_cast<Price>(state.range(0));
+
+    std::vector<Order> orders;
+    for (OrderID id = 1; id <= BatchSize; ++id)
+        orders.emplace_back(OrderType::GoodTillCancel, id, id % 2 ? Side::Buy : Side::Sell,
+                            Mid + Price(id * 7 % crossed), 10);
+
+    Trades trades;
+    trades.reserve(2 * BatchSize);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        book->StartAuction(Mid);
+        book->AddOrders(orders, trades);
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(book->Uncross(trades));
+
+        state.PauseTiming();
+        trades.clear();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_AuctionUncross)->ArgName("crossed")->Arg(10)->Arg(100);
+
+// Takers each use up one displayed peak; range 0: 1 = a single iceberg refilling
+// itself from its reserve, 0 = the same quantity as one plain order per peak
+static void BM_IcebergReplenish(benchmark::State& state) {
+    constexpr Quantity Peak = 10;
+
+    std::vector<Order> makers, takers;
+    if (state.range(0)) {
+        makers.emplace_back(OrderType::GoodTillCancel, 1, Side::Sell, Mid, Peak * BatchSize, std::nullopt, NoOwner, Peak);
+    } else {
+        for (OrderID id = 1; id <= BatchSize; ++id)
+            makers.emplace_back(OrderType::GoodTillCancel, id, Side::Sell, Mid, Peak);
+    }
+    for (OrderID id = 1; id <= BatchSize; ++id)
+        takers.emplace_back(OrderType::FillAndKill, BatchSize + id, Side::Buy, Mid, Peak);
+
+    Trades trades;
+    trades.reserve(2 * BatchSize);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        book->AddOrders(makers, trades);
+        trades.clear();
+        state.ResumeTiming();
+
+        for (const auto& taker : takers)
+            book->AddOrder(taker, trades);
+
+        state.PauseTiming();
+        trades.clear();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_IcebergReplenish)->ArgName("iceberg")->Arg(0)->Arg(1);
+
+// Clears BatchSize resting orders over 100 levels at the close; range 0:
+// 0 = GoodTillCancel orders swept with one CancelOrder each, 1 = Day orders
+// expired by a single AdvanceTime
+static void BM_ExpireAtClose(benchmark::State& state) {
+    constexpr Timestamp Close = 1000;
+    bool expire = state.range(0) != 0;
+
+    std::vector<Order> orders;
+    for (OrderID id = 1; id <= BatchSize; ++id)
+        orders.emplace_back(expire ? OrderType::Day : OrderType::GoodTillCancel, id, Side::Buy, Mid - Price(id % 100), 10);
+
+    Trades trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        book->SetSessionSchedule(Close, Close);
+        book->AddOrders(orders, trades);
+        state.ResumeTiming();
+
+        if (expire) {
+            book->AdvanceTime(Close);
+        } else {
+            for (const auto& order : orders)
+                book->CancelOrder(order.GetOrderID());
+        }
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_ExpireAtClose)->ArgName("wheel")->Arg(0)->Arg(1);
+
+// Cancels BatchSize resting orders in random order
+static void BM_CancelOrder(benchmark::State& state) {
+    auto depth = static_cast<Price>(state.range(0));
+
+    std::vector<Order> orders;
+    for (OrderID id = 1; id <= BatchSize; ++id)
+        orders.emplace_back(OrderType::GoodTillCancel, id, Side::Buy, Mid - Price(id % depth), 10);
+
+    std::vector<OrderID> cancels(BatchSize);
+    std::iota(cancels.begin(), cancels.end(), OrderID{1});
+    std::shuffle(cancels.begin(), cancels.end(), std::mt19937_64{2});
+
+    Trades trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>(MakeBook(state.range(1)));
+        book->AddOrders(orders, trades);
+        state.ResumeTiming();
+
+        for (auto orderID : cancels)
+            book->CancelOrder(orderID);
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_CancelOrder)->Apply(LadderArgs);
+
+// Range 0: 0 = size-only reduce (in place), 1 = price change (cancel-replace)
+static void BM_ModifyOrder(benchmark::State& state) {
+    bool reprice = state.range(0) != 0;
+
+    std::vector<Order> orders;
+    std::vector<OrderModify> modifies;
+    for (OrderID id = 1; id <= BatchSize; ++id) {
+        Price price = Mid - Price(id % 100);
+        orders.emplace_back(OrderType::GoodTillCancel, id, Side::Buy, price, 100);
+        modifies.emplace_back(id, Side::Buy, reprice ? price - 1 : price, 50);
+    }
+
+    Trades trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        book->AddOrders(orders, trades);
+        state.ResumeTiming();
+
+        for (const auto& modify : modifies)
+            benchmark::DoNotOptimize(book->ModifyOrder(modify));
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_ModifyOrder)->ArgName("reprice")->Arg(0)->Arg(1);
+
+static void BM_GetOrderInfos(benchmark::State& state) {
+    OrderFlowGenerator generator{OrderFlowConfig{}};
+    Orderbook book;
+    Apply(book, generator.SeedBook(static_cast<Price>(state.range(0)), 4));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(book.GetOrderInfos());
+}
+BENCHMARK(BM_GetOrderInfos)->ArgName("levels")->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_GetTopLevels(benchmark::State& state) {
+    OrderFlowGenerator generator{OrderFlowConfig{}};
+    Orderbook book;
+    Apply(book, generator.SeedBook(1000, 4));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(book.GetTopLevels(static_cast<std::size_t>(state.range(0))));
+}
+BENCHMARK(BM_GetTopLevels)->ArgName("depth")->Arg(5)->Arg(20);
+
+// FillOrKill that walks `levels` levels and is then rejected
+static void BM_FillOrKillCheck(benchmark::State& state) {
+    auto levels = static_cast<Price>(state.range(0));
+
+    Orderbook book;
+    Trades trades;
+    OrderID id = 1;
+    for (Price level = 0; level < levels; ++level)
+        for (int i = 0; i < 4; ++i)
+            book.AddOrder(Order{OrderType::GoodTillCancel, id++, Side::Sell, Mid + level, 10}, trades);
+
+    Order fok{OrderType::FillOrKill, id, Side::Buy, Mid + levels, static_cast<Quantity>(levels * 40 + 1)};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(book.AddOrder(fok, trades));
+}
+BENCHMARK(BM_FillOrKillCheck)->ArgName("levels")->Arg(1)->Arg(10)->Arg(100);
+
+// Cost of sweeping all but the last lot of `levels` ask levels. Range 1: 0 = the query on a
+// ladder-backed book (Fenwick trees), 1 = copying the levels out and summing them,
+// 2 = the query on a map-only book, which walks the levels
+static void BM_CostToFill(benchmark::State& state) {
+    auto levels = static_cast<Price>(state.range(0));
+    bool walk = state.range(1) == 1;
+
+    auto book = state.range(1) == 2 ? Orderbook{} : Orderbook{LadderConfig{Mid, 1, static_cast<std::size_t>(levels)}};
+    Trades trades;
+    OrderID id = 1;
+    for (Price level = 0; level < levels; ++level)
+        for (int i = 0; i < 4; ++i)
+            book.AddOrder(Order{OrderType::GoodTillCancel, id++, Side::Sell, Mid + level, 10}, trades);
+
+    auto quantity = static_cast<std::uint64_t>(levels) * 40 - 1;
+    std::vector<LevelInfo> buffer(static_cast<std::size_t>(levels));
+    for (auto _ : state) {
+        if (!walk) {
+            benchmark::DoNotOptimize(book.GetCostToFill(Side::Buy, quantity));
+            continue;
+        }
+        auto count = book.GetTopLevels(Side::Sell, buffer);
+        FillCost cost;
+        for (std::size_t i = 0; i < count && cost.quantity < quantity; ++i) {
+            auto take = std::min<std::uint64_t>(buffer[i].quantity_, quantity - cost.quantity);
+            cost.quantity += take;
+            cost.notional += static_cast<std::uint64_t>(buffer[i].price_) * take;
+            cost.worstPrice = buffer[i].price_;
+        }
+        benchmark::DoNotOptimize(cost);
+    }
+}
+BENCHMARK(BM_CostToFill)->ArgNames({ "levels", "mode" })->ArgsProduct({ { 10, 100, 1000 }, { 0, 1, 2 } });
+
+// One aggressive sell that sets off a chain of `length` sell stops
+static void BM_StopCascade(benchmark::State& state) {
+    auto length = static_cast<Price>(state.range(0));
+
+    std::vector<Order> setup;
+    OrderID id = 1;
+    for (Price step = 0; step <= length; ++step)
+        setup.emplace_back(OrderType::GoodTillCancel, id++, Side::Buy, Mid - step, 1);
+    for (Price step = 0; step < length; ++step)
+        setup.emplace_back(OrderType::GoodTillCancel, id++, Side::Sell, 0, 1, Mid - step);
+    Order trigger{OrderType::GoodTillCancel, id, Side::Sell, Mid, 1};
+
+    Trades trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        book->AddOrders(setup, trades);
+        trades.clear();
+        state.ResumeTiming();
+
+        book->AddOrder(trigger, trades);
+
+        state.PauseTiming();
+        trades.clear();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * (length + 1));
+}
+BENCHMARK(BM_StopCascade)->ArgName("length")->Arg(10)->Arg(100)->Arg(1000);
+
+// ===============================
+//      Synthetic order flow
+// ===============================
+
+// Mix profiles: 0 = quoting (add/cancel heavy), 1 = balanced, 2 = aggressive
+static OrderFlowConfig FlowProfile(std::int64_t profile) {
+    OrderFlowConfig config;
+    switch (profile) {
+    case 0:
+        config.addWeight = 50; config.cancelWeight = 45; config.modifyWeight = 4; config.tradeWeight = 1;
+        break;
+    case 1:
+        break;
+    default:
+        config.addWeight = 50; config.cancelWeight = 20; config.modifyWeight = 5; config.tradeWeight = 25;
+        config.stopFraction = 0.05;
+        break;
+    }
+    return config;
+}
+
+// Replays generated flow one command at a time and reports per-command latency
+static void BM_OrderFlow(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 200000;
+
+    OrderFlowGenerator generator{FlowProfile(state.range(0))};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(FlowSize);
+
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(FlowSize);
+    Trades trades;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>(MakeBook(state.range(1)));
+        Apply(*book, seed);
+        latencies.clear();
+        state.ResumeTiming();
+
+        for (const auto& command : flow) {
+            auto start = std::chrono::steady_clock::now();
+            book->ProcessBatch({&command, 1}, trades);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            trades.clear();
+        }
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+    ReportLatencies(state, latencies);
+}
+BENCHMARK(BM_OrderFlow)
+    ->ArgNames({"profile", "ladder"})
+    ->ArgsProduct({{0, 1, 2}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// The same stop-free flow through the full book and the one compiled without
+// stops, self-trade prevention and instrumentation
+template <typename Book>
+static void BM_OrderFlowPolicy(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 200000;
+
+    OrderFlowGenerator generator{FlowProfile(state.range(0))};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(FlowSize);
+    Trades trades;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Book>(MakeBook<Book>(1));
+        Apply(*book, seed);
+        state.ResumeTiming();
+
+        book->ProcessBatch(flow, trades);
+        trades.clear();
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+}
+BENCHMARK_TEMPLATE(BM_OrderFlowPolicy, Orderbook)->ArgName("profile")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderFlowPolicy, LeanOrderbook)->ArgName("profile")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// ===============================
+//      Multi-instrument engine
+// ===============================
+
+// Same per-instrument flow pushed through 1..N workers; items/s should scale with cores
+static void BM_MatchingEngine(benchmark::State& state) {
+    constexpr InstrumentID Instruments = 64;
+    constexpr std::size_t FlowSize = 5000;
+
+    std::vector<std::vector<OrderCommand>> flows;
+    for (InstrumentID instrument = 0; instrument < Instruments; ++instrument) {
+        OrderFlowConfig config;
+        config.seed = instrument + 1;
+        OrderFlowGenerator generator{config};
+        auto flow = generator.SeedBook(20, 2);
+        auto rest = generator.Generate(FlowSize);
+        flow.insert(flow.end(), rest.begin(), rest.end());
+        flows.push_back(std::move(flow));
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        MatchingEngine engine{MatchingEngineConfig{
+            .workerCount = static_cast<std::size_t>(state.range(0)), .pinThreads = true }};
+        for (InstrumentID instrument = 0; instrument < Instruments; ++instrument)
+            engine.AddInstrument(instrument);
+        engine.Start();
+        state.ResumeTiming();
+
+        for (std::size_t i = 0; i < flows[0].size(); ++i)
+            for (InstrumentID instrument = 0; instrument < Instruments; ++instrument)
+                engine.Submit(instrument, flows[instrument][i]);
+        engine.WaitIdle();
+
+        state.PauseTiming();
+        engine.Stop();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * Instruments * flows[0].size());
+}
+BENCHMARK(BM_MatchingEngine)
+    ->ArgName("workers")
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// ===============================
+//          Market data
+// ===============================
+
+// Keeps a downstream copy of full depth in sync after every command.
+// Range 0: 0 = re-read GetOrderInfos each time, 1 = apply the command's level updates
+static void BM_DepthSync(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 100000;
+
+    OrderFlowGenerator generator{FlowProfile(1)};
+    auto seed = generator.SeedBook(200, 5);
+    auto flow = generator.Generate(FlowSize);
+
+    struct Mirror : OrderbookListener {
+        OrderbookLevelInfos depth{ {}, {} };
+        void OnLevelUpdate(const LevelUpdate& update) override { depth.Apply(update); }
+    };
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        Apply(*book, seed);
+        Mirror mirror;
+        mirror.depth = book->GetOrderInfos();
+        state.ResumeTiming();
+
+        for (const auto& command : flow) {
+            if (state.range(0)) {
+                book->ProcessBatch({&command, 1}, mirror);
+            } else {
+                Trades trades;
+                book->ProcessBatch({&command, 1}, trades);
+                mirror.depth = book->GetOrderInfos();
+            }
+        }
+        benchmark::DoNotOptimize(mirror.depth.GetBids().data());
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+}
+BENCHMARK(BM_DepthSync)->ArgName("deltas")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Flow with and without an L3 feed attached; range 0: 1 = encode every event into the
+// ring while a consumer thread drains it, 0 = no feed
+static void BM_MarketByOrderFeed(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 200000;
+
+    OrderFlowGenerator generator{FlowProfile(1)};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(FlowSize);
+
+    MarketByOrderFeed feed{1 << 16};
+    std::atomic<bool> done{ false };
+    std::thread consumer;
+    if (state.range(0))
+        consumer = std::thread([&] {
+            std::vector<std::byte> buffer(4096 * MarketByOrderMessageSize);
+            while (!done.load(std::memory_order_relaxed))
+                if (feed.Read(buffer) == 0)
+                    std::this_thread::yield();
+        });
+
+    OrderbookListener none;
+    OrderbookListener& listener = state.range(0) ? static_cast<OrderbookListener&>(feed) : none;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        Apply(*book, seed);
+        state.ResumeTiming();
+
+        book->ProcessBatch(flow, listener);
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    done = true;
+    if (consumer.joinable())
+        consumer.join();
+
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+    state.counters["stalls"] = static_cast<double>(feed.Stalls());
+}
+BENCHMARK(BM_MarketByOrderFeed)->ArgName("feed")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Same flow as decoded wire messages with encoded execution reports; range 0: 1 = through
+// OrderEntrySession in 64 KB reads, 0 = commands straight into ProcessBatch with no listener
+static void BM_OrderEntrySession(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 200000;
+
+    OrderFlowGenerator generator{FlowProfile(1)};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(FlowSize);
+
+    std::vector<std::byte> wire(FlowSize * MaxOrderEntryMessageSize);
+    std::size_t size = 0;
+    for (const auto& command : flow)
+        size += EncodeOrderEntry(command, wire.data() + size);
+    wire.resize(size);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        Apply(*book, seed);
+        OrderEntrySession session{*book};
+        state.ResumeTiming();
+
+        if (state.range(0)) {
+            // Socket-sized reads, draining the reports after each as a gateway would
+            std::span<const std::byte> pending{ wire };
+            while (!pending.empty()) {
+                auto consumed = session.Process(pending.first(std::min<std::size_t>(pending.size(), 64 * 1024)));
+                benchmark::DoNotOptimize(session.Reports().data());
+                session.ClearReports();
+                pending = pending.subspan(consumed);
+            }
+        } else {
+            OrderbookListener none;
+            book->ProcessBatch(flow, none);
+        }
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(wire.size()));
+}
+BENCHMARK(BM_OrderEntrySession)->ArgName("wire")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Matcher applies flow and republishes top-10 depth after every command while
+// `readers` threads copy it out in a tight loop; latency should not move with readers
+static void BM_DepthPublishUnderReaders(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 100000;
+
+    OrderFlowGenerator generator{FlowProfile(1)};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(FlowSize);
+
+    DepthPublisher depth{10};
+    std::atomic<bool> done{ false };
+    std::atomic<std::uint64_t> reads{ 0 };
+    std::vector<std::thread> readers;
+    for (std::int64_t i = 0; i < state.range(0); ++i)
+        readers.emplace_back([&] {
+            DepthSnapshot snapshot;
+            std::uint64_t count = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                depth.Read(snapshot);
+                benchmark::DoNotOptimize(snapshot.bids.data());
+                ++count;
+            }
+            reads += count;
+        });
+
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(FlowSize);
+    Trades trades;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        Apply(*book, seed);
+        latencies.clear();
+        state.ResumeTiming();
+
+        for (const auto& command : flow) {
+            auto start = std::chrono::steady_clock::now();
+            book->ProcessBatch({&command, 1}, trades);
+            depth.Publish(*book);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            trades.clear();
+        }
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    done = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+    state.counters["reads_per_s"] = benchmark::Counter(static_cast<double>(reads), benchmark::Counter::kIsRate);
+    ReportLatencies(state, latencies);
+}
+BENCHMARK(BM_DepthPublishUnderReaders)
+    ->ArgName("readers")
+    ->Arg(0)->Arg(1)->Arg(2)->Arg(4)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// ===============================
+//            Journal
+// ===============================
+
+static std::string JournalBenchPath() {
+    return (std::filesystem::temp_directory_path() / "orderbook_bench.journal").string();
+}
+
+// Group-committed appends; range 0 selects fdatasync per commit
+static void BM_JournalAppend(benchmark::State& state) {
+    OrderFlowGenerator generator{OrderFlowConfig{}};
+    auto flow = generator.Generate(100000);
+    JournalWriterOptions options{ .sync = state.range(0) != 0 };
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove(JournalBenchPath());
+        JournalWriter writer{JournalBenchPath(), options};
+        state.ResumeTiming();
+
+        writer.Append(flow);
+        writer.Commit();
+    }
+
+    std::filesystem::remove(JournalBenchPath());
+    state.SetItemsProcessed(state.iterations() * flow.size());
+}
+BENCHMARK(BM_JournalAppend)->ArgName("sync")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Full rebuild of a book from an mmapped journal
+static void BM_JournalReplay(benchmark::State& state) {
+    OrderFlowGenerator generator{OrderFlowConfig{}};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(1000000);
+    {
+        std::filesystem::remove(JournalBenchPath());
+        JournalWriter writer{JournalBenchPath(), JournalWriterOptions{ .sync = false }};
+        writer.Append(seed);
+        writer.Append(flow);
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto book = std::make_unique<Orderbook>();
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(ReplayJournal(JournalBenchPath(), *book));
+
+        state.PauseTiming();
+        book.reset();
+        state.ResumeTiming();
+    }
+
+    std::filesystem::remove(JournalBenchPath());
+    state.SetItemsProcessed(state.iterations() * (seed.size() + flow.size()));
+}
+BENCHMARK(BM_JournalReplay)->Unit(benchmark::kMillisecond);
+
+// ===============================
+//            Pipeline
+// ===============================
+
+// Publishes the last command it has seen events for at the end of each batch
+struct AckStage final : PipelineStage {
+    std::atomic<std::uint64_t> acknowledged{ 0 };
+    std::uint64_t last{ 0 };
+
+    void OnEvent(const PipelineEvent& event) override { last = event.command; }
+    void OnBatchEnd() override { acknowledged.store(last, std::memory_order_release); }
+};
+
+// Range 0: 0 = ProcessBatch into an ExecutionReportEncoder on the caller's thread,
+// 1 = OrderPipeline, 2 = OrderPipeline whose reports wait for an unsynced journal
+class PipelineRun {
+public:
+    explicit PipelineRun(std::int64_t mode)
+        : mode_{ mode },
+          book_{ MakeBook(1) },
+          journal_{ MakeJournal(mode) },
+          pipeline_{ OrderPipelineConfig{ .ladder = LadderConfig{ Mid - 5000, 1, 10000 }, .reserveOrders = 1 << 16 },
+                     journal_ ? &*journal_ : nullptr, { &ack_ } } {
+        if (mode_ != 0)
+            pipeline_.Start();
+    }
+
+    // With waitForReports, returns only once the command's reports can be read downstream
+    void Process(const OrderCommand& command, bool waitForReports) {
+        if (mode_ == 0) {
+            book_.ProcessBatch({ &command, 1 }, encoder_);
+            benchmark::DoNotOptimize(encoder_.Reports().data());
+            encoder_.Clear();
+            return;
+        }
+
+        auto sequence = pipeline_.Submit(command);
+        if (waitForReports)
+            while (ack_.acknowledged.load(std::memory_order_acquire) < sequence)
+                std::this_thread::yield();
+    }
+
+    void WaitIdle() {
+        if (mode_ != 0)
+            pipeline_.WaitIdle();
+    }
+
+    void Stop() { pipeline_.Stop(); }
+
+private:
+    static std::optional<JournalWriter> MakeJournal(std::int64_t mode) {
+        if (mode != 2)
+            return std::nullopt;
+        std::filesystem::remove(JournalBenchPath());
+        return std::optional<JournalWriter>{ std::in_place, JournalBenchPath(), JournalWriterOptions{ .sync = false } };
+    }
+
+    std::int64_t mode_;
+    Orderbook book_;
+    ExecutionReportEncoder encoder_;
+    std::optional<JournalWriter> journal_;
+    AckStage ack_;
+    OrderPipeline pipeline_;
+};
+
+// Time from handing an add over until its execution reports can be read downstream.
+// Adds are timed one at a time; every add is reported, unlike cancels of filled orders
+static void BM_PipelineLatency(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 50000;
+
+    OrderFlowGenerator generator{FlowProfile(1)};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(FlowSize);
+
+    std::vector<std::uint64_t> latencies;
+    latencies.reserve(FlowSize);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto run = std::make_unique<PipelineRun>(state.range(0));
+        for (const auto& command : seed)
+            run->Process(command, false);
+        run->WaitIdle();
+        latencies.clear();
+        state.ResumeTiming();
+
+        for (const auto& command : flow) {
+            bool isAdd = command.type == CommandType::Add;
+            auto start = std::chrono::steady_clock::now();
+            run->Process(command, isAdd);
+            auto end = std::chrono::steady_clock::now();
+            if (isAdd)
+                latencies.push_back(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+
+        state.PauseTiming();
+        run->Stop();
+        run.reset();
+        state.ResumeTiming();
+    }
+
+    std::filesystem::remove(JournalBenchPath());
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+    ReportLatencies(state, latencies);
+}
+BENCHMARK(BM_PipelineLatency)->ArgName("pipeline")->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The same flow submitted without waiting; the stages run behind the caller
+static void BM_PipelineThroughput(benchmark::State& state) {
+    constexpr std::size_t FlowSize = 200000;
+
+    OrderFlowGenerator generator{FlowProfile(1)};
+    auto seed = generator.SeedBook(50, 10);
+    auto flow = generator.Generate(FlowSize);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto run = std::make_unique<PipelineRun>(state.range(0));
+        for (const auto& command : seed)
+            run->Process(command, false);
+        run->WaitIdle();
+        state.ResumeTiming();
+
+        for (const auto& command : flow)
+            run->Process(command, false);
+        run->WaitIdle();
+
+        state.PauseTiming();
+        run->Stop();
+        run.reset();
+        state.ResumeTiming();
+    }
+
+    std::filesystem::remove(JournalBenchPath());
+    state.SetItemsProcessed(state.iterations() * FlowSize);
+}
+BENCHMARK(BM_PipelineThroughput)->ArgName("pipeline")->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// ===============================
+//            Snapshots
+// ===============================
+
+// Range 0: resting orders in the book
+static Orderbook MakeSnapshotBook(std::int64_t orders) {
+    OrderFlowGenerator generator{OrderFlowConfig{}};
+    Orderbook book;
+    Apply(book, generator.SeedBook(100, static_cast<std::size_t>(orders) / 200));
+    return book;
+}
+
+static void BM_SnapshotSave(benchmark::State& state) {
+    auto book = MakeSnapshotBook(state.range(0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(book.SaveSnapshot());
+
+    state.SetItemsProcessed(state.iterations() * book.Size());
+}
+BENCHMARK(BM_SnapshotSave)->ArgName("orders")->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Range 1: 0 = bulk LoadSnapshot, 1 = re-adding every order through AddOrder
+static void BM_SnapshotRestore(benchmark::State& state) {
+    auto book = MakeSnapshotBook(state.range(0));
+    auto snapshot = book.SaveSnapshot();
+
+    std::vector<Order> orders;
+    if (state.range(1)) {
+        OrderFlowGenerator generator{OrderFlowConfig{}};
+        for (const auto& command : generator.SeedBook(100, static_cast<std::size_t>(state.range(0)) / 200))
+            orders.push_back(command.ToOrder());
+    }
+
+    Trades trades;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto restored = std::make_unique<Orderbook>();
+        state.ResumeTiming();
+
+        if (state.range(1))
+            restored->AddOrders(orders, trades);
+        else
+            restored->LoadSnapshot(snapshot);
+
+        state.PauseTiming();
+        restored.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * book.Size());
+}
+BENCHMARK(BM_SnapshotRestore)
+    ->ArgNames({"orders", "replay"})
+    ->ArgsProduct({{10000, 1000000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
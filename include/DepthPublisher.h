@@ -0,0 +1,89 @@
+#pragma once
+#include "OrderbookLevelInfos.h"
+#include "OrderbookFwd.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ * Consistent copy of the top of a book as last published.
+ */
+struct DepthSnapshot {
+    std::uint64_t version{ 0 };  // number of changes published so far
+    LevelInfos bids;             // best first
+    LevelInfos asks;             // best first
+
+    [[nodiscard]] std::optional<LevelInfo> BestBid() const {
+        return bids.empty() ? std::nullopt : std::optional{ bids.front() };
+    }
+    [[nodiscard]] std::optional<LevelInfo> BestAsk() const {
+        return asks.empty() ? std::nullopt : std::optional{ asks.front() };
+    }
+};
+
+/**
+ * Publishes the top `depth` levels of a book to any number of reader threads.
+ *
+ * A single writer (the thread that owns the book) calls Publish after each
+ * command. Readers copy the levels out under a sequence lock: they never block
+ * the writer and never write shared state, so adding readers costs the matcher
+ * nothing beyond the cache misses on the lines it republishes.
+ *
+ * The levels are stored as atomic 64-bit words (price and quantity packed,
+ * then the order count), which keeps the torn reads a seqlock tolerates well-defined.
+ */
+class DepthPublisher {
+public:
+    /**
+     * @throws std::invalid_argument if depth is zero
+     */
+    explicit DepthPublisher(std::size_t depth);
+
+    DepthPublisher(const DepthPublisher&) = delete;
+    DepthPublisher& operator=(const DepthPublisher&) = delete;
+
+    [[nodiscard]] std::size_t Depth() const noexcept { return depth_; }
+
+    /**
+     * Captures the book's current top of book. Writer thread only.
+     * Returns false, and leaves readers undisturbed, if nothing changed.
+     */
+    bool Publish(const Orderbook& book);
+
+    /**
+     * Copies the latest publication into out, retrying while the writer is mid-update.
+     * Does not allocate once out's vectors have grown to Depth().
+     */
+    void Read(DepthSnapshot& out) const;
+
+    /**
+     * Single attempt at Read; returns false if it raced with a publication.
+     */
+    bool TryRead(DepthSnapshot& out) const;
+
+    /**
+     * Version of the latest complete publication; cheap to poll for changes.
+     */
+    [[nodiscard]] std::uint64_t Version() const noexcept {
+        return sequence_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr std::size_t CacheLine = 64;
+
+    std::size_t depth_;
+
+    // Writer-only staging: the words of the next and of the last publication
+    std::vector<LevelInfo> scratch_;
+    std::vector<std::uint64_t> next_;
+    std::vector<std::uint64_t> last_;
+
+    // Odd while a publication is in progress; version = sequence / 2
+    alignas(CacheLine) std::atomic<std::uint64_t> sequence_{ 0 };
+
+    // Word 0 packs the bid and ask counts, then `depth` bid levels, then `depth` ask levels
+    std::unique_ptr<std::atomic<std::uint64_t>[]> words_;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "OrderPool.h"
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Hierarchical timing wheel of the book's expiring (GoodTillDate and Day)
+ * orders, linked through their pool nodes so adding and removing one is O(1)
+ * and never allocates.
+ *
+ * Expiries are kept at full timestamp resolution: eleven levels of 64 slots
+ * cover all 64 bits, and an order sits on the level of the most significant
+ * 6-bit digit in which its expiry differs from the wheel's time, in the slot
+ * for its own digit there. Moving time forward expires everything on the levels
+ * below the highest digit that changed and the slots stepped over on that
+ * level, and spreads the one slot it lands in over the levels below. Occupancy
+ * masks skip empty slots, so Advance costs the orders it expires or moves down
+ * plus a few instructions per level, and an order moves down at most once per
+ * level in its life.
+ */
+class ExpiryWheel {
+public:
+    ExpiryWheel() = default;
+    ExpiryWheel(const ExpiryWheel&) = delete;
+    ExpiryWheel& operator=(const ExpiryWheel&) = delete;
+
+    // The source is left empty at its time: the nodes it linked belong to the new owner
+    ExpiryWheel(ExpiryWheel&& other) noexcept
+        : slots_{ std::exchange(other.slots_, {}) }, occupied_{ std::exchange(other.occupied_, {}) },
+          now_{ other.now_ } { }
+    ExpiryWheel& operator=(ExpiryWheel&& other) noexcept {
+        if (this != &other) {
+            slots_ = std::exchange(other.slots_, {});
+            occupied_ = std::exchange(other.occupied_, {});
+            now_ = other.now_;
+        }
+        return *this;
+    }
+
+    // Time of the last Advance, 0 for a new wheel
+    [[nodiscard]] Timestamp Now() const noexcept { return now_; }
+
+    [[nodiscard]] bool empty() const noexcept;
+
+    /**
+     * Sets the time of an empty wheel, e.g. when a snapshot is loaded.
+     */
+    void Reset(Timestamp now) noexcept;
+
+    // node's order must expire after Now()
+    void Add(OrderNode* node) noexcept;
+
+    // Does nothing for nodes that are not in the wheel
+    void Remove(OrderNode* node) noexcept {
+        if (node->expirySlot != OrderNode::NotExpiring)
+            Unlink(node);
+    }
+
+    /**
+     * Moves the wheel's time forward to now and takes out every order expiring
+     * at or before it, appending them to expired in no particular order.
+     * Does nothing if now is not after Now().
+     */
+    void Advance(Timestamp now, std::vector<OrderNode*>& expired);
+
+private:
+    static constexpr unsigned SlotBits = 6;
+    static constexpr unsigned SlotCount = 1u << SlotBits;
+    static constexpr unsigned LevelCount = (64 + SlotBits - 1) / SlotBits;
+
+    void Unlink(OrderNode* node) noexcept;
+
+    // Empties one slot and returns its list
+    OrderNode* TakeSlot(unsigned level, unsigned digit) noexcept;
+
+    std::array<OrderNode*, LevelCount * SlotCount> slots_{};
+    std::array<std::uint64_t, LevelCount> occupied_{};
+    Timestamp now_{ 0 };
+};
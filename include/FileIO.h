@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+
+/**
+ * Read-only memory map of a whole file, unmapped on destruction.
+ * Empty files map to an empty span.
+ */
+class MappedFile {
+public:
+    /**
+     * @throws std::system_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] std::span<const std::byte> data() const noexcept { return { data_, size_ }; }
+
+private:
+    const std::byte* data_{ nullptr };
+    std::size_t size_{ 0 };
+};
+
+/**
+ * Writes all of bytes to fd, retrying short writes and EINTR.
+ *
+ * @throws std::system_error on failure; `what` names the target in the message
+ */
+void WriteAll(int fd, std::span<const std::byte> bytes, const std::string& what);
+
+/**
+ * Replaces path with bytes atomically: writes and syncs a temporary file next
+ * to it, then renames it over path, so readers see the old or new file, never
+ * a partial one.
+ *
+ * @throws std::system_error on any I/O failure
+ */
+void WriteFileAtomically(const std::string& path, std::span<const std::byte> bytes);
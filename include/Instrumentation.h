@@ -0,0 +1,211 @@
+#pragma once
+#include "LatencyHistogram.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * Hot-path instrumentation for Orderbook, switched at compile time with the
+ * ORDERBOOK_INSTRUMENTATION CMake option (off by default).
+ *
+ * When it is off the ORDERBOOK_COUNT / ORDERBOOK_TIME_SECTION hooks expand to
+ * nothing and the book compiles to the same code as without them. When it is
+ * on, each thread that runs a book records into its own cache-line aligned
+ * block: counters are relaxed atomics written only by their thread (a plain
+ * load and store, no locked instruction), and the timed sections record
+ * rdtsc cycles into per-thread histograms. TakeInstrumentationSnapshot sums
+ * every thread's block from any thread.
+ *
+ * Counters cost next to nothing; the two cycle-counter reads around a timed
+ * section are most of the overhead, so sections can be sampled instead of
+ * timed on every call (SetInstrumentationSamplePeriod).
+ */
+#ifndef ORDERBOOK_INSTRUMENTATION
+#define ORDERBOOK_INSTRUMENTATION 0
+#endif
+
+inline constexpr bool InstrumentationEnabled = ORDERBOOK_INSTRUMENTATION != 0;
+
+enum class InstrumentationCounter : std::size_t {
+    Adds,
+    Cancels,
+    Modifies,
+    Fills,
+    RejectedFillAndKill,
+    RejectedFillOrKill,
+    RejectedPostOnly,
+    StopTriggers,
+    StopCascades,
+    SelfTradesPrevented,
+    IcebergReplenishments,
+    OrdersExpired,
+    LevelsCreated,
+    LevelsDestroyed,
+    Count
+};
+
+enum class InstrumentationSection : std::size_t {
+    MatchAggressiveOrder,
+    CancelOrder,
+    CheckAndTriggerStopOrders,
+    Count
+};
+
+/**
+ * Totals across every thread that has run a book, since process start.
+ * Cycle histograms are at LatencyHistogram precision, including their
+ * minimum, maximum and mean.
+ */
+struct InstrumentationSnapshot {
+    std::uint64_t adds{ 0 };
+    std::uint64_t cancels{ 0 };
+    std::uint64_t modifies{ 0 };
+    std::uint64_t fills{ 0 };
+    std::uint64_t rejectedFillAndKill{ 0 };
+    std::uint64_t rejectedFillOrKill{ 0 };
+    std::uint64_t rejectedPostOnly{ 0 };
+    std::uint64_t stopTriggers{ 0 };
+    std::uint64_t stopCascades{ 0 };      // trades that triggered at least one stop
+    std::uint64_t maxCascadeDepth{ 0 };   // most generations of stops one trade set off
+    std::uint64_t selfTradesPrevented{ 0 };
+    std::uint64_t icebergReplenishments{ 0 };
+    std::uint64_t ordersExpired{ 0 };
+    std::uint64_t levelsCreated{ 0 };
+    std::uint64_t levelsDestroyed{ 0 };
+
+    LatencyHistogram matchCycles;
+    LatencyHistogram cancelCycles;
+    LatencyHistogram stopTriggerCycles;
+
+    std::size_t threads{ 0 };
+};
+
+/**
+ * Sums every thread's counters. Safe to call from any thread while books run;
+ * each counter is read atomically, but the set is not one instant's view.
+ * Returns an empty snapshot when instrumentation is compiled out.
+ */
+InstrumentationSnapshot TakeInstrumentationSnapshot();
+
+/**
+ * Times one in every `period` calls of each section, per thread; 1 (the
+ * default) times every call. Counters are unaffected.
+ *
+ * @throws std::invalid_argument if period is zero
+ */
+void SetInstrumentationSamplePeriod(std::uint32_t period);
+
+/**
+ * Cycle counter for timing short sections: rdtsc on x86, steady_clock
+ * nanoseconds elsewhere.
+ */
+inline std::uint64_t ReadCycleCounter() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+namespace instrumentation {
+    extern std::atomic<std::uint32_t> samplePeriod;
+
+    // Single-writer cell: the owning thread increments without a locked instruction
+    struct Cell {
+        std::atomic<std::uint64_t> value{ 0 };
+
+        void Add(std::uint64_t amount) noexcept {
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+        void Max(std::uint64_t candidate) noexcept {
+            if (candidate > value.load(std::memory_order_relaxed))
+                value.store(candidate, std::memory_order_relaxed);
+        }
+        [[nodiscard]] std::uint64_t Load() const noexcept { return value.load(std::memory_order_relaxed); }
+    };
+
+    // One thread's block. Allocated separately and aligned so no two threads
+    // share a cache line; never freed, so counts from finished threads remain.
+    struct alignas(64) ThreadBlock {
+        std::array<Cell, static_cast<std::size_t>(InstrumentationCounter::Count)> counters;
+        Cell maxCascadeDepth;
+        std::array<std::array<Cell, LatencyHistogram::BucketCount>,
+                   static_cast<std::size_t>(InstrumentationSection::Count)> cycles;
+
+        void Count(InstrumentationCounter counter, std::uint64_t amount = 1) noexcept {
+            counters[static_cast<std::size_t>(counter)].Add(amount);
+        }
+        void RecordCycles(InstrumentationSection section, std::uint64_t cycles) noexcept {
+            this->cycles[static_cast<std::size_t>(section)][LatencyHistogram::BucketIndex(cycles)].Add(1);
+        }
+
+        bool ShouldSample(InstrumentationSection section) noexcept {
+            auto& countdown = untilSample[static_cast<std::size_t>(section)];
+            if (countdown > 1) {
+                --countdown;
+                return false;
+            }
+            countdown = samplePeriod.load(std::memory_order_relaxed);
+            return true;
+        }
+
+        // Owner-only: calls left before the next timed one
+        std::array<std::uint32_t, static_cast<std::size_t>(InstrumentationSection::Count)> untilSample{};
+    };
+
+    ThreadBlock* RegisterThread();
+
+    inline ThreadBlock& Local() noexcept {
+        thread_local ThreadBlock* block = RegisterThread();
+        return *block;
+    }
+
+    class ScopedCycleTimer {
+    public:
+        explicit ScopedCycleTimer(InstrumentationSection section) noexcept
+            : block_{ Local() }, section_{ section } {
+            if (block_.ShouldSample(section))
+                start_ = ReadCycleCounter();
+        }
+        ~ScopedCycleTimer() {
+            if (start_ != 0)
+                block_.RecordCycles(section_, ReadCycleCounter() - start_);
+        }
+
+        ScopedCycleTimer(const ScopedCycleTimer&) = delete;
+        ScopedCycleTimer& operator=(const ScopedCycleTimer&) = delete;
+
+    private:
+        ThreadBlock& block_;
+        InstrumentationSection section_;
+        std::uint64_t start_{ 0 };   // 0 when this call is not sampled
+    };
+
+    // Stands in for ScopedCycleTimer in books that leave instrumentation out
+    struct UntimedSection {
+        explicit UntimedSection(InstrumentationSection) noexcept { }
+    };
+}
+
+// The hooks are used inside BasicOrderbook and read its Instrumented switch, so a
+// book whose policy turns instrumentation off compiles them out in any build
+#if ORDERBOOK_INSTRUMENTATION
+#define ORDERBOOK_COUNT(counter, ...)                                                                     \
+    do {                                                                                                  \
+        if constexpr (Instrumented)                                                                       \
+            ::instrumentation::Local().Count(InstrumentationCounter::counter __VA_OPT__(,) __VA_ARGS__); \
+    } while (false)
+#define ORDERBOOK_TIME_SECTION(section)                                                                     \
+    std::conditional_t<Instrumented, ::instrumentation::ScopedCycleTimer, ::instrumentation::UntimedSection> \
+        orderbookSectionTimer{ InstrumentationSection::section }
+#else
+#define ORDERBOOK_COUNT(counter, ...) ((void)0)
+#define ORDERBOOK_TIME_SECTION(section) ((void)0)
+#endif
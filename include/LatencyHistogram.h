@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * Log-linear histogram in the style of HdrHistogram, for latencies in any
+ * unit (usually nanoseconds).
+ *
+ * Values below 256 get a bucket each. Above that every power of two is split
+ * into 128 equal sub-buckets, so any value is reported to within 1/128
+ * (< 0.8%) of what was recorded, over the full 64-bit range. Recording is an
+ * index computation and an increment: no allocation and no search.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SubBucketBits = 7;
+    static constexpr std::size_t SubBuckets = std::size_t{ 1 } << SubBucketBits;
+    static constexpr std::size_t BucketCount = (64 - SubBucketBits) * SubBuckets + SubBuckets;
+
+    // Below 2 * SubBuckets the index is the value; each higher power of two
+    // adds SubBuckets buckets, each 2^exponent wide
+    static std::size_t BucketIndex(std::uint64_t value) noexcept {
+        auto width = std::max<unsigned>(static_cast<unsigned>(std::bit_width(value)), SubBucketBits + 1);
+        auto exponent = width - SubBucketBits - 1;
+        return (static_cast<std::size_t>(exponent) << SubBucketBits) + static_cast<std::size_t>(value >> exponent);
+    }
+
+    // Largest value that lands in bucket index
+    static std::uint64_t BucketHighestValue(std::size_t index) noexcept;
+
+    void Record(std::uint64_t value) noexcept {
+        ++counts_[BucketIndex(value)];
+        ++count_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    // Records value count times, e.g. when folding in counts kept per bucket elsewhere
+    void Record(std::uint64_t value, std::uint64_t count) noexcept {
+        if (count == 0)
+            return;
+        counts_[BucketIndex(value)] += count;
+        count_ += count;
+        sum_ += value * count;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    // Adds other's recordings to this one
+    void Merge(const LatencyHistogram& other) noexcept;
+    void Reset() noexcept;
+
+    [[nodiscard]] std::uint64_t Count() const noexcept { return count_; }
+    [[nodiscard]] std::uint64_t Min() const noexcept { return count_ ? min_ : 0; }
+    [[nodiscard]] std::uint64_t Max() const noexcept { return max_; }
+    [[nodiscard]] double Mean() const noexcept { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    /**
+     * Smallest recorded value such that `percentile` percent of recordings are
+     * at or below it, to the histogram's precision. 0 when empty.
+     *
+     * @param percentile In [0, 100]; 100 gives Max()
+     */
+    [[nodiscard]] std::uint64_t ValueAtPercentile(double percentile) const noexcept;
+
+private:
+    std::array<std::uint64_t, BucketCount> counts_{};
+    std::uint64_t count_{ 0 };
+    std::uint64_t sum_{ 0 };
+    std::uint64_t min_{ std::numeric_limits<std::uint64_t>::max() };
+    std::uint64_t max_{ 0 };
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include "OrderbookListener.h"
+#include "SpscQueue.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * Market-by-order (L3) message types, ITCH style. Every message names one
+ * visible resting order; aggressive orders only appear once they rest.
+ * Icebergs show only their displayed peak: executions that use a peak up take
+ * the order to zero, and the refilled peak arrives as a new Add at the back
+ * of the level.
+ */
+enum class MarketByOrderType : std::uint8_t {
+    Add = 'A',      // order rested or an iceberg refilled; quantity is what is displayed
+    Execute = 'E',  // resting order traded; quantity and price are the fill
+    Reduce = 'X',   // resting order shrunk in place; quantity is what remains displayed
+    Delete = 'D'    // resting order cancelled
+};
+
+/**
+ * Fixed 32-byte little-endian wire layout:
+ *
+ *   u8 type | u8 side | 2 pad | u32 quantity | u64 sequence | u64 order ID | i32 price | 4 pad
+ *
+ * Sequence numbers are per feed and start at 1.
+ */
+inline constexpr std::size_t MarketByOrderMessageSize = 32;
+
+struct MarketByOrderMessage {
+    std::uint64_t sequence{ 0 };
+    MarketByOrderType type{ MarketByOrderType::Add };
+    Side side{ Side::Buy };
+    OrderID orderID{ 0 };
+    Price price{ 0 };
+    Quantity quantity{ 0 };
+
+    bool operator==(const MarketByOrderMessage&) const = default;
+};
+
+/**
+ * Decodes one wire message.
+ *
+ * @throws std::runtime_error on an unknown type or side
+ */
+MarketByOrderMessage DecodeMarketByOrder(const std::byte* in);
+
+/**
+ * Listener that encodes a book's order-level events into a preallocated ring
+ * of wire messages. Encoding is a handful of stores per event: no allocation
+ * and no formatting on the matching thread.
+ *
+ * One thread (the book's) produces; one other thread drains with Read or
+ * Flush. If the ring is full the producer waits for the consumer rather than
+ * dropping messages; Stalls() counts how often that happened.
+ */
+class MarketByOrderFeed final : public OrderbookListener {
+public:
+    /**
+     * @param capacity Ring size in messages, rounded up to a power of two
+     */
+    explicit MarketByOrderFeed(std::size_t capacity);
+
+    // Producer side (the matching thread)
+    void OnOrderAccepted(const Order& order) override;
+    void OnStopTriggered(const Order& order) override;
+    void OnTrade(const Trade& trade) override;
+    void OnOrderRested(const Order& order) override;
+    void OnOrderReduced(const Order& order) override;
+    void OnOrderReplenished(const Order& order) override;
+    void OnOrderCancelled(const Order& order) override;
+    void OnUncross(const AuctionIndication& uncross) override;
+
+    /**
+     * Consumer: moves as many whole messages as fit into out.
+     * Returns the number of bytes written.
+     */
+    std::size_t Read(std::span<std::byte> out);
+
+    /**
+     * Consumer: writes every queued message to fd.
+     * Returns the number of messages written.
+     *
+     * @throws std::system_error if the write fails
+     */
+    std::size_t Flush(int fd);
+
+    [[nodiscard]] std::uint64_t Stalls() const noexcept { return stalls_.load(std::memory_order_relaxed); }
+
+private:
+    using Message = std::array<std::byte, MarketByOrderMessageSize>;
+
+    void Publish(MarketByOrderType type, Side side, OrderID orderID, Price price, Quantity quantity);
+
+    SpscQueue<Message> ring_;
+
+    // Producer-only state
+    std::uint64_t sequence_{ 0 };
+    OrderID aggressor_{ 0 };  // order whose trades are being reported; 0 during an uncross
+    OrderID incoming_{ 0 };   // the current command's order until it rests
+
+    std::atomic<std::uint64_t> stalls_{ 0 };
+};
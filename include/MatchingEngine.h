@@ -0,0 +1,135 @@
+#pragma once
+#include "DepthPublisher.h"
+#include "Orderbook.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct MatchingEngineConfig {
+    std::size_t workerCount{ 1 };
+    std::size_t queueCapacity{ 1 << 16 };  // per worker, rounded up to a power of two
+
+    // Pin worker i to CPU firstCore + i (Linux only, ignored elsewhere)
+    bool pinThreads{ false };
+    std::size_t firstCore{ 0 };
+};
+
+/**
+ * Multi-instrument engine: one Orderbook per instrument, sharded over workers.
+ *
+ * Each instrument is assigned to exactly one worker thread, which owns its book
+ * outright, so books are never shared and need no locks. Commands reach a
+ * worker through its own lock-free SPSC queue, which preserves per-book order.
+ * Independent instruments on different workers match in parallel.
+ *
+ * Threading contract:
+ * - AddInstrument must be called before Start.
+ * - Submit/TrySubmit must all be called from one producer thread.
+ * - Listeners are invoked on the owning worker thread.
+ * - GetBook may only be used while the engine is stopped or after WaitIdle.
+ * - DepthPublishers may be read from any thread at any time.
+ */
+class MatchingEngine {
+public:
+    explicit MatchingEngine(const MatchingEngineConfig& config = {});
+    ~MatchingEngine();
+
+    MatchingEngine(const MatchingEngine&) = delete;
+    MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+    /**
+     * Registers an instrument and assigns it to the least loaded worker.
+     *
+     * @param listener Receives this book's events on its worker thread; may be null
+     * @param depth Republished by the worker after every command; may be null
+     * @param session Session schedule for the book's Day orders; none if not given
+     * @throws std::invalid_argument if the instrument exists, the engine is
+     *         running or the session length is zero
+     */
+    void AddInstrument(InstrumentID instrument, std::optional<LadderConfig> ladder = std::nullopt,
+                       OrderbookListener* listener = nullptr, DepthPublisher* depth = nullptr,
+                       std::optional<SessionSchedule> session = std::nullopt);
+
+    void Start();
+
+    /**
+     * Processes everything already queued, then joins the workers.
+     */
+    void Stop();
+
+    /**
+     * Queues a command for an instrument, spinning while its worker's queue is full.
+     * Only a running engine drains the queues, so Submit refuses to wait on a stopped one.
+     *
+     * @throws std::invalid_argument if the instrument is unknown
+     * @throws std::logic_error if the engine is not running
+     */
+    void Submit(InstrumentID instrument, const OrderCommand& command);
+
+    /**
+     * Queues a command unless the worker's queue is full. Never blocks, so it
+     * may also queue commands before Start; they are processed once it runs.
+     *
+     * @throws std::invalid_argument if the instrument is unknown
+     */
+    bool TrySubmit(InstrumentID instrument, const OrderCommand& command);
+
+    /**
+     * Blocks the producer until every submitted command has been processed.
+     *
+     * @throws std::logic_error if commands are queued but the engine is not running
+     */
+    void WaitIdle() const;
+
+    [[nodiscard]] std::size_t WorkerCount() const noexcept { return workers_.size(); }
+    [[nodiscard]] std::size_t WorkerFor(InstrumentID instrument) const;
+
+    Orderbook& GetBook(InstrumentID instrument);
+
+    /**
+     * Number of commands that threw during processing (e.g. failed validation).
+     */
+    [[nodiscard]] std::uint64_t FailedCommands() const noexcept;
+
+private:
+    struct Book {
+        Orderbook orderbook;
+        OrderbookListener* listener;
+        DepthPublisher* depth;
+    };
+
+    struct Route {
+        std::size_t worker;
+        Book* book;
+    };
+
+    struct Task {
+        Book* book;
+        OrderCommand command;
+    };
+
+    struct Worker {
+        explicit Worker(std::size_t capacity) : queue{ capacity } { }
+
+        SpscQueue<Task> queue;
+        std::thread thread;
+        std::vector<std::unique_ptr<Book>> books;
+
+        std::uint64_t submitted{ 0 };           // producer only
+        std::atomic<std::uint64_t> processed{ 0 };
+        std::atomic<std::uint64_t> failed{ 0 };
+    };
+
+    void Run(Worker& worker, std::size_t core);
+    const Route& RouteFor(InstrumentID instrument) const;
+
+    MatchingEngineConfig config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::unordered_map<InstrumentID, Route> routes_;
+    std::atomic<bool> running_{ false };
+};
@@ -8,7 +8,15 @@
 class Order{
 public:
 
-    Order(OrderType orderType, OrderID orderID, Side side, Price price, Quantity quantity, std::optional<Price> stopPrice = std::nullopt);
+    /**
+     * @param peak Non-zero makes a resting order an iceberg: only up to peak of
+     *             its remaining quantity is displayed, the rest is a hidden reserve
+     * @param expiry When a GoodTillDate order expires on the book's clock; Day
+     *               orders left at 0 are given the book's next session close
+     */
+    Order(OrderType orderType, OrderID orderID, Side side, Price price, Quantity quantity,
+          std::optional<Price> stopPrice = std::nullopt, OwnerID owner = NoOwner, Quantity peak = 0,
+          Timestamp expiry = 0);
 
     // Getters
     [[nodisacrd]] OrderID GetOrderID() const noexcept { return orderID_; }
@@ -16,24 +24,79 @@ public:
     [[nodiscard]] Price GetPrice() const noexcept { return price_; }
     [[nodiscard]] std::optional<Price> GetStopPrice() const noexcept { return stopPrice_; }
     [[nodiscard]] OrderType GetOrderType() const noexcept { return orderType_; }
+    [[nodiscard]] OwnerID GetOwner() const noexcept { return owner_; }
     [[nodiscard]] Quantity GetInitialQuantity() const noexcept { return initialQuantity_; }
     [[nodiscard]] Quantity GetRemainingQuantity() const noexcept { return remainingQuantity_; }
     [[nodiscard]] Quantity GetFilledQuantity() const noexcept { return GetInitialQuantity() - GetRemainingQuantity(); }
 
+    // Iceberg peak, 0 for fully displayed orders
+    [[nodiscard]] Quantity GetPeakQuantity() const noexcept { return peakQuantity_; }
+    [[nodiscard]] bool IsIceberg() const noexcept { return peakQuantity_ != 0; }
+
+    // Displayed part of the remaining quantity; all of it unless the order is an iceberg
+    [[nodiscard]] Quantity GetVisibleQuantity() const noexcept { return visibleQuantity_; }
+    [[nodiscard]] Quantity GetHiddenQuantity() const noexcept { return remainingQuantity_ - visibleQuantity_; }
+
+    // Expiry of a GoodTillDate or Day order, 0 for orders that never expire
+    [[nodiscard]] Timestamp GetExpiry() const noexcept { return expiry_; }
+
 
     [[nodiscard]] bool IsFilled() const noexcept;
     [[nodiscard]] bool IsStopOrder() const noexcept;
 
+    // Whether an unfilled remainder joins the book (GTC, PostOnly, GTD and Day) rather than being cancelled.
+    // Stops never rest: a triggered stop's remainder is cancelled.
+    [[nodiscard]] bool CanRest() const noexcept;
+
+    // GoodTillDate and Day orders, which leave the book at their expiry
+    [[nodiscard]] bool CanExpire() const noexcept;
+
+    /**
+     * Checks what makes an order invalid in any book, whatever its state.
+     *
+     * @throws std::invalid_argument on zero quantity, a negative price, an
+     *         iceberg that cannot rest, a GoodTillDate order without an expiry
+     *         or an expiry on any other type
+     */
+    void Validate() const;
+
     void Fill(Quantity quantity);
-    
+
+    /**
+     * Shrinks the order by quantity without filling it.
+     * Filled quantity is unchanged; initial and remaining both go down.
+     */
+    void Reduce(Quantity quantity);
+
+    /**
+     * Displays a fresh peak from the hidden reserve (the whole remainder for
+     * orders that are not icebergs). Called when an order rests and when a
+     * resting iceberg's displayed quantity is used up.
+     */
+    void Replenish() noexcept;
+
+    /**
+     * Restores a saved displayed quantity, e.g. from a snapshot.
+     *
+     * @throws std::logic_error if it is zero, above the peak or above the remaining quantity
+     */
+    void SetVisibleQuantity(Quantity quantity);
+
+    // Stamped by the book on Day orders when they are accepted
+    void SetExpiry(Timestamp expiry) noexcept { expiry_ = expiry; }
+
 private:
     OrderType orderType_;
+    OwnerID owner_;  // fills the padding before orderID_
     OrderID orderID_;
     Side side_;
     Price price_;
     std::optional<Price> stopPrice_;
     Quantity initialQuantity_;
     Quantity remainingQuantity_;
+    Quantity peakQuantity_;
+    Quantity visibleQuantity_;
+    Timestamp expiry_;
 };
 
 using OrderPointer = std::shared_ptr<Order>;
@@ -0,0 +1,83 @@
+#pragma once
+#include "Order.h"
+#include "OrderModify.h"
+#include <optional>
+
+enum class CommandType {
+    Add,
+    Cancel,
+    Modify,
+    AdvanceTime,
+    StartAuction,
+    Uncross
+};
+
+/**
+ * One inbound instruction for the book: add, cancel, modify, a move of its
+ * clock, or the start or uncross of a call auction.
+ * Plain value type so batches can be built in reusable buffers.
+ * Fields that a command type does not use are ignored.
+ */
+struct OrderCommand {
+    CommandType type{ CommandType::Add };
+    OrderType orderType{ OrderType::GoodTillCancel };
+    OrderID orderID{ 0 };
+    Side side{ Side::Buy };
+    Price price{ 0 };    // limit price, or the reference price of a StartAuction
+    Quantity quantity{ 0 };
+    std::optional<Price> stopPrice;
+    OwnerID owner{ NoOwner };
+    Quantity peak{ 0 };  // iceberg peak, 0 for fully displayed
+    Timestamp time{ 0 }; // GoodTillDate expiry of an add, new book time of an AdvanceTime
+
+    static OrderCommand Add(OrderType orderType, OrderID orderID, Side side, Price price,
+                            Quantity quantity, std::optional<Price> stopPrice = std::nullopt,
+                            OwnerID owner = NoOwner, Quantity peak = 0, Timestamp expiry = 0) {
+        return { CommandType::Add, orderType, orderID, side, price, quantity, stopPrice, owner, peak, expiry };
+    }
+
+    static OrderCommand Cancel(OrderID orderID) {
+        OrderCommand command;
+        command.type = CommandType::Cancel;
+        command.orderID = orderID;
+        return command;
+    }
+
+    static OrderCommand Modify(const OrderModify& modify) {
+        OrderCommand command;
+        command.type = CommandType::Modify;
+        command.orderID = modify.GetOrderID();
+        command.side = modify.GetSide();
+        command.price = modify.GetPrice();
+        command.quantity = modify.GetQuantity();
+        return command;
+    }
+
+    static OrderCommand AdvanceTime(Timestamp now) {
+        OrderCommand command;
+        command.type = CommandType::AdvanceTime;
+        command.time = now;
+        return command;
+    }
+
+    static OrderCommand StartAuction(Price referencePrice) {
+        OrderCommand command;
+        command.type = CommandType::StartAuction;
+        command.price = referencePrice;
+        return command;
+    }
+
+    static OrderCommand Uncross() {
+        OrderCommand command;
+        command.type = CommandType::Uncross;
+        return command;
+    }
+
+    [[nodiscard]] Order ToOrder() const {
+        return Order{ orderType, orderID, side, price, quantity, stopPrice, owner, peak, time };
+    }
+
+    [[nodiscard]] OrderModify ToModify() const {
+        return OrderModify{ orderID, side, price, quantity };
+    }
+};
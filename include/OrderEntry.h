@@ -0,0 +1,283 @@
+#pragma once
+#include "OrderCommand.h"
+#include "OrderbookListener.h"
+#include "WireFormat.h"
+#include "OrderbookFwd.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Binary order-entry protocol.
+ *
+ * Inbound messages are little-endian with a length implied by their type byte:
+ *
+ *   new     (32)  u8 'N' | u8 order type | u8 side | u8 extra | u32 quantity |
+ *                 u64 order ID | i32 price | i32 stop price or u32 peak | u64 expiry
+ *
+ *                 extra is 0 for neither, 1 for a stop price, 2 for an iceberg peak;
+ *                 stops cannot be icebergs, so the two share a field. expiry is
+ *                 a GoodTillDate order's, 0 for every other type.
+ *   cancel  (16)  u8 'C' | 7 pad | u64 order ID
+ *   modify  (24)  u8 'M' | u8 side | 2 pad | u32 quantity | u64 order ID | i32 price | 4 pad
+ *
+ * Execution reports going back out are fixed 32-byte records:
+ *
+ *   u8 type | u8 side | u8 reject reason | 1 pad | u32 quantity | u64 order ID |
+ *   i32 price | u32 owner | u64 report sequence
+ *
+ * owner is the owner of the order the report is about; a fill carries its own
+ * side's owner, so fills can be routed to each side's participant.
+ */
+enum class OrderEntryType : std::uint8_t {
+    New = 'N',
+    Cancel = 'C',
+    Modify = 'M'
+};
+
+inline constexpr std::size_t NewOrderMessageSize = 32;
+inline constexpr std::size_t CancelOrderMessageSize = 16;
+inline constexpr std::size_t ModifyOrderMessageSize = 24;
+inline constexpr std::size_t MaxOrderEntryMessageSize = 32;
+
+/**
+ * Zero-copy view of one validated inbound message. Fields are loaded straight
+ * from the underlying bytes on access, which must outlive the view.
+ */
+class OrderEntryMessage {
+public:
+    OrderEntryMessage() = default;
+    explicit OrderEntryMessage(const std::byte* data) : data_{ data } { }
+
+    [[nodiscard]] OrderEntryType GetType() const noexcept { return static_cast<OrderEntryType>(data_[0]); }
+    [[nodiscard]] std::size_t Size() const noexcept;
+
+    [[nodiscard]] OrderID GetOrderID() const noexcept { return LoadLE<OrderID>(data_ + 8); }
+    [[nodiscard]] Side GetSide() const noexcept {
+        return static_cast<Side>(data_[GetType() == OrderEntryType::New ? 2 : 1]);
+    }
+    [[nodiscard]] Quantity GetQuantity() const noexcept { return LoadLE<Quantity>(data_ + 4); }
+    [[nodiscard]] Price GetPrice() const noexcept { return LoadLE<Price>(data_ + 16); }
+
+    // New orders only
+    [[nodiscard]] OrderType GetOrderType() const noexcept { return static_cast<OrderType>(data_[1]); }
+    [[nodiscard]] std::optional<Price> GetStopPrice() const noexcept;
+    [[nodiscard]] Quantity GetPeakQuantity() const noexcept;
+    [[nodiscard]] Timestamp GetExpiry() const noexcept { return LoadLE<Timestamp>(data_ + 24); }
+
+    [[nodiscard]] OrderCommand ToCommand() const;
+
+private:
+    const std::byte* data_{ nullptr };
+};
+
+/**
+ * Walks the complete messages at the front of a byte buffer without copying.
+ * A trailing partial message is left unconsumed so a stream reader can
+ * complete it with the next read.
+ */
+class OrderEntryReader {
+public:
+    explicit OrderEntryReader(std::span<const std::byte> buffer) : buffer_{ buffer } { }
+
+    /**
+     * Views the next complete message. Returns false if none is left.
+     *
+     * @throws std::runtime_error on an unknown message type or an out-of-range
+     *         order type, side or flag; nothing after it is consumed
+     */
+    bool Next(OrderEntryMessage& message);
+
+    // Bytes taken by the messages returned so far
+    [[nodiscard]] std::size_t Consumed() const noexcept { return offset_; }
+
+private:
+    std::span<const std::byte> buffer_;
+    std::size_t offset_{ 0 };
+};
+
+/**
+ * Encodes command as an inbound message into out, which must have room for
+ * MaxOrderEntryMessageSize bytes. Returns the message size.
+ *
+ * @throws std::invalid_argument for an add with both a stop price and a peak,
+ *         or an AdvanceTime, StartAuction or Uncross, which clients cannot send
+ */
+std::size_t EncodeOrderEntry(const OrderCommand& command, std::byte* out);
+
+enum class ExecutionReportType : std::uint8_t {
+    Accepted = 'A',
+    Rejected = 'R',
+    Fill = 'F',        // one per side of every trade
+    Cancelled = 'C',
+    Reduced = 'X',     // quantity is what remains
+    Triggered = 'T'
+};
+
+inline constexpr std::size_t ExecutionReportSize = 32;
+
+// Reject reason byte for a message the book refused outright (zero quantity, negative price);
+// other rejects carry their RejectReason
+inline constexpr std::uint8_t InvalidOrderReason = 0xFF;
+
+// Reject reason byte for a cancel or modify of an order another session owns
+inline constexpr std::uint8_t NotOwnerReason = 0xFE;
+
+struct ExecutionReport {
+    std::uint64_t sequence{ 0 };
+    ExecutionReportType type{ ExecutionReportType::Accepted };
+    Side side{ Side::Buy };
+    std::uint8_t reason{ 0 };
+    OrderID orderID{ 0 };
+    Price price{ 0 };
+    Quantity quantity{ 0 };
+    OwnerID owner{ NoOwner };
+
+    bool operator==(const ExecutionReport&) const = default;
+};
+
+/**
+ * Writes report into out, which must have room for ExecutionReportSize bytes.
+ */
+void EncodeExecutionReport(const ExecutionReport& report, std::byte* out) noexcept;
+
+/**
+ * @throws std::runtime_error on an unknown report type or side
+ */
+ExecutionReport DecodeExecutionReport(const std::byte* in);
+
+/**
+ * Listener that turns each book event into execution reports, numbered from 1,
+ * and hands them to Emit: one per event, two (buy side first) per trade.
+ */
+class ExecutionReportBuilder : public OrderbookListener {
+public:
+    void OnOrderAccepted(const Order& order) override;
+    void OnOrderRejected(const Order& order, RejectReason reason) override;
+    void OnTrade(const Trade& trade) override;
+    void OnOrderCancelled(const Order& order) override;
+    void OnOrderReduced(const Order& order) override;
+    void OnStopTriggered(const Order& order) override;
+
+    // Reports one side of a trade; OnTrade is OnFill for the buy side, then the sell side
+    void OnFill(Side side, const TradeInfo& fill);
+
+    // Reports a message the book threw on, or that was refused before reaching it
+    void RejectInvalid(const OrderCommand& command, std::uint8_t reason = InvalidOrderReason);
+
+protected:
+    virtual void Emit(const ExecutionReport& report) = 0;
+
+private:
+    void Build(ExecutionReportType type, Side side, OrderID orderID, Price price, Quantity quantity,
+               OwnerID owner, std::uint8_t reason = 0);
+
+    std::uint64_t sequence_{ 0 };
+};
+
+/**
+ * Builder that appends each report, encoded, to its buffer.
+ * Clear keeps the capacity, so once the buffer has grown to a batch's worth
+ * of reports, encoding does not allocate.
+ */
+class ExecutionReportEncoder final : public ExecutionReportBuilder {
+public:
+    // Encoded reports since the last Clear
+    [[nodiscard]] std::span<const std::byte> Reports() const noexcept { return buffer_; }
+    void Clear() noexcept { buffer_.clear(); }
+
+protected:
+    void Emit(const ExecutionReport& report) override;
+
+private:
+    std::vector<std::byte> buffer_;
+};
+
+class OrderEntrySession;
+
+/**
+ * Listener for a book that several sessions share. Each event goes to the
+ * session that owns its order and each side of a trade to its own owner's
+ * session, so a resting order's owner hears of its fills and the aggressor
+ * never sees the other side. Events for orders no session owns are dropped.
+ * Sessions register themselves on construction and must not outlive it.
+ */
+class ExecutionReportRouter final : public OrderbookListener {
+public:
+    explicit ExecutionReportRouter(Orderbook& book) : book_{ book } { }
+    ExecutionReportRouter(const ExecutionReportRouter&) = delete;
+    ExecutionReportRouter& operator=(const ExecutionReportRouter&) = delete;
+
+    [[nodiscard]] Orderbook& GetBook() const noexcept { return book_; }
+
+    void OnOrderAccepted(const Order& order) override;
+    void OnOrderRejected(const Order& order, RejectReason reason) override;
+    void OnTrade(const Trade& trade) override;
+    void OnOrderCancelled(const Order& order) override;
+    void OnOrderReduced(const Order& order) override;
+    void OnStopTriggered(const Order& order) override;
+
+private:
+    friend class OrderEntrySession;
+
+    // Returns the owner's reports, or nullptr if no session has registered it
+    ExecutionReportBuilder* Find(OwnerID owner) const noexcept;
+
+    Orderbook& book_;
+    std::unordered_map<OwnerID, ExecutionReportBuilder*> sessions_;
+};
+
+/**
+ * Decodes inbound messages, applies them to a book in order and encodes the
+ * resulting execution reports.
+ */
+class OrderEntrySession {
+public:
+    /**
+     * A session with the book to itself: it reports every event, including
+     * both sides of each trade.
+     *
+     * @param owner Stamped on every order the session enters, so self-trade
+     *              prevention applies across a participant's messages. Cancels
+     *              and modifies of orders with another owner are rejected with
+     *              NotOwnerReason and never reach the book.
+     */
+    explicit OrderEntrySession(Orderbook& book, OwnerID owner = NoOwner);
+
+    /**
+     * A session on router's book, which it shares with the router's other
+     * sessions. It reports only events on its own orders, including fills of
+     * its resting orders caused by other sessions' messages.
+     *
+     * @throws std::invalid_argument if owner is NoOwner or already has a session
+     */
+    OrderEntrySession(ExecutionReportRouter& router, OwnerID owner);
+    ~OrderEntrySession();
+
+    OrderEntrySession(const OrderEntrySession&) = delete;
+    OrderEntrySession& operator=(const OrderEntrySession&) = delete;
+
+    /**
+     * Applies every complete message in input and encodes their reports.
+     * Returns the bytes consumed; the caller keeps any partial tail.
+     *
+     * @throws std::runtime_error on a malformed message; messages before it
+     *         have been applied and reported
+     */
+    std::size_t Process(std::span<const std::byte> input);
+
+    // Reports accumulated since the last ClearReports, in event order
+    [[nodiscard]] std::span<const std::byte> Reports() const noexcept { return encoder_.Reports(); }
+    void ClearReports() noexcept { encoder_.Clear(); }
+
+    [[nodiscard]] std::uint64_t MessageCount() const noexcept { return messages_; }
+
+private:
+    Orderbook& book_;
+    OwnerID owner_;
+    ExecutionReportEncoder encoder_;
+    ExecutionReportRouter* router_{ nullptr };
+    std::uint64_t messages_{ 0 };
+};
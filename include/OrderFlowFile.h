@@ -0,0 +1,48 @@
+#pragma once
+#include "OrderCommand.h"
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Recorded order flow, for replaying a session against a book.
+ *
+ * Two formats are read and written:
+ *
+ *  - CSV (files ending in .csv), one command per line; blank lines and lines
+ *    starting with '#' are skipped:
+ *
+ *      A,<order type>,<order ID>,<B|S>,<price>,<quantity>[,[<stop price>][,[<owner>][,[<peak>][,<expiry>]]]]
+ *      C,<order ID>
+ *      M,<order ID>,<B|S>,<price>,<quantity>
+ *      T,<time>
+ *      S,<reference price>
+ *      U
+ *
+ *    Order types are GTC, POST, MKT, STOP, FAK (IOC), FOK, GTD and DAY. The
+ *    stop price, owner and peak may be left empty to give a later field
+ *    without them; a peak makes the order an iceberg, and GTD orders need an
+ *    expiry. T advances the book's time; S starts a call auction and U
+ *    uncrosses it.
+ *
+ *  - binary (anything else): a capture of order-entry messages (OrderEntry.h),
+ *    which carry no owner and cannot advance time or run auctions
+ */
+std::vector<OrderCommand> ParseOrderFlowCsv(std::string_view text);
+std::string FormatOrderFlowCsv(std::span<const OrderCommand> commands);
+
+/**
+ * Reads a whole flow file, picking the format from the extension.
+ *
+ * @throws std::system_error if the file cannot be read
+ * @throws std::runtime_error on a malformed line or message, naming where it is
+ */
+std::vector<OrderCommand> LoadOrderFlow(const std::string& path);
+
+/**
+ * @throws std::system_error on any I/O failure
+ * @throws std::invalid_argument if a binary capture is given a command no
+ *         order-entry message can carry (see EncodeOrderEntry)
+ */
+void SaveOrderFlow(const std::string& path, std::span<const OrderCommand> commands);
@@ -0,0 +1,81 @@
+#pragma once
+#include "Types.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct OrderNode;
+
+/**
+ * Flat open-addressing map from OrderID to pooled order node.
+ *
+ * Linear probing over a power-of-two table with Fibonacci hashing, so dense
+ * sequential IDs land in distinct slots much like a direct-indexed array.
+ * Erase uses backward-shift deletion: no tombstones are ever left behind and
+ * probe sequences stay short without periodic rehashing. The table doubles
+ * once it is half full. A moved-from index is empty, with no table until
+ * its next insert or reserve.
+ */
+class OrderIndex {
+public:
+    explicit OrderIndex(std::size_t capacity = 1024);
+
+    OrderIndex(const OrderIndex&) = default;
+    OrderIndex& operator=(const OrderIndex&) = default;
+    OrderIndex(OrderIndex&& other) noexcept;
+    OrderIndex& operator=(OrderIndex&& other) noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+    [[nodiscard]] bool contains(OrderID orderID) const noexcept { return find(orderID) != nullptr; }
+
+    /**
+     * Returns the node for orderID, or nullptr if absent.
+     */
+    [[nodiscard]] OrderNode* find(OrderID orderID) const noexcept {
+        if (size_ == 0)
+            return nullptr;
+
+        for (auto slot = SlotFor(orderID);; slot = (slot + 1) & mask_) {
+            const auto& entry = slots_[slot];
+            if (!entry.node)
+                return nullptr;
+            if (entry.orderID == orderID)
+                return entry.node;
+        }
+    }
+
+    /**
+     * Inserts orderID -> node. Returns false if orderID is already present.
+     */
+    bool insert(OrderID orderID, OrderNode* node);
+
+    /**
+     * Looks up and removes orderID in a single probe.
+     * Returns the removed node, or nullptr if absent.
+     */
+    OrderNode* extract(OrderID orderID) noexcept;
+
+    void erase(OrderID orderID) noexcept { extract(orderID); }
+
+    void reserve(std::size_t count);
+    void clear() noexcept;
+
+private:
+    struct Entry {
+        OrderID orderID{ 0 };
+        OrderNode* node{ nullptr };  // nullptr marks an empty slot
+    };
+
+    std::size_t SlotFor(OrderID orderID) const noexcept {
+        return static_cast<std::size_t>((orderID * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    void Rehash(std::size_t capacity);
+
+    std::vector<Entry> slots_;
+    std::size_t mask_{ 0 };
+    unsigned shift_{ 64 };
+    std::size_t size_{ 0 };
+};
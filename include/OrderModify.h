@@ -3,7 +3,7 @@
 
 /**
  * Represents a request to modify an existing order.
- * Implemented as cancel-and-replace.
+ * Size-only reductions are applied in place; anything else is cancel-and-replace.
  */
 class OrderModify {
 public:
@@ -14,7 +14,9 @@ public:
     Price GetPrice() const { return price_; }
     Quantity GetQuantity() const { return quantity_; }
     
-    OrderPointer ToOrderPointer(OrderType type) const;
+    // The replacement order keeps the original's owner, iceberg peak and expiry
+    OrderPointer ToOrderPointer(OrderType type, OwnerID owner = NoOwner, Quantity peak = 0, Timestamp expiry = 0) const;
+    Order ToOrder(OrderType type, OwnerID owner = NoOwner, Quantity peak = 0, Timestamp expiry = 0) const;
     
 private:
     OrderID orderID_;
@@ -0,0 +1,201 @@
+#pragma once
+#include "OrderEntry.h"
+#include "Orderbook.h"
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+class JournalWriter;
+
+/**
+ * One entry of the pipeline's event ring: an execution report or a level
+ * update, tagged with the sequence of the command that produced it. Reports
+ * carry their order's owner, and fills their own side's, so a report stage
+ * can route each to its participant.
+ */
+struct PipelineEvent {
+    enum class Kind : std::uint8_t {
+        Report,
+        LevelUpdate
+    };
+
+    std::uint64_t command{ 0 };
+    Kind kind{ Kind::Report };
+    ExecutionReport report;     // valid for Report events
+    LevelUpdate level;          // valid for LevelUpdate events
+};
+
+/**
+ * A downstream consumer of the event ring, run on its own thread.
+ * Events arrive in the order the book produced them; OnBatchEnd follows each
+ * run of events read in one go and is the place to flush.
+ */
+class PipelineStage {
+public:
+    virtual ~PipelineStage() = default;
+
+    virtual void OnEvent(const PipelineEvent& event) = 0;
+    virtual void OnBatchEnd() { }
+};
+
+struct OrderPipelineConfig {
+    // Both rounded up to a power of two
+    std::size_t commandCapacity{ 1 << 16 };
+    std::size_t eventCapacity{ 1 << 16 };
+
+    std::optional<LadderConfig> ladder{ };
+
+    // Session schedule for Day orders; must match the journal's if there is one
+    std::optional<SessionSchedule> session{ };
+
+    // Resting orders the book is sized for up front
+    std::size_t reserveOrders{ 0 };
+
+    // Pin the matcher thread to CPU matcherCore (Linux only, ignored elsewhere)
+    bool pinMatcher{ false };
+    std::size_t matcherCore{ 0 };
+};
+
+/**
+ * Single-instrument runtime that splits command handling over threads joined
+ * by two preallocated rings, in the style of a disruptor:
+ *
+ *   Submit (sequencer) -> command ring -> matcher  -> event ring -> stages
+ *                                     \-> journal --(gates)------/
+ *
+ * Submit validates a command, gives it the next sequence and publishes its
+ * slot. The matcher thread applies each command to the pipeline's Orderbook
+ * and writes the resulting execution reports and level updates into the event
+ * ring; the journal thread, if there is one, appends the same command slots
+ * and commits after each run of them. Every stage reads every event. Each
+ * consumer publishes a cursor of how far it has got, and a ring slot is only
+ * reused once every consumer behind it has passed it, so nothing is copied
+ * between stages and no locks are taken.
+ *
+ * With a journal, stages only see a command's events once the command is
+ * committed: reports never get ahead of the journal. The matcher does not
+ * wait for it, so it does no I/O, and with enough reserveOrders and a ladder
+ * covering the traded band it does not allocate either.
+ *
+ * Threading contract:
+ * - Submit must be called from one producer thread.
+ * - Stage callbacks run on that stage's thread.
+ * - GetBook may only be used while the pipeline is stopped or after WaitIdle.
+ *
+ * A journal failure or an exception from a stage halts the pipeline; Submit,
+ * WaitIdle and Stop then rethrow it.
+ */
+class OrderPipeline {
+public:
+    /**
+     * @param journal Appended with every sequenced command on its own thread; may be null
+     * @param stages Each run on its own thread; must outlive the pipeline
+     * @throws std::invalid_argument if either ring capacity or the session
+     *         length is zero, or the journal has another session schedule
+     */
+    OrderPipeline(const OrderPipelineConfig& config, JournalWriter* journal,
+                  std::vector<PipelineStage*> stages);
+    ~OrderPipeline();
+
+    OrderPipeline(const OrderPipeline&) = delete;
+    OrderPipeline& operator=(const OrderPipeline&) = delete;
+
+    void Start();
+
+    /**
+     * Lets every stage see everything already submitted, then joins the threads.
+     */
+    void Stop();
+
+    /**
+     * Sequences a command, spinning while the command ring is full.
+     * Returns its sequence number, counting from 1.
+     *
+     * Commands no book could accept are refused here and never reach the
+     * matcher or the journal. The book may still reject a command (e.g. a
+     * duplicate ID, or a Day order without a session schedule); that comes
+     * back as an execution report.
+     *
+     * @throws std::invalid_argument if an add fails Order::Validate, or time would move backwards
+     */
+    std::uint64_t Submit(const OrderCommand& command);
+
+    /**
+     * Blocks the producer until every stage has seen everything submitted.
+     */
+    void WaitIdle() const;
+
+    Orderbook& GetBook() noexcept { return book_; }
+
+    /**
+     * Number of commands the book threw on; each was reported as rejected
+     * with InvalidOrderReason.
+     */
+    [[nodiscard]] std::uint64_t FailedCommands() const noexcept {
+        return failed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::size_t CacheLine = 64;
+
+    // Count of slots a thread has published or consumed, alone on its cache line
+    struct alignas(CacheLine) Cursor {
+        std::atomic<std::uint64_t> value{ 0 };
+    };
+
+    struct Stage {
+        PipelineStage* consumer;
+        std::thread thread;
+        Cursor consumed;
+    };
+
+    class EventWriter;
+
+    void RunMatcher();
+    void RunJournal();
+    void RunStage(Stage& stage);
+
+    // How far every consumer of each ring has got; slots below gate + capacity are free
+    std::uint64_t CommandGate() const noexcept;
+    std::uint64_t EventGate() const noexcept;
+
+    void Join() noexcept;
+    void Halt(std::exception_ptr error) noexcept;
+    void ThrowIfHalted() const;
+
+    OrderPipelineConfig config_;
+    Orderbook book_;
+    JournalWriter* journal_;
+
+    std::vector<OrderCommand> commands_;
+    std::uint64_t commandMask_;
+    std::vector<PipelineEvent> events_;
+    std::uint64_t eventMask_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    std::unique_ptr<EventWriter> writer_;   // matcher only
+
+    std::thread matcher_;
+    std::thread journalThread_;
+
+    // Producer only
+    std::uint64_t submitted_{ 0 };
+    std::uint64_t commandGate_{ 0 };   // producer's view of CommandGate()
+    Timestamp time_{ 0 };
+
+    Cursor published_;      // commands sequenced
+    Cursor matched_;        // commands applied to the book
+    Cursor journaled_;      // commands committed to the journal
+    Cursor eventsPublished_;
+
+    std::atomic<std::uint64_t> failed_{ 0 };
+    std::atomic<bool> running_{ false };
+    std::atomic<bool> upstreamDone_{ false };
+    std::atomic<bool> halted_{ false };
+    mutable std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
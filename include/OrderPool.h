@@ -0,0 +1,131 @@
+#pragma once
+#include "Order.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+struct PriceLevel;
+
+/**
+ * Stable reference to an order stored in an OrderPool.
+ * The generation guards against reuse: a handle to a released node stays invalid.
+ */
+struct OrderHandle {
+    static constexpr std::uint32_t InvalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+    std::uint32_t index{ InvalidIndex };
+    std::uint32_t generation{ 0 };
+
+    [[nodiscard]] bool IsValid() const noexcept { return index != InvalidIndex; }
+};
+
+/**
+ * Pool slot holding one order plus its intrusive FIFO and expiry links.
+ *
+ * Orders added through the shared_ptr API keep the caller's object alive in owner;
+ * orders added by value are constructed in place in storage.
+ */
+struct OrderNode {
+    static constexpr std::uint16_t NotExpiring = std::numeric_limits<std::uint16_t>::max();
+
+    Order* order{ nullptr };
+    OrderPointer owner;
+    std::optional<Order> storage;
+
+    OrderNode* prev{ nullptr };
+    OrderNode* next{ nullptr };
+
+    // Level the order rests at, null while pending as a stop
+    PriceLevel* level{ nullptr };
+
+    // ExpiryWheel slot list, for GoodTillDate and Day orders in the book
+    OrderNode* expiryPrev{ nullptr };
+    OrderNode* expiryNext{ nullptr };
+
+    std::uint32_t index{ 0 };
+    std::uint32_t generation{ 0 };
+    std::uint16_t expirySlot{ NotExpiring };
+};
+
+/**
+ * Intrusive FIFO of orders resting at one price level.
+ * Push, pop and unlink are O(1) and never allocate.
+ */
+class OrderQueue {
+public:
+    template <typename Node, typename Value>
+    class Iterator {
+    public:
+        explicit Iterator(Node* node) : node_{ node } { }
+
+        Value& operator*() const { return *node_->order; }
+        Iterator& operator++() { node_ = node_->next; return *this; }
+        bool operator==(const Iterator& other) const { return node_ == other.node_; }
+
+    private:
+        Node* node_;
+    };
+
+    using iterator = Iterator<OrderNode, Order>;
+    using const_iterator = Iterator<const OrderNode, const Order>;
+
+    [[nodiscard]] bool empty() const noexcept { return head_ == nullptr; }
+    [[nodiscard]] OrderNode* Front() const noexcept { return head_; }
+
+    iterator begin() { return iterator{ head_ }; }
+    iterator end() { return iterator{ nullptr }; }
+    const_iterator begin() const { return const_iterator{ head_ }; }
+    const_iterator end() const { return const_iterator{ nullptr }; }
+
+    void PushBack(OrderNode* node) noexcept;
+    void Remove(OrderNode* node) noexcept;
+
+private:
+    OrderNode* head_{ nullptr };
+    OrderNode* tail_{ nullptr };
+};
+
+/**
+ * Slab allocator for order nodes.
+ *
+ * Nodes are carved out of fixed-size chunks that never move, so node pointers and
+ * handles stay stable. Released nodes go to a free list and are reused first;
+ * once the pool has warmed up, Allocate does not touch the heap.
+ */
+class OrderPool {
+public:
+    static constexpr std::size_t ChunkSize = 1024;
+
+    OrderPool() = default;
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+    OrderPool(OrderPool&& other) noexcept;
+    OrderPool& operator=(OrderPool&& other) noexcept;
+
+    /**
+     * Grows the pool to hold at least count nodes in total, so bulk loads
+     * allocate chunks up front instead of one at a time.
+     */
+    void Reserve(std::size_t count);
+
+    [[nodiscard]] OrderNode* Allocate();
+    void Release(OrderNode* node) noexcept;
+
+    /**
+     * Returns the node for handle, or nullptr if it has been released.
+     */
+    [[nodiscard]] OrderNode* Get(OrderHandle handle) const noexcept;
+
+    [[nodiscard]] static OrderHandle HandleOf(const OrderNode* node) noexcept {
+        return { node->index, node->generation };
+    }
+
+private:
+    void AddChunk();
+
+    std::vector<std::unique_ptr<OrderNode[]>> chunks_;
+    OrderNode* freeList_{ nullptr };
+};
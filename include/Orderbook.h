@@ -2,13 +2,34 @@
 #include "Order.h"
 #include "Trade.h"
 #include "OrderModify.h"
+#include "OrderCommand.h"
 #include "OrderbookLevelInfos.h"
-#include <map>
-#include <unordered_map>
+#include "OrderbookFwd.h"
+#include "OrderbookListener.h"
+#include "OrderbookPolicy.h"
+#include "ExpiryWheel.h"
+#include "OrderIndex.h"
+#include "OrderPool.h"
+#include "PriceLevel.h"
+#include "PriceLevels.h"
+#include "StopBook.h"
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 /**
- * Orderbook implementation.
+ * Orderbook implementation, configured at compile time by a policy (see
+ * OrderbookPolicy.h). Orderbook is the full-featured book; LeanOrderbook
+ * leaves stops, self-trade prevention and instrumentation out. Both are
+ * compiled into the library; books with other policies include
+ * OrderbookImpl.h to instantiate themselves.
  * 
  * Matching Algorithm: FIFO with price-time priority
  * Trade Pricing: Maker's price (resting order's price)
@@ -20,17 +41,89 @@
  * - FillOrKill: All-or-nothing execution
  * - PostOnly: Only add liquidity (maker-only)
  * - StopOrder: Trigger based on trade price
+ * - GoodTillDate / Day: Rest like GoodTillCancel until an expiry
+ *
+ * Resting orders can be icebergs: they display at most
+ * their peak, and when a peak is used up the same order refills it from its
+ * hidden reserve and moves to the back of its level. Depth queries and level
+ * updates show displayed quantity only; FillOrKill checks count reserves too.
+ *
+ * Price levels are kept in a std::map by default. Books for instruments that
+ * trade in a bounded tick band can opt into an array-backed ladder instead.
+ * Matching is generated once per side, so the hot loops test no side at run time.
+ *
+ * Resting orders live in a pooled slab of nodes linked into an intrusive FIFO
+ * per level, so resting and removing an order does not allocate once warm.
+ *
+ * GoodTillDate and Day orders, resting or pending as stops, sit in a timing
+ * wheel keyed by expiry. The book has no clock of its own: its time is moved
+ * by AdvanceTime, which expires whatever has come due in O(expired), so tests
+ * and replays decide exactly when orders expire.
+ *
+ * Orders carry an optional owner. With self-trade prevention enabled, an
+ * order that would trade against a resting order of the same owner is
+ * handled by the configured mode instead; the check is one comparison per fill.
+ *
+ * Between StartAuction and Uncross the book runs a call auction: orders
+ * accumulate without matching, and the uncross executes everything that
+ * crosses at one equilibrium price.
+ *
+ * Every command has an overload that streams events (accepts, rejects, trades,
+ * cancels, stop triggers) to an OrderbookListener as they happen. The
+ * Trades-returning overloads are adapters that collect trades into a vector.
+ * Level changes are coalesced per command and reported last as sequenced
+ * L2 updates.
  */
-class Orderbook {
+template <typename Policy>
+class BasicOrderbook {
+    static_assert(OrderbookPolicy<Policy>, "BasicOrderbook needs an OrderbookPolicy");
+
+    using BidLevels = typename Policy::template Levels<std::greater<Price>>;
+    using AskLevels = typename Policy::template Levels<std::less<Price>>;
+
 public:
+    BasicOrderbook() = default;
+
+    /**
+     * Creates a book whose price levels use an array ladder over the given band.
+     * Prices outside the band still work, they just fall back to map storage.
+     *
+     * @throws std::invalid_argument if the band is empty or the tick is not positive
+     */
+    explicit BasicOrderbook(const LadderConfig& ladder)
+        requires std::constructible_from<BidLevels, const LadderConfig&>
+        : bids_{ ladder }, asks_{ ladder } { }
+
     /**
      * Adds an order to the orderbook and attempts to match it.
      * 
      * @param order The order to add
      * @return Vector of trades resulting from this order
-     * @throws std::invalid_argument if order validation fails
+     * @throws std::invalid_argument if order validation fails (zero quantity,
+     *         negative price, an iceberg that cannot rest, a GoodTillDate order
+     *         without an expiry, an expiry on any other type, a Day order
+     *         before a session schedule is set, or a stop order in a book
+     *         without stops)
      */
     Trades AddOrder(OrderPointer order);
+
+    /**
+     * Adds an order by value. The order is copied into the book's pool, so
+     * nothing is allocated on the heap once the pool and trades buffer are warm.
+     * 
+     * @param order The order to add
+     * @param trades Buffer that resulting trades are appended to
+     * @return Handle to the resting or pending stop order; invalid if nothing rests
+     * @throws std::invalid_argument if order validation fails
+     */
+    OrderHandle AddOrder(const Order& order, Trades& trades);
+
+    /**
+     * Listener variants of AddOrder: events are delivered to listener
+     * instead of being collected.
+     */
+    void AddOrder(OrderPointer order, OrderbookListener& listener);
+    OrderHandle AddOrder(const Order& order, OrderbookListener& listener);
     
     /**
      * Cancels an order by ID.
@@ -39,14 +132,124 @@ public:
      * @param orderID The ID of the order to cancel
      */
     void CancelOrder(OrderID orderID);
+    void CancelOrder(OrderID orderID, OrderbookListener& listener);
+
+    /**
+     * Cancels the order referenced by handle. Stale handles are ignored.
+     */
+    void CancelOrder(OrderHandle handle);
     
     /**
-     * Modifies an existing order (implemented as cancel-and-replace).
+     * Modifies an existing order.
+     * 
+     * Same side and price with a smaller (or equal) quantity shrinks the order in
+     * place in O(1) and keeps its time priority. Any other change is applied as
+     * cancel-and-replace and the order goes to the back of its new level.
      * 
      * @param order The modification details
      * @return Vector of trades if the new order matches
+     * @throws std::invalid_argument if the replacement fails validation (zero
+     *         quantity, negative price); the original order is left resting
      */
     Trades ModifyOrder(OrderModify order);
+    void ModifyOrder(OrderModify order, OrderbookListener& listener);
+
+    /**
+     * Adds a sequence of orders, appending all trades to one buffer.
+     * Equivalent to calling AddOrder(order, trades) for each order in turn.
+     * 
+     * @throws std::invalid_argument if an order fails validation; orders
+     *         before it have already been applied
+     */
+    void AddOrders(std::span<const Order> orders, Trades& trades);
+
+    /**
+     * Moves the book's time forward to now and cancels every GoodTillDate and
+     * Day order, resting or pending as a stop, whose expiry is at or before it.
+     * Expired orders are reported through OnOrderCancelled, earliest expiry
+     * first (then by order ID), followed by one level update per level they
+     * leave. Cost is proportional to the orders that expire.
+     *
+     * @throws std::invalid_argument if now is before the book's current time
+     */
+    void AdvanceTime(Timestamp now);
+    void AdvanceTime(Timestamp now, OrderbookListener& listener);
+
+    /**
+     * The book's time: what the last AdvanceTime moved it to, 0 for a new book.
+     * GoodTillDate orders must expire after it to be accepted.
+     */
+    [[nodiscard]] Timestamp GetTime() const noexcept { return expiries_.Now(); }
+
+    /**
+     * Sets when Day orders expire: at the first session close after the book's
+     * time when they are accepted, closes falling every `length` from firstClose
+     * on the book's clock. Orders already in the book keep their expiry.
+     *
+     * @throws std::invalid_argument if length is zero
+     */
+    void SetSessionSchedule(Timestamp firstClose, Timestamp length);
+    void SetSessionSchedule(const SessionSchedule& schedule) { SetSessionSchedule(schedule.firstClose, schedule.length); }
+
+    // The schedule Day orders are stamped from, if one has been set
+    [[nodiscard]] std::optional<SessionSchedule> GetSessionSchedule() const noexcept {
+        if (sessionLength_ == 0)
+            return std::nullopt;
+        return SessionSchedule{ sessionClose_, sessionLength_ };
+    }
+
+    /**
+     * Applies add/cancel/modify/advance-time/auction commands in order, appending all
+     * trades to one caller-owned buffer that can be reused across batches.
+     * Produces exactly the same book and trades as applying them one by one.
+     * A StartAuction during an auction, or an Uncross outside one, is ignored,
+     * as a cancel of an unknown order is.
+     * 
+     * @throws std::invalid_argument if an add fails validation; commands
+     *         before it have already been applied
+     */
+    void ProcessBatch(std::span<const OrderCommand> commands, Trades& trades);
+    void ProcessBatch(std::span<const OrderCommand> commands, OrderbookListener& listener);
+
+    /**
+     * Starts a call auction (an opening or closing auction). Continuous
+     * matching stops: orders rest even when they cross, and stops park as
+     * usual. Orders that cannot wait for the uncross (FillAndKill, FillOrKill,
+     * Market and PostOnly) are rejected with RejectReason::AuctionInProgress.
+     *
+     * The equilibrium price is the crossed level price that trades the most
+     * volume, counting iceberg reserves. Ties go to the smallest imbalance,
+     * then to the price nearest referencePrice, then to the lower price. One
+     * sweep over the crossed levels finds it. It is recomputed only after
+     * commands that change a level inside the crossed band or move the band.
+     * Changes are reported through OnAuctionIndication.
+     *
+     * @throws std::logic_error if an auction is already in progress
+     */
+    void StartAuction(Price referencePrice);
+
+    [[nodiscard]] bool InAuction() const noexcept { return inAuction_; }
+
+    /**
+     * Where the auction in progress would uncross now. It is kept up to date
+     * by every command, so reading it is free. Volume is 0 outside an auction.
+     */
+    [[nodiscard]] const AuctionIndication& GetIndicativeUncross() const noexcept { return auctionIndication_; }
+
+    /**
+     * Ends the auction. Every order priced at or better than the equilibrium
+     * trades at it, in price-time priority on each side. The book then returns
+     * to continuous matching and stops trigger on the uncross price.
+     *
+     * Returns the uncross, with volume being what actually traded. Self-trade
+     * prevention can make that less than indicated. An uncross has no
+     * aggressor, so a same-owner pair is handled as DecrementAndCancel in
+     * every mode.
+     *
+     * @throws std::logic_error if no auction is in progress
+     */
+    AuctionIndication Uncross(Trades& trades);
+    AuctionIndication Uncross(OrderbookListener& listener);
     
     /**
      * Returns the number of active orders in the book.
@@ -60,32 +263,287 @@ public:
     [[nodiscard]] std::size_t PendingStopCount() const noexcept;
     
     /**
-     * Returns aggregated order information by price level.
+     * Returns aggregated order information by price level: displayed quantity,
+     * so iceberg reserves are not shown.
+     * Cost is O(levels); per-level totals are maintained incrementally.
      */
     OrderbookLevelInfos GetOrderInfos() const;
 
+    /**
+     * Returns the best `depth` levels on each side in O(depth).
+     */
+    OrderbookLevelInfos GetTopLevels(std::size_t depth) const;
+
+    /**
+     * Copies up to out.size() best levels of one side into out without allocating.
+     * Returns the number of levels written.
+     */
+    std::size_t GetTopLevels(Side side, std::span<LevelInfo> out) const noexcept;
+
+    /**
+     * Market-impact queries for an order on `side`: a buy takes from the asks,
+     * a sell from the bids. They see displayed quantity, as GetOrderInfos does,
+     * and never allocate. Only books whose policy enables depth queries have them.
+     *
+     * Cost is O(log levels) for levels in the ladder band plus one step per level
+     * kept in the map. A book built without a LadderConfig keeps every level in
+     * the map, so there they are O(levels) walks; build with a ladder over the
+     * traded band to get the logarithmic bound.
+     */
+
+    // Quantity an order limited at price could trade against right now
+    [[nodiscard]] std::uint64_t GetDepthTo(Side side, Price price) const noexcept
+        requires(Policy::EnableDepthQueries);
+
+    // Last price a sweep of quantity reaches; nullopt for zero or more than the side holds
+    [[nodiscard]] std::optional<Price> GetPriceForQuantity(Side side, std::uint64_t quantity) const noexcept
+        requires(Policy::EnableDepthQueries);
+
+    // Notional, VWAP and worst price of sweeping quantity; nullopt as for GetPriceForQuantity
+    [[nodiscard]] std::optional<FillCost> GetCostToFill(Side side, std::uint64_t quantity) const noexcept
+        requires(Policy::EnableDepthQueries);
+
+    /**
+     * Sets how same-owner matches are handled from the next command on.
+     * SelfTradePrevention::None (the default) lets them trade. Only books whose
+     * policy enables self-trade prevention have it.
+     */
+    void SetSelfTradePrevention(SelfTradePrevention mode) noexcept
+        requires(Policy::EnableSelfTradePrevention)
+    {
+        selfTradePrevention_ = mode;
+    }
+    [[nodiscard]] SelfTradePrevention GetSelfTradePrevention() const noexcept { return selfTradePrevention_; }
+
+    /**
+     * Sequence number of the last level update this book emitted, 0 before the first.
+     * Taken together with GetOrderInfos() it seeds ApplyLevelUpdates.
+     */
+    [[nodiscard]] std::uint64_t LevelUpdateSequence() const noexcept { return levelSequence_; }
+
+    /**
+     * Sizes the order pool and index for count orders, so a book that stays
+     * under it allocates nothing for its orders while matching.
+     */
+    void Reserve(std::size_t count);
+
+    /**
+     * Returns the order behind handle, or nullptr if it is no longer in the book.
+     */
+    [[nodiscard]] const Order* GetOrder(OrderHandle handle) const noexcept;
+
+    /**
+     * Returns the resting order or pending stop with orderID, or nullptr if there is none.
+     */
+    [[nodiscard]] const Order* GetOrder(OrderID orderID) const noexcept;
+
+    /**
+     * Serializes every resting order (in price-time priority) and pending stop
+     * into a compact, versioned, fixed-record binary snapshot.
+     */
+    [[nodiscard]] std::vector<std::byte> SaveSnapshot() const;
+
+    /**
+     * Writes a snapshot to path, replacing any existing file atomically.
+     *
+     * @throws std::system_error on I/O failure
+     */
+    void SaveSnapshot(const std::string& path) const;
+
+    /**
+     * Restores a snapshot into this book, which must be empty.
+     *
+     * Levels, the order index, the stop book and the expiry wheel are bulk-built
+     * straight from the records rather than replayed through AddOrder, and the
+     * book's time is set to the saved book's. Restored orders are pooled;
+     * handles and shared_ptrs from the saved book do not carry over. The ladder
+     * configuration is this book's; the session schedule is the saved one's if
+     * it had one, and this book's otherwise. A book saved during an auction is
+     * restored into that auction, reference price included; otherwise the
+     * book keeps its own phase.
+     *
+     * @throws std::logic_error if the book is not empty
+     * @throws std::runtime_error if the snapshot is truncated, corrupt or of
+     *         another version, holds stops and the book has none, or has
+     *         crossed resting orders and neither it nor the book is in an
+     *         auction; the book is unchanged
+     */
+    void LoadSnapshot(std::span<const std::byte> snapshot);
+
+    /**
+     * Maps the file at path and restores it as above.
+     */
+    void LoadSnapshot(const std::string& path);
+
 private:
-    struct OrderEntry {
-        OrderPointer order{nullptr};
-        OrderPointers::iterator location;
-    };
-    
+    // Read by the ORDERBOOK_COUNT / ORDERBOOK_TIME_SECTION hooks
+    static constexpr bool Instrumented = Policy::EnableInstrumentation;
+
+    static inline OrderbookListener nullListener;
+
     // Price-sorted books
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
+    BidLevels bids_;
+    AskLevels asks_;
     
+    // Storage for resting and pending stop orders
+    OrderPool pool_;
+
     // Fast lookup by order ID
-    std::unordered_map<OrderID, OrderEntry> orders_;
+    OrderIndex orders_;
     
     // Stop orders waiting for trigger
-    std::vector<OrderPointer> pendingStopOrders_;
+    StopBook pendingStopOrders_;
+
+    // Work queue for stop cascades, reused across calls
+    std::vector<OrderNode*> triggeredStops_;
+
+    // GoodTillDate and Day orders by expiry; its time is the book's time
+    ExpiryWheel expiries_;
+    std::vector<OrderNode*> expiredOrders_;
+
+    // Day order expiry: first close after acceptance, closes every sessionLength_ from sessionClose_
+    Timestamp sessionClose_{ 0 };
+    Timestamp sessionLength_{ 0 };
+
+    // Level quantities and order counts changed by the current command, reported when it ends
+    struct LevelChange {
+        Side side;
+        Price price;
+        Quantity before;
+        Quantity after;
+        std::uint32_t countBefore;
+        std::uint32_t countAfter;
+    };
+    std::vector<LevelChange> levelChanges_;
+
+    // Held by each public command: if it throws, what it noted is dropped rather
+    // than published under the next command's sequence
+    class LevelChangeGuard {
+    public:
+        explicit LevelChangeGuard(std::vector<LevelChange>& changes) noexcept
+            : changes_{ changes }, exceptions_{ std::uncaught_exceptions() } { }
+        ~LevelChangeGuard() {
+            if (std::uncaught_exceptions() > exceptions_)
+                changes_.clear();
+        }
+
+    private:
+        std::vector<LevelChange>& changes_;
+        int exceptions_;
+    };
+    std::vector<std::size_t> levelChangeIndex_;  // scratch for folding large change sets
+    std::uint64_t levelSequence_{ 0 };
+
+    SelfTradePrevention selfTradePrevention_{ SelfTradePrevention::None };
+
+    // Call auction: the last equilibrium, the crossed band it came from, and
+    // scratch for the crossed asks
+    bool inAuction_{ false };
+    Price referencePrice_{ 0 };
+    AuctionIndication auctionIndication_;
+    std::pair<Price, Price> crossedBand_{ 1, 0 };
+    std::vector<LevelInfo> crossedAsks_;
+
+    struct MatchResult {
+        std::optional<Price> lastTradePrice;
+        bool aggressorCancelled{ false };  // self-trade prevention took the rest of the order
+    };
     
-    // Helper methods
+    // The levels orders on side S rest at
+    template <Side S>
+    auto& LevelsOf() noexcept {
+        if constexpr (S == Side::Buy)
+            return bids_;
+        else
+            return asks_;
+    }
+    template <Side S>
+    const auto& LevelsOf() const noexcept {
+        if constexpr (S == Side::Buy)
+            return bids_;
+        else
+            return asks_;
+    }
+
+    static constexpr Side Opposite(Side side) noexcept { return side == Side::Buy ? Side::Sell : Side::Buy; }
+
+    // Whether an order on side S limited at price trades with a level at levelPrice
+    template <Side S>
+    static bool Crosses(Price price, Price levelPrice) noexcept {
+        if constexpr (S == Side::Buy)
+            return price >= levelPrice;
+        else
+            return price <= levelPrice;
+    }
+
+    bool PreventsSelfTrades() const noexcept {
+        if constexpr (Policy::EnableSelfTradePrevention)
+            return selfTradePrevention_ != SelfTradePrevention::None;
+        else
+            return false;
+    }
+
+    // Helper methods; the Side overloads pick the per-side instantiation once
+    bool CanAccept(const Order& order, OrderbookListener& listener) const;
+    Timestamp NextSessionClose() const noexcept;
     bool CanMatch(Side side, Price price) const;
-    bool CanFullyMatch(Side side, Price price, Quantity quantity) const;
+    template <Side S>
+    bool CanMatch(Price price) const;
+    bool CanFullyMatch(Side side, Price price, Quantity quantity, OwnerID owner) const;
+    template <Side S>
+    bool CanFullyMatch(Price price, Quantity quantity, OwnerID owner) const;
+    template <Side S>
+    bool CanFullyMatchOthers(Price price, Quantity quantity, OwnerID owner) const;
     
-    Trades CheckAndTriggerStopOrders(Price tradePrice);
-    void MatchAtPriceLevel(OrderPointer& aggressive, OrderPointers& restingOrders, 
-                          Trades& trades);
-    Trades MatchAggressiveOrder(OrderPointer& order);
-};
\ No newline at end of file
+    // Command bodies; the public overloads add level-update reporting around them
+    OrderHandle InsertOrder(const Order& order, OrderbookListener& listener);
+    void EraseOrder(OrderID orderID, OrderbookListener& listener);
+    void AmendOrder(const OrderModify& order, OrderbookListener& listener);
+
+    OrderHandle PlaceOrder(OrderNode* node, OrderbookListener& listener);
+    void CheckAndTriggerStopOrders(Price tradePrice, OrderbookListener& listener);
+    // Return false once self-trade prevention has cancelled the aggressive order
+    template <Side S>
+    bool MatchAtPriceLevel(Order& aggressive, PriceLevel& restingOrders, OrderbookListener& listener);
+    bool PreventSelfTrade(Order& aggressive, PriceLevel& restingOrders, OrderNode* restingNode,
+                          OrderbookListener& listener);
+    MatchResult MatchAggressiveOrder(Order& order, OrderbookListener& listener);
+    template <Side S>
+    MatchResult MatchAggressiveOrder(Order& order, OrderbookListener& listener);
+    void CancelRestingOrder(PriceLevel& restingOrders, OrderNode* restingNode, OrderbookListener& listener);
+    // After a fill: removes a filled resting order, or refills an iceberg whose peak is used up
+    void SettleRestingFill(PriceLevel& restingOrders, OrderNode* restingNode, OrderbookListener& listener);
+
+    AuctionIndication ComputeUncross();
+    // Whether the current command's level changes can have moved the equilibrium
+    bool MovesUncross(std::size_t distinctChanges) const;
+    // Trades every order at or better than price at it; returns the volume
+    std::uint64_t ExecuteUncross(Price price, OrderbookListener& listener);
+    std::uint64_t UncrossLevels(PriceLevel& bids, PriceLevel& asks, Price price, OrderbookListener& listener);
+
+    // Called with the level's quantity and order count from before the change
+    void NoteLevelChange(Side side, Price price, Quantity before, std::uint32_t countBefore, const PriceLevel& level) {
+        levelChanges_.push_back(LevelChange{ side, price, before, level.totalQuantity, countBefore, level.orderCount });
+        AdjustDepth(side, price, static_cast<std::int64_t>(level.totalQuantity) - static_cast<std::int64_t>(before));
+    }
+    void AdjustDepth(Side side, Price price, std::int64_t delta) noexcept {
+        if constexpr (Policy::EnableDepthQueries) {
+            if (side == Side::Buy)
+                bids_.AdjustDepth(price, delta);
+            else
+                asks_.AdjustDepth(price, delta);
+        }
+    }
+    void PublishLevelUpdates(OrderbookListener& listener);
+    // Folds levelChanges_ to one entry per level, in first-touch order, and returns how many
+    std::size_t FoldLevelChanges();
+
+    // Removes the first `loaded` snapshot records again after a failed load
+    void UndoSnapshotLoad(std::span<const std::byte> payload, std::size_t recordSize, std::size_t loaded);
+};
+
+using LeanOrderbook = BasicOrderbook<LeanOrderbookPolicy>;
+
+// Compiled once in the library (src/Orderbook.cpp)
+extern template class BasicOrderbook<DefaultOrderbookPolicy>;
+extern template class BasicOrderbook<LeanOrderbookPolicy>;
@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * Forward declarations for headers that only take books by reference.
+ */
+template <typename Policy>
+class BasicOrderbook;
+
+struct DefaultOrderbookPolicy;
+using Orderbook = BasicOrderbook<DefaultOrderbookPolicy>;
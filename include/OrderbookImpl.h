@@ -0,0 +1,1203 @@
+#pragma once
+#include "Orderbook.h"
+#include "FileIO.h"
+#include "Instrumentation.h"
+#include "SnapshotFormat.h"
+#include "WireFormat.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * Member definitions of BasicOrderbook. Only needed to instantiate a book with
+ * a policy of one's own; Orderbook and LeanOrderbook come compiled in the library.
+ */
+
+template <typename Policy>
+Trades BasicOrderbook<Policy>::AddOrder(OrderPointer order) {
+    Trades trades;
+    TradeCollector collector{trades};
+    AddOrder(std::move(order), collector);
+    return trades;
+}
+
+template <typename Policy>
+OrderHandle BasicOrderbook<Policy>::AddOrder(const Order& order, Trades& trades) {
+    TradeCollector collector{trades};
+    return AddOrder(order, collector);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::AddOrder(OrderPointer order, OrderbookListener& listener) {
+    ORDERBOOK_COUNT(Adds);
+    LevelChangeGuard guard{ levelChanges_ };
+
+    // Validation
+    if (!order)
+        throw std::invalid_argument("Order cannot be null");
+
+    if (!CanAccept(*order, listener))
+        return;
+
+    auto* node = pool_.Allocate();
+    node->owner = std::move(order);
+    node->order = node->owner.get();
+
+    PlaceOrder(node, listener);
+    PublishLevelUpdates(listener);
+}
+
+template <typename Policy>
+OrderHandle BasicOrderbook<Policy>::AddOrder(const Order& order, OrderbookListener& listener) {
+    ORDERBOOK_COUNT(Adds);
+    LevelChangeGuard guard{ levelChanges_ };
+    auto handle = InsertOrder(order, listener);
+    PublishLevelUpdates(listener);
+    return handle;
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::CancelOrder(OrderID orderID) {
+    CancelOrder(orderID, nullListener);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::CancelOrder(OrderID orderID, OrderbookListener& listener) {
+    ORDERBOOK_COUNT(Cancels);
+    ORDERBOOK_TIME_SECTION(CancelOrder);
+    LevelChangeGuard guard{ levelChanges_ };
+    EraseOrder(orderID, listener);
+    PublishLevelUpdates(listener);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::CancelOrder(OrderHandle handle) {
+    if (const auto* node = pool_.Get(handle))
+        CancelOrder(node->order->GetOrderID());
+}
+
+template <typename Policy>
+Trades BasicOrderbook<Policy>::ModifyOrder(OrderModify order) {
+    Trades trades;
+    TradeCollector collector{trades};
+    ModifyOrder(order, collector);
+    return trades;
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::ModifyOrder(OrderModify order, OrderbookListener& listener) {
+    ORDERBOOK_COUNT(Modifies);
+    LevelChangeGuard guard{ levelChanges_ };
+    AmendOrder(order, listener);
+    PublishLevelUpdates(listener);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::AdvanceTime(Timestamp now) {
+    AdvanceTime(now, nullListener);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::AdvanceTime(Timestamp now, OrderbookListener& listener) {
+    if (now < GetTime())
+        throw std::invalid_argument("Orderbook time cannot move backwards");
+    LevelChangeGuard guard{ levelChanges_ };
+
+    expiredOrders_.clear();
+    expiries_.Advance(now, expiredOrders_);
+
+    // The wheel hands orders back slot by slot; report them in expiry order. A
+    // mass expiry at the close usually comes back sorted already
+    auto ByExpiry = [](const OrderNode* lhs, const OrderNode* rhs) {
+        return std::pair{ lhs->order->GetExpiry(), lhs->order->GetOrderID() } <
+               std::pair{ rhs->order->GetExpiry(), rhs->order->GetOrderID() };
+    };
+    if (!std::is_sorted(expiredOrders_.begin(), expiredOrders_.end(), ByExpiry))
+        std::sort(expiredOrders_.begin(), expiredOrders_.end(), ByExpiry);
+
+    for (auto* node : expiredOrders_) {
+        ORDERBOOK_COUNT(OrdersExpired);
+        EraseOrder(node->order->GetOrderID(), listener);
+    }
+    expiredOrders_.clear();
+    PublishLevelUpdates(listener);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::SetSessionSchedule(Timestamp firstClose, Timestamp length) {
+    if (length == 0)
+        throw std::invalid_argument("Session length must be positive");
+
+    sessionClose_ = firstClose;
+    sessionLength_ = length;
+}
+
+template <typename Policy>
+OrderHandle BasicOrderbook<Policy>::InsertOrder(const Order& order, OrderbookListener& listener) {
+    if (!CanAccept(order, listener))
+        return {};
+
+    auto* node = pool_.Allocate();
+    node->order = &node->storage.emplace(order);
+
+    return PlaceOrder(node, listener);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::EraseOrder(OrderID orderID, OrderbookListener& listener) {
+    // Check active orders first
+    auto* node = orders_.extract(orderID);
+    if (!node) {
+        // Check pending stop orders
+        if constexpr (Policy::EnableStops) {
+            if (auto* stop = pendingStopOrders_.Extract(orderID)) {
+                expiries_.Remove(stop);
+                listener.OnOrderCancelled(*stop->order);
+                pool_.Release(stop);
+            }
+        }
+        return;
+    }
+
+    expiries_.Remove(node);
+    auto price = node->order->GetPrice();
+    auto& orders = *node->level;
+    auto before = orders.totalQuantity;
+    auto countBefore = orders.orderCount;
+    orders.Remove(node);
+    NoteLevelChange(node->order->GetSide(), price, before, countBefore, orders);
+
+    if (orders.empty()) {
+        ORDERBOOK_COUNT(LevelsDestroyed);
+        if (node->order->GetSide() == Side::Sell)
+            asks_.erase(price);
+        else
+            bids_.erase(price);
+    }
+
+    listener.OnOrderCancelled(*node->order);
+    pool_.Release(node);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::AmendOrder(const OrderModify& order, OrderbookListener& listener) {
+    auto* node = orders_.find(order.GetOrderID());
+    if (!node)
+        return;
+
+    auto& current = *node->order;
+
+    // Fast path: size-only reduction keeps queue position
+    if (order.GetSide() == current.GetSide() &&
+        order.GetPrice() == current.GetPrice() &&
+        order.GetQuantity() > 0 &&
+        order.GetQuantity() <= current.GetRemainingQuantity()) {
+        auto reduction = current.GetRemainingQuantity() - order.GetQuantity();
+        if (reduction == 0)
+            return;
+
+        auto before = node->level->totalQuantity;
+        auto visible = current.GetVisibleQuantity();
+        auto hidden = current.GetHiddenQuantity();
+        current.Reduce(reduction);
+        node->level->Reduce(visible - current.GetVisibleQuantity(), hidden - current.GetHiddenQuantity());
+        NoteLevelChange(current.GetSide(), current.GetPrice(), before, node->level->orderCount, *node->level);
+        listener.OnOrderReduced(current);
+        return;
+    }
+
+    // Cancel-and-replace is one command, so a replace at the same price reports one net update
+    // Validated before the erase, so a replacement the book would refuse leaves the original resting
+    auto replacement = order.ToOrder(current.GetOrderType(), current.GetOwner(), current.GetPeakQuantity(),
+                                     current.GetExpiry());
+    replacement.Validate();
+    EraseOrder(order.GetOrderID(), listener);
+    InsertOrder(replacement, listener);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::AddOrders(std::span<const Order> orders, Trades& trades) {
+    TradeCollector collector{trades};
+    for (const auto& order : orders)
+        AddOrder(order, collector);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::ProcessBatch(std::span<const OrderCommand> commands, Trades& trades) {
+    TradeCollector collector{trades};
+    ProcessBatch(commands, collector);
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::ProcessBatch(std::span<const OrderCommand> commands, OrderbookListener& listener) {
+    for (const auto& command : commands) {
+        switch (command.type) {
+        case CommandType::Add:
+            AddOrder(command.ToOrder(), listener);
+            break;
+        case CommandType::Cancel:
+            CancelOrder(command.orderID, listener);
+            break;
+        case CommandType::Modify:
+            ModifyOrder(command.ToModify(), listener);
+            break;
+        case CommandType::AdvanceTime:
+            AdvanceTime(command.time, listener);
+            break;
+        case CommandType::StartAuction:
+            if (!inAuction_)
+                StartAuction(command.price);
+            break;
+        case CommandType::Uncross:
+            if (inAuction_)
+                Uncross(listener);
+            break;
+        }
+    }
+}
+
+template <typename Policy>
+std::size_t BasicOrderbook<Policy>::PendingStopCount() const noexcept {
+    return pendingStopOrders_.size();
+}
+
+template <typename Policy>
+std::size_t BasicOrderbook<Policy>::Size() const noexcept {
+    return orders_.size();
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::Reserve(std::size_t count) {
+    pool_.Reserve(count);
+    orders_.reserve(count);
+}
+
+template <typename Policy>
+OrderbookLevelInfos BasicOrderbook<Policy>::GetOrderInfos() const {
+    return GetTopLevels(std::max(bids_.size(), asks_.size()));
+}
+
+template <typename Policy>
+OrderbookLevelInfos BasicOrderbook<Policy>::GetTopLevels(std::size_t depth) const {
+    LevelInfos bidInfos, askInfos;
+    bidInfos.reserve(std::min(depth, bids_.size()));
+    askInfos.reserve(std::min(depth, asks_.size()));
+
+    for (const auto& [price, level] : bids_) {
+        if (bidInfos.size() == depth)
+            break;
+        bidInfos.push_back(LevelInfo{price, level.totalQuantity, level.orderCount});
+    }
+
+    for (const auto& [price, level] : asks_) {
+        if (askInfos.size() == depth)
+            break;
+        askInfos.push_back(LevelInfo{price, level.totalQuantity, level.orderCount});
+    }
+
+    return {bidInfos, askInfos};
+}
+
+template <typename Policy>
+std::uint64_t BasicOrderbook<Policy>::GetDepthTo(Side side, Price price) const noexcept
+    requires(Policy::EnableDepthQueries)
+{
+    return side == Side::Buy ? asks_.DepthTo(price) : bids_.DepthTo(price);
+}
+
+template <typename Policy>
+std::optional<Price> BasicOrderbook<Policy>::GetPriceForQuantity(Side side, std::uint64_t quantity) const noexcept
+    requires(Policy::EnableDepthQueries)
+{
+    auto cost = GetCostToFill(side, quantity);
+    return cost ? std::optional{ cost->worstPrice } : std::nullopt;
+}
+
+template <typename Policy>
+std::optional<FillCost> BasicOrderbook<Policy>::GetCostToFill(Side side, std::uint64_t quantity) const noexcept
+    requires(Policy::EnableDepthQueries)
+{
+    auto cost = side == Side::Buy ? asks_.Sweep(quantity) : bids_.Sweep(quantity);
+    if (quantity == 0 || cost.quantity < quantity)
+        return std::nullopt;
+    return cost;
+}
+
+template <typename Policy>
+std::size_t BasicOrderbook<Policy>::GetTopLevels(Side side, std::span<LevelInfo> out) const noexcept {
+    std::size_t count = 0;
+    auto Copy = [&](const auto& levels) {
+        for (const auto& [price, level] : levels) {
+            if (count == out.size())
+                break;
+            out[count++] = LevelInfo{price, level.totalQuantity, level.orderCount};
+        }
+    };
+
+    if (side == Side::Buy)
+        Copy(bids_);
+    else
+        Copy(asks_);
+    return count;
+}
+
+template <typename Policy>
+const Order* BasicOrderbook<Policy>::GetOrder(OrderHandle handle) const noexcept {
+    const auto* node = pool_.Get(handle);
+    return node ? node->order : nullptr;
+}
+
+template <typename Policy>
+const Order* BasicOrderbook<Policy>::GetOrder(OrderID orderID) const noexcept {
+    const auto* node = orders_.find(orderID);
+    if constexpr (Policy::EnableStops) {
+        if (!node)
+            node = pendingStopOrders_.find(orderID);
+    }
+    return node ? node->order : nullptr;
+}
+
+// Private helper methods
+template <typename Policy>
+bool BasicOrderbook<Policy>::CanAccept(const Order& order, OrderbookListener& listener) const {
+    order.Validate();
+
+    if (!Policy::EnableStops && order.IsStopOrder())
+        throw std::invalid_argument("Stop orders are not enabled for this orderbook");
+
+    // A Day order's expiry is 0 until the book stamps it, unless it is a replacement keeping its original one
+    if (order.GetOrderType() == OrderType::Day && order.GetExpiry() == 0 && sessionLength_ == 0)
+        throw std::invalid_argument("Day orders need a session schedule");
+
+    auto Reject = [&](RejectReason reason) {
+        listener.OnOrderRejected(order, reason);
+        return false;
+    };
+
+    if (orders_.contains(order.GetOrderID()) ||
+        (Policy::EnableStops && pendingStopOrders_.contains(order.GetOrderID())))
+        return Reject(RejectReason::DuplicateOrderID);
+
+    if (order.GetExpiry() != 0 && order.GetExpiry() <= GetTime())
+        return Reject(RejectReason::Expired);
+
+    // An auction only collects orders that can wait for the uncross
+    if (inAuction_ && !order.IsStopOrder() && (!order.CanRest() || order.GetOrderType() == OrderType::PostOnly))
+        return Reject(RejectReason::AuctionInProgress);
+
+    // Early exits for special order types
+    if (order.GetOrderType() == OrderType::FillAndKill &&
+        !CanMatch(order.GetSide(), order.GetPrice())) {
+        ORDERBOOK_COUNT(RejectedFillAndKill);
+        return Reject(RejectReason::NoLiquidity);
+    }
+
+    if (order.GetOrderType() == OrderType::FillOrKill &&
+        !CanFullyMatch(order.GetSide(), order.GetPrice(), order.GetRemainingQuantity(), order.GetOwner())) {
+        ORDERBOOK_COUNT(RejectedFillOrKill);
+        return Reject(RejectReason::InsufficientLiquidity);
+    }
+
+    if (order.GetOrderType() == OrderType::PostOnly &&
+        CanMatch(order.GetSide(), order.GetPrice())) {
+        ORDERBOOK_COUNT(RejectedPostOnly);
+        return Reject(RejectReason::WouldCross);
+    }
+
+    return true;
+}
+
+template <typename Policy>
+Timestamp BasicOrderbook<Policy>::NextSessionClose() const noexcept {
+    auto now = GetTime();
+    if (now < sessionClose_)
+        return sessionClose_;
+    return sessionClose_ + ((now - sessionClose_) / sessionLength_ + 1) * sessionLength_;
+}
+
+template <typename Policy>
+OrderHandle BasicOrderbook<Policy>::PlaceOrder(OrderNode* node, OrderbookListener& listener) {
+    auto& order = *node->order;
+    if (order.GetOrderType() == OrderType::Day && order.GetExpiry() == 0)
+        order.SetExpiry(NextSessionClose());
+    listener.OnOrderAccepted(order);
+
+    if constexpr (Policy::EnableStops) {
+        if (order.IsStopOrder()) {
+            pendingStopOrders_.Add(node);
+            if (order.CanExpire())
+                expiries_.Add(node);
+            return OrderPool::HandleOf(node);
+        }
+    }
+
+    // Match the order and check for triggered stops; an auction only collects it
+    auto match = inAuction_ ? MatchResult{} : MatchAggressiveOrder(order, listener);
+    if constexpr (Policy::EnableStops) {
+        if (match.lastTradePrice)
+            CheckAndTriggerStopOrders(*match.lastTradePrice, listener);
+    }
+
+    if (match.aggressorCancelled) {
+        listener.OnOrderCancelled(order);
+        pool_.Release(node);
+        return {};
+    }
+
+    if (order.IsFilled()) {
+        pool_.Release(node);
+        return {};
+    }
+
+    // Rest if GTC, PostOnly, GTD or Day; remainders of other types are cancelled
+    if (!order.CanRest()) {
+        listener.OnOrderCancelled(order);
+        pool_.Release(node);
+        return {};
+    }
+
+    auto& level = order.GetSide() == Side::Buy ? bids_[order.GetPrice()] : asks_[order.GetPrice()];
+    if (level.empty())
+        ORDERBOOK_COUNT(LevelsCreated);
+    auto before = level.totalQuantity;
+    auto countBefore = level.orderCount;
+    // An iceberg that traded on the way in rests with a full peak
+    order.Replenish();
+    level.PushBack(node);
+    NoteLevelChange(order.GetSide(), order.GetPrice(), before, countBefore, level);
+    listener.OnOrderRested(order);
+
+    orders_.insert(order.GetOrderID(), node);
+    if (order.CanExpire())
+        expiries_.Add(node);
+    return OrderPool::HandleOf(node);
+}
+
+template <typename Policy>
+bool BasicOrderbook<Policy>::CanMatch(Side side, Price price) const {
+    return side == Side::Buy ? CanMatch<Side::Buy>(price) : CanMatch<Side::Sell>(price);
+}
+
+template <typename Policy>
+template <Side S>
+bool BasicOrderbook<Policy>::CanMatch(Price price) const {
+    const auto& levels = LevelsOf<Opposite(S)>();
+    if (levels.empty())
+        return false;
+
+    const auto& [bestPrice, _] = *levels.begin();
+    return Crosses<S>(price, bestPrice);
+}
+
+template <typename Policy>
+bool BasicOrderbook<Policy>::CanFullyMatch(Side side, Price price, Quantity quantity, OwnerID owner) const {
+    return side == Side::Buy ? CanFullyMatch<Side::Buy>(price, quantity, owner)
+                             : CanFullyMatch<Side::Sell>(price, quantity, owner);
+}
+
+template <typename Policy>
+template <Side S>
+bool BasicOrderbook<Policy>::CanFullyMatch(Price price, Quantity quantity, OwnerID owner) const {
+    if (!CanMatch<S>(price))
+        return false;
+
+    if (owner != NoOwner && PreventsSelfTrades())
+        return CanFullyMatchOthers<S>(price, quantity, owner);
+
+    Quantity availableQuantity = 0;
+    for (const auto& [levelPrice, level] : LevelsOf<Opposite(S)>()) {
+        if (!Crosses<S>(price, levelPrice))
+            break;
+
+        availableQuantity += level.totalQuantity + level.hiddenQuantity;
+        if (availableQuantity >= quantity)
+            return true;
+    }
+
+    return false;
+}
+
+// Same-owner orders cannot count towards a FillOrKill under self-trade prevention:
+// CancelOldest skips them, every other mode would stop or shrink the order there.
+// That needs the orders themselves rather than level totals.
+template <typename Policy>
+template <Side S>
+bool BasicOrderbook<Policy>::CanFullyMatchOthers(Price price, Quantity quantity, OwnerID owner) const {
+    Quantity availableQuantity = 0;
+    for (const auto& [levelPrice, level] : LevelsOf<Opposite(S)>()) {
+        if (!Crosses<S>(price, levelPrice))
+            return false;
+
+        for (const auto& resting : level.orders) {
+            if (resting.GetOwner() == owner) {
+                if (selfTradePrevention_ == SelfTradePrevention::CancelOldest)
+                    continue;
+                return false;
+            }
+
+            availableQuantity += resting.GetRemainingQuantity();
+            if (availableQuantity >= quantity)
+                return true;
+        }
+    }
+    return false;
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::CheckAndTriggerStopOrders(Price tradePrice, OrderbookListener& listener) {
+    if (!pendingStopOrders_.CouldTrigger(tradePrice))
+        return;
+
+    ORDERBOOK_TIME_SECTION(CheckAndTriggerStopOrders);
+
+    // Cascades are handled breadth-first from a work queue rather than by
+    // recursion: each triggered order's last trade can append more stops
+    triggeredStops_.clear();
+    pendingStopOrders_.TakeTriggered(tradePrice, triggeredStops_);
+
+#if ORDERBOOK_INSTRUMENTATION
+    // Stops set off by the same generation sit together in the queue
+    std::size_t generationEnd = triggeredStops_.size();
+    std::uint64_t depth = generationEnd ? 1 : 0;
+#endif
+
+    for (std::size_t next = 0; next < triggeredStops_.size(); ++next) {
+#if ORDERBOOK_INSTRUMENTATION
+        if (next == generationEnd) {
+            generationEnd = triggeredStops_.size();
+            ++depth;
+        }
+#endif
+        auto* triggered = triggeredStops_[next];
+        auto& order = *triggered->order;
+        expiries_.Remove(triggered);
+        ORDERBOOK_COUNT(StopTriggers);
+        listener.OnStopTriggered(order);
+
+        auto match = MatchAggressiveOrder(order, listener);
+        if (match.lastTradePrice)
+            pendingStopOrders_.TakeTriggered(*match.lastTradePrice, triggeredStops_);
+
+        if (!order.IsFilled() || match.aggressorCancelled)
+            listener.OnOrderCancelled(order);
+        pool_.Release(triggered);
+    }
+
+#if ORDERBOOK_INSTRUMENTATION
+    if constexpr (Instrumented) {
+        if (depth > 0) {
+            ORDERBOOK_COUNT(StopCascades);
+            instrumentation::Local().maxCascadeDepth.Max(depth);
+        }
+    }
+#endif
+
+    triggeredStops_.clear();
+}
+
+template <typename Policy>
+template <Side S>
+bool BasicOrderbook<Policy>::MatchAtPriceLevel(Order& aggressive, PriceLevel& restingOrders,
+                                               OrderbookListener& listener) {
+    while (!restingOrders.empty() && !aggressive.IsFilled()) {
+        OrderNode* restingNode = restingOrders.orders.Front();
+        Order& restingOrder = *restingNode->order;
+
+        // Owners rarely match, so this is one well-predicted compare per fill
+        if constexpr (Policy::EnableSelfTradePrevention) {
+            if (aggressive.GetOwner() == restingOrder.GetOwner() && aggressive.GetOwner() != NoOwner &&
+                selfTradePrevention_ != SelfTradePrevention::None) {
+                if (!PreventSelfTrade(aggressive, restingOrders, restingNode, listener))
+                    return false;
+                continue;
+            }
+        }
+
+        // Resting icebergs trade only their displayed peak
+        Quantity quantity = std::min(restingOrder.GetVisibleQuantity(),
+                                     aggressive.GetRemainingQuantity());
+
+        // Trade at maker's price (resting order)
+        Price tradePrice = restingOrder.GetPrice();
+
+        aggressive.Fill(quantity);
+        restingOrder.Fill(quantity);
+        restingOrders.Reduce(quantity);
+        ORDERBOOK_COUNT(Fills);
+
+        // Report trade with correct bid/ask order
+        TradeInfo aggressiveInfo{aggressive.GetOrderID(), tradePrice, quantity, aggressive.GetOwner()};
+        TradeInfo restingInfo{restingOrder.GetOrderID(), tradePrice, quantity, restingOrder.GetOwner()};
+        if constexpr (S == Side::Buy)
+            listener.OnTrade(Trade{ aggressiveInfo, restingInfo });
+        else
+            listener.OnTrade(Trade{ restingInfo, aggressiveInfo });
+
+        SettleRestingFill(restingOrders, restingNode, listener);
+    }
+
+    return true;
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::SettleRestingFill(PriceLevel& restingOrders, OrderNode* restingNode,
+                                               OrderbookListener& listener) {
+    auto& restingOrder = *restingNode->order;
+    if (restingOrder.IsFilled()) {
+        orders_.erase(restingOrder.GetOrderID());
+        expiries_.Remove(restingNode);
+        restingOrders.Remove(restingNode);
+        pool_.Release(restingNode);
+    } else if (restingOrder.GetVisibleQuantity() == 0) {
+        // Iceberg peak used up: the same node shows a fresh peak at the back of the queue
+        restingOrders.Remove(restingNode);
+        restingOrder.Replenish();
+        restingOrders.PushBack(restingNode);
+        ORDERBOOK_COUNT(IcebergReplenishments);
+        listener.OnOrderReplenished(restingOrder);
+    }
+}
+
+template <typename Policy>
+bool BasicOrderbook<Policy>::PreventSelfTrade(Order& aggressive, PriceLevel& restingOrders, OrderNode* restingNode,
+                                              OrderbookListener& listener) {
+    ORDERBOOK_COUNT(SelfTradesPrevented);
+    auto& resting = *restingNode->order;
+
+    switch (selfTradePrevention_) {
+    case SelfTradePrevention::CancelOldest:
+        CancelRestingOrder(restingOrders, restingNode, listener);
+        return true;
+    case SelfTradePrevention::CancelBoth:
+        CancelRestingOrder(restingOrders, restingNode, listener);
+        return false;
+    case SelfTradePrevention::DecrementAndCancel: {
+        auto aggressiveQuantity = aggressive.GetRemainingQuantity();
+        auto restingQuantity = resting.GetRemainingQuantity();
+        if (restingQuantity > aggressiveQuantity) {
+            auto visible = resting.GetVisibleQuantity();
+            auto hidden = resting.GetHiddenQuantity();
+            resting.Reduce(aggressiveQuantity);
+            restingOrders.Reduce(visible - resting.GetVisibleQuantity(), hidden - resting.GetHiddenQuantity());
+            listener.OnOrderReduced(resting);
+            return false;
+        }
+
+        CancelRestingOrder(restingOrders, restingNode, listener);
+        if (restingQuantity == aggressiveQuantity)
+            return false;
+        aggressive.Reduce(restingQuantity);
+        return true;
+    }
+    case SelfTradePrevention::CancelNewest:
+    case SelfTradePrevention::None:
+        break;
+    }
+
+    return false;
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::CancelRestingOrder(PriceLevel& restingOrders, OrderNode* restingNode,
+                                                OrderbookListener& listener) {
+    orders_.erase(restingNode->order->GetOrderID());
+    expiries_.Remove(restingNode);
+    restingOrders.Remove(restingNode);
+    listener.OnOrderCancelled(*restingNode->order);
+    pool_.Release(restingNode);
+}
+
+template <typename Policy>
+auto BasicOrderbook<Policy>::MatchAggressiveOrder(Order& order, OrderbookListener& listener) -> MatchResult {
+    ORDERBOOK_TIME_SECTION(MatchAggressiveOrder);
+    return order.GetSide() == Side::Buy ? MatchAggressiveOrder<Side::Buy>(order, listener)
+                                        : MatchAggressiveOrder<Side::Sell>(order, listener);
+}
+
+template <typename Policy>
+template <Side S>
+auto BasicOrderbook<Policy>::MatchAggressiveOrder(Order& order, OrderbookListener& listener) -> MatchResult {
+    constexpr Side RestingSide = Opposite(S);
+    auto& levels = LevelsOf<RestingSide>();
+    MatchResult result;
+
+    while (!levels.empty() && !order.IsFilled() && !result.aggressorCancelled) {
+        auto [levelPrice, restingOrders] = *levels.begin();
+
+        if (!Crosses<S>(order.GetPrice(), levelPrice))
+            break;
+
+        auto before = restingOrders.totalQuantity;
+        auto countBefore = restingOrders.orderCount;
+        auto filledBefore = order.GetFilledQuantity();
+        result.aggressorCancelled = !MatchAtPriceLevel<S>(order, restingOrders, listener);
+        NoteLevelChange(RestingSide, levelPrice, before, countBefore, restingOrders);
+        // Only stops care where the last trade printed
+        if (Policy::EnableStops && order.GetFilledQuantity() != filledBefore)
+            result.lastTradePrice = levelPrice;
+
+        if (restingOrders.empty()) {
+            ORDERBOOK_COUNT(LevelsDestroyed);
+            levels.erase(levelPrice);
+        }
+    }
+
+    return result;
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::PublishLevelUpdates(OrderbookListener& listener) {
+    if (levelChanges_.empty())
+        return;
+
+    auto distinct = FoldLevelChanges();
+
+    for (std::size_t i = 0; i < distinct; ++i) {
+        const auto& change = levelChanges_[i];
+        if (change.before != change.after || change.countBefore != change.countAfter)
+            listener.OnLevelUpdate(LevelUpdate{ ++levelSequence_, change.side, change.price, change.after,
+                                                change.countAfter });
+    }
+
+    if (inAuction_ && MovesUncross(distinct)) {
+        auto indication = ComputeUncross();
+        if (indication != auctionIndication_) {
+            auctionIndication_ = indication;
+            listener.OnAuctionIndication(indication);
+        }
+    }
+
+    levelChanges_.clear();
+}
+
+template <typename Policy>
+std::size_t BasicOrderbook<Policy>::FoldLevelChanges() {
+    // Fold repeat touches of a level into its first entry: first `before`, last `after`.
+    // A command touches a handful of levels, so a linear scan beats hashing.
+    constexpr std::size_t LinearFoldLimit = 32;
+    if (levelChanges_.size() <= LinearFoldLimit) {
+        std::size_t distinct = 0;
+        for (const auto& change : levelChanges_) {
+            auto first = std::find_if(levelChanges_.begin(), levelChanges_.begin() + distinct, [&](const auto& seen) {
+                return seen.side == change.side && seen.price == change.price;
+            });
+            if (first != levelChanges_.begin() + distinct) {
+                first->after = change.after;
+                first->countAfter = change.countAfter;
+            }
+            else
+                levelChanges_[distinct++] = change;
+        }
+        return distinct;
+    }
+
+    // Mass removals (an expiry sweep) touch too many levels to scan; index the
+    // distinct entries in an open-addressed table instead
+    auto capacity = std::bit_ceil(levelChanges_.size() * 2);
+    auto shift = 64 - std::countr_zero(capacity);
+    levelChangeIndex_.assign(capacity, 0);
+
+    std::size_t distinct = 0;
+    for (auto change : levelChanges_) {
+        auto key = static_cast<std::uint64_t>(change.price) << 1 | (change.side == Side::Sell ? 1 : 0);
+        for (auto slot = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);;
+             slot = (slot + 1) & (capacity - 1)) {
+            auto& index = levelChangeIndex_[slot];  // entry + 1, 0 for an empty slot
+            if (index == 0) {
+                levelChanges_[distinct] = change;
+                index = ++distinct;
+                break;
+            }
+            if (levelChanges_[index - 1].side == change.side && levelChanges_[index - 1].price == change.price) {
+                levelChanges_[index - 1].after = change.after;
+                levelChanges_[index - 1].countAfter = change.countAfter;
+                break;
+            }
+        }
+    }
+    return distinct;
+}
+
+// Call auctions
+template <typename Policy>
+void BasicOrderbook<Policy>::StartAuction(Price referencePrice) {
+    if (inAuction_)
+        throw std::logic_error("An auction is already in progress");
+
+    inAuction_ = true;
+    referencePrice_ = referencePrice;
+    auctionIndication_ = ComputeUncross();
+}
+
+template <typename Policy>
+AuctionIndication BasicOrderbook<Policy>::Uncross(Trades& trades) {
+    TradeCollector collector{trades};
+    return Uncross(collector);
+}
+
+template <typename Policy>
+AuctionIndication BasicOrderbook<Policy>::Uncross(OrderbookListener& listener) {
+    if (!inAuction_)
+        throw std::logic_error("There is no auction to uncross");
+    LevelChangeGuard guard{ levelChanges_ };
+
+    auto uncross = ComputeUncross();
+    inAuction_ = false;
+    auctionIndication_ = {};
+    listener.OnUncross(uncross);
+    if (uncross.volume != 0) {
+        uncross.volume = ExecuteUncross(uncross.price, listener);
+        if constexpr (Policy::EnableStops) {
+            if (uncross.volume != 0)
+                CheckAndTriggerStopOrders(uncross.price, listener);
+        }
+    }
+
+    PublishLevelUpdates(listener);
+    return uncross;
+}
+
+template <typename Policy>
+AuctionIndication BasicOrderbook<Policy>::ComputeUncross() {
+    crossedBand_ = { 1, 0 };
+    if (bids_.empty() || asks_.empty())
+        return {};
+
+    const auto& [bestBid, bidLevel] = *bids_.begin();
+    const auto& [bestAsk, askLevel] = *asks_.begin();
+    crossedBand_ = { bestAsk, bestBid };
+    if (bestBid < bestAsk)
+        return {};
+
+    // Only the prices of crossed levels can trade the most volume. Supply at a
+    // price is every ask at or below it: start from all crossed asks and give
+    // them back as the sweep passes them on its way down
+    crossedAsks_.clear();
+    std::uint64_t supply = 0;
+    for (const auto& [price, level] : asks_) {
+        if (price > bestBid)
+            break;
+        crossedAsks_.push_back(LevelInfo{ price, level.totalQuantity + level.hiddenQuantity });
+        supply += level.totalQuantity + level.hiddenQuantity;
+    }
+
+    auto Distance = [this](Price price) { return std::abs(std::int64_t{ price } - referencePrice_); };
+    auto Better = [&](const AuctionIndication& lhs, const AuctionIndication& rhs) {
+        if (lhs.volume != rhs.volume)
+            return lhs.volume > rhs.volume;
+        if (std::abs(lhs.imbalance) != std::abs(rhs.imbalance))
+            return std::abs(lhs.imbalance) < std::abs(rhs.imbalance);
+        if (Distance(lhs.price) != Distance(rhs.price))
+            return Distance(lhs.price) < Distance(rhs.price);
+        return lhs.price < rhs.price;
+    };
+
+    // One sweep down the crossed band, merging bid levels with the crossed asks.
+    // Demand at a price is every bid at or above it
+    AuctionIndication best;
+    std::uint64_t demand = 0;
+    auto bid = bids_.begin();
+    auto ask = crossedAsks_.size();
+    while (true) {
+        bool bidsLeft = bid != bids_.end() && (*bid).first >= bestAsk;
+        if (!bidsLeft && ask == 0)
+            break;
+
+        auto price = !bidsLeft  ? crossedAsks_[ask - 1].price_
+                     : ask == 0 ? (*bid).first
+                                : std::max((*bid).first, crossedAsks_[ask - 1].price_);
+        if (bidsLeft && (*bid).first == price) {
+            const auto& level = (*bid).second;
+            demand += level.totalQuantity + level.hiddenQuantity;
+            ++bid;
+        }
+
+        AuctionIndication candidate{ price, std::min(demand, supply),
+                                     static_cast<std::int64_t>(demand) - static_cast<std::int64_t>(supply) };
+        if (Better(candidate, best))
+            best = candidate;
+
+        if (ask > 0 && crossedAsks_[ask - 1].price_ == price)
+            supply -= crossedAsks_[--ask].quantity_;
+    }
+
+    return best;
+}
+
+// Only levels inside the crossed band take part in the uncross, so changes
+// elsewhere that leave the band where it was cannot move the equilibrium
+template <typename Policy>
+bool BasicOrderbook<Policy>::MovesUncross(std::size_t distinctChanges) const {
+    if (bids_.empty() || asks_.empty())
+        return true;
+
+    const auto& [bestBid, bidLevel] = *bids_.begin();
+    const auto& [bestAsk, askLevel] = *asks_.begin();
+    if (crossedBand_ != std::pair{ bestAsk, bestBid })
+        return true;
+
+    return std::any_of(levelChanges_.begin(), levelChanges_.begin() + distinctChanges, [&](const LevelChange& change) {
+        return change.price >= bestAsk && change.price <= bestBid;
+    });
+}
+
+template <typename Policy>
+std::uint64_t BasicOrderbook<Policy>::ExecuteUncross(Price price, OrderbookListener& listener) {
+    std::uint64_t volume = 0;
+    while (!bids_.empty() && !asks_.empty()) {
+        auto [bidPrice, bids] = *bids_.begin();
+        auto [askPrice, asks] = *asks_.begin();
+        if (bidPrice < price || askPrice > price)
+            break;
+
+        auto bidsBefore = bids.totalQuantity;
+        auto asksBefore = asks.totalQuantity;
+        auto bidCountBefore = bids.orderCount;
+        auto askCountBefore = asks.orderCount;
+        volume += UncrossLevels(bids, asks, price, listener);
+        NoteLevelChange(Side::Buy, bidPrice, bidsBefore, bidCountBefore, bids);
+        NoteLevelChange(Side::Sell, askPrice, asksBefore, askCountBefore, asks);
+
+        if (bids.empty()) {
+            ORDERBOOK_COUNT(LevelsDestroyed);
+            bids_.erase(bidPrice);
+        }
+        if (asks.empty()) {
+            ORDERBOOK_COUNT(LevelsDestroyed);
+            asks_.erase(askPrice);
+        }
+    }
+    return volume;
+}
+
+template <typename Policy>
+std::uint64_t BasicOrderbook<Policy>::UncrossLevels(PriceLevel& bids, PriceLevel& asks, Price price,
+                                                    OrderbookListener& listener) {
+    std::uint64_t volume = 0;
+    while (!bids.empty() && !asks.empty()) {
+        OrderNode* bidNode = bids.orders.Front();
+        OrderNode* askNode = asks.orders.Front();
+        Order& bid = *bidNode->order;
+        Order& ask = *askNode->order;
+
+        if constexpr (Policy::EnableSelfTradePrevention) {
+            if (bid.GetOwner() == ask.GetOwner() && bid.GetOwner() != NoOwner &&
+                selfTradePrevention_ != SelfTradePrevention::None) {
+                // No aggressor to pick a mode by: shrink both, as DecrementAndCancel does
+                ORDERBOOK_COUNT(SelfTradesPrevented);
+                auto quantity = std::min(bid.GetRemainingQuantity(), ask.GetRemainingQuantity());
+                for (auto [level, node] : { std::pair{ &bids, bidNode }, std::pair{ &asks, askNode } }) {
+                    auto& order = *node->order;
+                    if (order.GetRemainingQuantity() == quantity) {
+                        CancelRestingOrder(*level, node, listener);
+                        continue;
+                    }
+                    auto visible = order.GetVisibleQuantity();
+                    auto hidden = order.GetHiddenQuantity();
+                    order.Reduce(quantity);
+                    level->Reduce(visible - order.GetVisibleQuantity(), hidden - order.GetHiddenQuantity());
+                    listener.OnOrderReduced(order);
+                }
+                continue;
+            }
+        }
+
+        // Icebergs trade their displayed peak at a time, refilling at the back of their level
+        Quantity quantity = std::min(bid.GetVisibleQuantity(), ask.GetVisibleQuantity());
+        bid.Fill(quantity);
+        ask.Fill(quantity);
+        bids.Reduce(quantity);
+        asks.Reduce(quantity);
+        ORDERBOOK_COUNT(Fills);
+        listener.OnTrade(Trade{ TradeInfo{ bid.GetOrderID(), price, quantity, bid.GetOwner() },
+                                TradeInfo{ ask.GetOrderID(), price, quantity, ask.GetOwner() } });
+        volume += quantity;
+
+        SettleRestingFill(bids, bidNode, listener);
+        SettleRestingFill(asks, askNode, listener);
+    }
+    return volume;
+}
+
+// Snapshots; the record encoding is in SnapshotFormat.h
+template <typename Policy>
+std::vector<std::byte> BasicOrderbook<Policy>::SaveSnapshot() const {
+    using namespace snapshot_format;
+    auto resting = orders_.size();
+    auto stops = pendingStopOrders_.size();
+
+    std::vector<std::byte> snapshot(HeaderSize + (resting + stops) * RecordSize);
+    auto* out = snapshot.data() + HeaderSize;
+    auto Write = [&](const Order& order) {
+        EncodeOrder(out, order);
+        out += RecordSize;
+    };
+
+    for (const auto& [price, level] : bids_)
+        for (const auto& order : level.orders)
+            Write(order);
+    for (const auto& [price, level] : asks_)
+        for (const auto& order : level.orders)
+            Write(order);
+    pendingStopOrders_.ForEach(Write);
+
+    auto* header = snapshot.data();
+    std::memcpy(header, Magic, sizeof(Magic));
+    StoreLE(header + 8, Version);
+    StoreLE(header + 12, static_cast<std::uint32_t>(RecordSize));
+    StoreLE(header + 16, static_cast<std::uint64_t>(resting));
+    StoreLE(header + 24, static_cast<std::uint64_t>(stops));
+    StoreLE(header + 32, PayloadChecksum(std::span{ snapshot }.subspan(HeaderSize)));
+    StoreLE(header + 40, GetTime());
+    StoreLE(header + 48, sessionClose_);
+    StoreLE(header + 56, sessionLength_);
+    header[64] = static_cast<std::byte>(inAuction_);
+    StoreLE(header + 68, referencePrice_);
+
+    return snapshot;
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::SaveSnapshot(const std::string& path) const {
+    WriteFileAtomically(path, SaveSnapshot());
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::LoadSnapshot(const std::string& path) {
+    MappedFile file{path};
+    LoadSnapshot(file.data());
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::LoadSnapshot(std::span<const std::byte> snapshot) {
+    using namespace snapshot_format;
+    if (!orders_.empty() || pendingStopOrders_.size() != 0)
+        throw std::logic_error("Snapshots can only be loaded into an empty orderbook");
+
+    // Validate everything before touching the book
+    const auto* header = snapshot.data();
+    // Magic, version and record size; the rest of the header depends on the version
+    if (snapshot.size() < sizeof(Magic) + 8 || std::memcmp(header, Magic, sizeof(Magic)) != 0)
+        throw std::runtime_error("Not an orderbook snapshot");
+
+    auto version = LoadLE<std::uint32_t>(header + 8);
+    auto recordSize = RecordSizeOf(version);
+    if (version == 0 || version > Version || LoadLE<std::uint32_t>(header + 12) != recordSize)
+        throw std::runtime_error(std::format("Unsupported snapshot version ({})", version));
+
+    auto headerSize = HeaderSizeOf(version);
+    if (snapshot.size() < headerSize)
+        throw std::runtime_error("Snapshot is truncated");
+
+    auto resting = LoadLE<std::uint64_t>(header + 16);
+    auto stops = LoadLE<std::uint64_t>(header + 24);
+    auto payload = snapshot.subspan(headerSize);
+    if ((payload.size() % recordSize) != 0 || payload.size() / recordSize != resting + stops)
+        throw std::runtime_error("Snapshot is truncated");
+
+    if (PayloadChecksum(payload) != LoadLE<std::uint64_t>(header + 32))
+        throw std::runtime_error("Snapshot checksum mismatch");
+
+    if (!Policy::EnableStops && stops != 0)
+        throw std::runtime_error("Snapshot has stop orders and this orderbook has no stops");
+
+    auto time = LoadLE<Timestamp>(header + 40);
+    std::optional<SessionSchedule> session;
+    if (version >= 5 && LoadLE<Timestamp>(header + 56) != 0)
+        session = SessionSchedule{ LoadLE<Timestamp>(header + 48), LoadLE<Timestamp>(header + 56) };
+    bool auction = version >= 6 && header[64] != std::byte{ 0 };
+    auto referencePrice = version >= 6 ? LoadLE<Price>(header + 68) : 0;
+
+    // Outside an auction resting orders that cross would have traded, and nothing would uncross them
+    std::optional<Price> bestBid, bestAsk;
+    auto count = static_cast<std::size_t>(resting + stops);
+    for (std::size_t record = 0; record < count; ++record) {
+        const auto* in = payload.data() + record * recordSize;
+        CheckOrder(in, recordSize, record >= resting, time, record);
+        if (record >= resting)
+            continue;
+        auto price = LoadLE<Price>(in + 16);
+        if (in[1] == static_cast<std::byte>(Side::Buy))
+            bestBid = std::max(price, bestBid.value_or(price));
+        else
+            bestAsk = std::min(price, bestAsk.value_or(price));
+    }
+    if (bestBid && bestAsk && *bestBid >= *bestAsk && !auction && !inAuction_)
+        throw std::runtime_error(std::format("Snapshot's resting orders cross ({} bid, {} asked) outside an auction",
+                                             *bestBid, *bestAsk));
+
+    // The book is empty, so its expiry wheel is too
+    auto previousTime = GetTime();
+    expiries_.Reset(time);
+
+    pool_.Reserve(count);
+    orders_.reserve(static_cast<std::size_t>(resting));
+    pendingStopOrders_.reserve(static_cast<std::size_t>(stops));
+
+    // One pass: decode each record straight into a pool node and link it.
+    // Records of one level are contiguous, so the level lookup is done once per level.
+    PriceLevel* level = nullptr;
+    std::optional<std::pair<Side, Price>> levelKey;
+
+    for (std::size_t record = 0; record < count; ++record) {
+        auto* node = pool_.Allocate();
+        const auto& order = node->storage.emplace(DecodeOrder(payload.data() + record * recordSize, recordSize));
+        node->order = &node->storage.value();
+
+        // Stops follow every resting order, so a resting record only has to be checked against
+        // the resting orders before it, and the insert itself does that
+        bool duplicate = record < resting
+            ? !orders_.insert(order.GetOrderID(), node)
+            : orders_.contains(order.GetOrderID()) || pendingStopOrders_.contains(order.GetOrderID());
+
+        if (duplicate) {
+            auto orderID = order.GetOrderID();
+            pool_.Release(node);
+            UndoSnapshotLoad(payload, recordSize, record);
+            expiries_.Reset(previousTime);
+            throw std::runtime_error(std::format("Snapshot contains order ({}) twice", orderID));
+        }
+
+        if (order.CanExpire())
+            expiries_.Add(node);
+
+        if (record >= resting) {
+            pendingStopOrders_.Add(node);
+            continue;
+        }
+
+        std::pair key{ order.GetSide(), order.GetPrice() };
+        if (key != levelKey) {
+            level = order.GetSide() == Side::Buy ? &bids_[order.GetPrice()] : &asks_[order.GetPrice()];
+            levelKey = key;
+        }
+        level->PushBack(node);
+        AdjustDepth(order.GetSide(), order.GetPrice(), order.GetVisibleQuantity());
+    }
+
+    if (session)
+        SetSessionSchedule(*session);
+    if (auction) {
+        inAuction_ = true;
+        referencePrice_ = referencePrice;
+    }
+    if (inAuction_)
+        auctionIndication_ = ComputeUncross();
+}
+
+template <typename Policy>
+void BasicOrderbook<Policy>::UndoSnapshotLoad(std::span<const std::byte> payload, std::size_t recordSize,
+                                              std::size_t loaded) {
+    for (std::size_t record = 0; record < loaded; ++record) {
+        auto orderID = LoadLE<OrderID>(payload.data() + record * recordSize + 8);
+        EraseOrder(orderID, nullListener);
+    }
+
+    // The loaded orders were never published, so neither is their removal
+    levelChanges_.clear();
+}
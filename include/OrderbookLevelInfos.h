@@ -1,13 +1,63 @@
 #pragma once
 #include "Types.h"
+#include <cstdint>
+#include <span>
 #include <vector>
 
 struct LevelInfo {
     Price price_;
     Quantity quantity_;
+    std::uint32_t orderCount_{ 0 };   // orders resting at the level
+
+    bool operator==(const LevelInfo&) const = default;
 };
 using LevelInfos = std::vector<LevelInfo>;
 
+/**
+ * Net change to one price level made by one command.
+ * quantity and orderCount are the level's new aggregates; zero quantity means
+ * the level is gone. Sequence numbers are per book and increase by one per update.
+ */
+struct LevelUpdate {
+    std::uint64_t sequence{ 0 };
+    Side side{ Side::Buy };
+    Price price{ 0 };
+    Quantity quantity{ 0 };
+    std::uint32_t orderCount{ 0 };
+
+    bool operator==(const LevelUpdate&) const = default;
+};
+using LevelUpdates = std::vector<LevelUpdate>;
+
+/**
+ * What taking a quantity from one side of the book would come to, walking its
+ * levels best first at displayed quantity.
+ */
+struct FillCost {
+    std::uint64_t quantity{ 0 };
+    std::uint64_t notional{ 0 };   // sum of price x quantity over every level taken from
+    Price worstPrice{ 0 };         // last level reached
+
+    [[nodiscard]] double Vwap() const noexcept {
+        return quantity == 0 ? 0.0 : static_cast<double>(notional) / static_cast<double>(quantity);
+    }
+
+    bool operator==(const FillCost&) const = default;
+};
+
+/**
+ * Where a call auction uncrosses: the equilibrium price, the volume that
+ * trades there, and the surplus left over (positive for buyers, negative for
+ * sellers). Volume 0 means nothing crosses; price and imbalance are then 0.
+ */
+struct AuctionIndication {
+    Price price{ 0 };
+    std::uint64_t volume{ 0 };
+    std::int64_t imbalance{ 0 };
+
+    bool operator==(const AuctionIndication&) const = default;
+};
+
 /**
  * View of the orderbook showing total quantities at each price level
  * Used for market data analysis
@@ -19,8 +69,26 @@ public:
     const LevelInfos& GetBids() const { return bids_; }
     const LevelInfos& GetAsks() const { return asks_; }
 
+    /**
+     * Applies one level update in place, keeping both sides best first.
+     * The level is found by binary search; adding or removing one shifts the levels behind it.
+     */
+    void Apply(const LevelUpdate& update);
 
 private:
     LevelInfos bids_;
     LevelInfos asks_;
 };
+
+/**
+ * Rolls a depth snapshot forward by a stream of level updates, so a
+ * downstream copy of the book stays in sync without re-reading every level.
+ *
+ * Pass the snapshot by move to update it without a copy.
+ * Updates at or below snapshotSequence are already in the snapshot and are
+ * skipped, so the stream may start before the snapshot was taken.
+ *
+ * @throws std::runtime_error if the stream skips a sequence number
+ */
+OrderbookLevelInfos ApplyLevelUpdates(OrderbookLevelInfos snapshot, std::uint64_t snapshotSequence,
+                                      std::span<const LevelUpdate> updates);
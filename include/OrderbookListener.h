@@ -0,0 +1,79 @@
+#pragma once
+#include "Order.h"
+#include "OrderbookLevelInfos.h"
+#include "Trade.h"
+
+// Why an order was turned away before it reached the book
+enum class RejectReason {
+    DuplicateOrderID,
+    NoLiquidity,           // FillAndKill with nothing to match against
+    InsufficientLiquidity, // FillOrKill that cannot be filled completely
+    WouldCross,            // PostOnly that would take liquidity
+    Expired,               // GoodTillDate whose expiry is not after the book's time
+    AuctionInProgress      // FillAndKill, FillOrKill, Market or PostOnly sent during an auction
+};
+
+/**
+ * Receives orderbook events as they happen on the matching path.
+ *
+ * All callbacks default to no-ops, so consumers override only what they need.
+ * Events for one command are delivered in order:
+ * accepted/rejected, stop triggers and trades, then either the remainder
+ * resting or its cancellation, then one level update per price level whose
+ * aggregate quantity the command changed, and last, during an auction, the
+ * new indicative uncross if the command moved it. Uncross reports OnUncross
+ * before its trades, which have no aggressor.
+ */
+class OrderbookListener {
+public:
+    virtual ~OrderbookListener() = default;
+
+    // Order passed validation and entered the book (matching, resting or parked as a stop)
+    virtual void OnOrderAccepted(const Order& /*order*/) { }
+
+    virtual void OnOrderRejected(const Order& /*order*/, RejectReason /*reason*/) { }
+
+    virtual void OnTrade(const Trade& /*trade*/) { }
+
+    // Unfilled remainder joined the back of its price level (displaying only the peak if an iceberg)
+    virtual void OnOrderRested(const Order& /*order*/) { }
+
+    // Order left the book unfilled: explicit cancel, IOC/Market/stop remainder,
+    // self-trade prevention or expiry. It was resting (visible in depth) exactly when
+    // order.CanRest() holds, unless it is the command's own incoming order, which
+    // self-trade prevention can cancel before it rests.
+    virtual void OnOrderCancelled(const Order& /*order*/) { }
+
+    // Resting order was shrunk in place (by a modify or a self-trade decrement) and kept its queue position
+    virtual void OnOrderReduced(const Order& /*order*/) { }
+
+    // Resting iceberg's displayed peak was used up and refilled from its reserve;
+    // the order is now at the back of its level showing GetVisibleQuantity()
+    virtual void OnOrderReplenished(const Order& /*order*/) { }
+
+    // Pending stop was triggered and is about to match
+    virtual void OnStopTriggered(const Order& /*order*/) { }
+
+    // Net L2 change for one level, coalesced over the whole command
+    virtual void OnLevelUpdate(const LevelUpdate& /*update*/) { }
+
+    // Where the auction in progress would now uncross (see Orderbook::StartAuction)
+    virtual void OnAuctionIndication(const AuctionIndication& /*indication*/) { }
+
+    // Auction is ending at uncross.price; the trades that follow are between resting orders
+    virtual void OnUncross(const AuctionIndication& /*uncross*/) { }
+};
+
+/**
+ * Listener that appends every trade to a Trades buffer.
+ * Backs the Trades-returning Orderbook API.
+ */
+class TradeCollector final : public OrderbookListener {
+public:
+    explicit TradeCollector(Trades& trades) : trades_{ trades } { }
+
+    void OnTrade(const Trade& trade) override { trades_.push_back(trade); }
+
+private:
+    Trades& trades_;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "PriceLevel.h"
+#include "PriceLevels.h"
+#include <concepts>
+#include <functional>
+
+/**
+ * Compile-time configuration of a BasicOrderbook.
+ *
+ * Levels<Compare> is the container one side of the book keeps its levels in,
+ * best first under Compare. It needs PriceLevels' interface over PriceLevel:
+ * begin/end yielding (price, level) pairs, operator[], find, erase, empty and
+ * size. A book can only be built from a LadderConfig if its container can.
+ *
+ * The switches leave whole features out of the compiled book:
+ *  - EnableStops: without it, stop orders are refused with std::invalid_argument
+ *    and trades never look for stops to trigger
+ *  - EnableSelfTradePrevention: without it, SetSelfTradePrevention does not
+ *    exist and the matching loop has no owner check
+ *  - EnableInstrumentation: without it, the book has no ORDERBOOK_INSTRUMENTATION
+ *    hooks even in builds that turn them on
+ *  - EnableDepthQueries: GetDepthTo, GetPriceForQuantity and GetCostToFill; the
+ *    levels must then also keep depth (AdjustDepth, DepthTo and Sweep, as
+ *    PriceLevels does with TrackDepth)
+ *
+ * Price, quantity and order types stay the repo-wide ones from Types.h: Order,
+ * Trade, listeners and every persisted format share them.
+ */
+template <typename Levels>
+concept DepthTrackingLevels = requires(Levels& levels, const Levels& view) {
+    levels.AdjustDepth(Price{}, std::int64_t{});
+    { view.DepthTo(Price{}) } -> std::same_as<std::uint64_t>;
+    { view.Sweep(std::uint64_t{}) } -> std::same_as<FillCost>;
+};
+
+template <typename Policy>
+concept OrderbookPolicy = requires {
+    typename Policy::template Levels<std::less<Price>>;
+    typename Policy::template Levels<std::greater<Price>>;
+    { Policy::EnableStops } -> std::convertible_to<bool>;
+    { Policy::EnableSelfTradePrevention } -> std::convertible_to<bool>;
+    { Policy::EnableInstrumentation } -> std::convertible_to<bool>;
+    { Policy::EnableDepthQueries } -> std::convertible_to<bool>;
+    requires !Policy::EnableDepthQueries ||
+                 (DepthTrackingLevels<typename Policy::template Levels<std::less<Price>>> &&
+                  DepthTrackingLevels<typename Policy::template Levels<std::greater<Price>>>);
+};
+
+/**
+ * Everything on: the configuration behind Orderbook.
+ */
+struct DefaultOrderbookPolicy {
+    static constexpr bool EnableStops = true;
+    static constexpr bool EnableSelfTradePrevention = true;
+    static constexpr bool EnableInstrumentation = true;
+    static constexpr bool EnableDepthQueries = true;
+
+    template <typename Compare>
+    using Levels = PriceLevels<PriceLevel, Compare, EnableDepthQueries>;
+};
+
+/**
+ * For venues without stop orders or owner checks: matching is price, time and
+ * nothing else, and levels keep no depth trees. Behind LeanOrderbook.
+ */
+struct LeanOrderbookPolicy : DefaultOrderbookPolicy {
+    static constexpr bool EnableStops = false;
+    static constexpr bool EnableSelfTradePrevention = false;
+    static constexpr bool EnableInstrumentation = false;
+    static constexpr bool EnableDepthQueries = false;
+
+    template <typename Compare>
+    using Levels = PriceLevels<PriceLevel, Compare, EnableDepthQueries>;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include "OrderPool.h"
+#include <cstdint>
+
+/**
+ * Orders resting at one price, with running totals kept in sync on every
+ * add, cancel and fill so depth queries never walk individual orders.
+ * totalQuantity is what the level displays; iceberg reserves are counted
+ * separately in hiddenQuantity.
+ */
+struct PriceLevel {
+    OrderQueue orders;
+    Quantity totalQuantity{ 0 };
+    Quantity hiddenQuantity{ 0 };
+    std::uint32_t orderCount{ 0 };
+
+    [[nodiscard]] bool empty() const noexcept { return orders.empty(); }
+
+    void PushBack(OrderNode* node) noexcept {
+        orders.PushBack(node);
+        node->level = this;
+        totalQuantity += node->order->GetVisibleQuantity();
+        hiddenQuantity += node->order->GetHiddenQuantity();
+        ++orderCount;
+    }
+
+    void Remove(OrderNode* node) noexcept {
+        totalQuantity -= node->order->GetVisibleQuantity();
+        hiddenQuantity -= node->order->GetHiddenQuantity();
+        --orderCount;
+        orders.Remove(node);
+        node->level = nullptr;
+    }
+
+    // Called after a resting order at this level was filled or reduced by these amounts
+    void Reduce(Quantity visible, Quantity hidden = 0) noexcept {
+        totalQuantity -= visible;
+        hiddenQuantity -= hidden;
+    }
+};
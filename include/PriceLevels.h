@@ -0,0 +1,417 @@
+#pragma once
+#include "OrderbookLevelInfos.h"
+#include "Types.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounded tick band used by the array-backed price ladder.
+ * Covers prices basePrice, basePrice + tickSize, ... (levelCount slots);
+ * basePrice may be 0 but not negative.
+ */
+struct LadderConfig {
+    Price basePrice;
+    Price tickSize;
+    std::size_t levelCount;
+};
+
+/**
+ * Price-sorted levels for one side of the book.
+ *
+ * Without a ladder this is a thin wrapper over std::map<Price, Level, Compare>.
+ * With a ladder, on-tick prices inside the band live in a contiguous array indexed
+ * by (price - base) / tick; an occupancy bitmap skips empty slots and the best
+ * slot is cached. Prices outside the band (or off-tick) fall back to the map.
+ *
+ * Iteration always yields levels in priority order (best first).
+ *
+ * With TrackDepth, two Fenwick trees over the ladder slots, in priority order,
+ * hold each level's quantity and slot x quantity, so DepthTo and Sweep cost
+ * O(log slots) for the band plus one step per level in the map; without a
+ * ladder every level is in the map and both are O(levels). The owner
+ * reports every change to a level's quantity through AdjustDepth; map levels
+ * are read directly and need no report. Level must have a totalQuantity.
+ */
+template <typename Level, typename Compare, bool TrackDepth = false>
+class PriceLevels {
+    static constexpr bool Ascending = std::is_same_v<Compare, std::less<Price>>;
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    static constexpr std::size_t WordBits = 64;
+
+    using Fallback = std::map<Price, Level, Compare>;
+
+    template <bool Const>
+    class Iterator {
+        using Owner = std::conditional_t<Const, const PriceLevels, PriceLevels>;
+        using MapIterator = std::conditional_t<Const, typename Fallback::const_iterator,
+                                               typename Fallback::iterator>;
+        using LevelRef = std::conditional_t<Const, const Level&, Level&>;
+
+    public:
+        using value_type = std::pair<Price, LevelRef>;
+
+        Iterator() = default;
+        Iterator(Owner* owner, MapIterator mapIt, std::size_t slot)
+            : owner_{ owner }, mapIt_{ mapIt }, slot_{ slot } { }
+
+        value_type operator*() const {
+            if (UseSlot())
+                return { owner_->SlotPrice(slot_), owner_->slots_[slot_] };
+            return { mapIt_->first, mapIt_->second };
+        }
+
+        Iterator& operator++() {
+            if (UseSlot())
+                slot_ = owner_->NextSlot(slot_);
+            else
+                ++mapIt_;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return slot_ == other.slot_ && mapIt_ == other.mapIt_;
+        }
+
+    private:
+        // Merge step: take the ladder slot when it is better than the next map level
+        bool UseSlot() const {
+            if (slot_ == npos)
+                return false;
+            if (mapIt_ == owner_->fallback_.end())
+                return true;
+            return Compare{}(owner_->SlotPrice(slot_), mapIt_->first);
+        }
+
+        Owner* owner_{ nullptr };
+        MapIterator mapIt_{};
+        std::size_t slot_{ npos };
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    PriceLevels() = default;
+
+    explicit PriceLevels(const LadderConfig& config)
+        : basePrice_{ Validate(config).basePrice }, tickSize_{ config.tickSize },
+          slots_(config.levelCount),
+          occupied_((config.levelCount + WordBits - 1) / WordBits, 0) {
+        if constexpr (TrackDepth) {
+            depthQuantity_.resize(config.levelCount + 1);
+            depthSlotQuantity_.resize(config.levelCount + 1);
+        }
+    }
+
+    PriceLevels(const PriceLevels&) = default;
+    PriceLevels& operator=(const PriceLevels&) = default;
+
+    // A moved-from side is empty and has no ladder, so every level goes to the map
+    PriceLevels(PriceLevels&& other) noexcept
+        : basePrice_{ other.basePrice_ }, tickSize_{ other.tickSize_ },
+          slots_{ std::exchange(other.slots_, {}) }, occupied_{ std::exchange(other.occupied_, {}) },
+          occupiedCount_{ std::exchange(other.occupiedCount_, 0) }, best_{ std::exchange(other.best_, npos) },
+          depthQuantity_{ std::exchange(other.depthQuantity_, {}) },
+          depthSlotQuantity_{ std::exchange(other.depthSlotQuantity_, {}) },
+          fallback_{ std::exchange(other.fallback_, {}) } { }
+
+    PriceLevels& operator=(PriceLevels&& other) noexcept {
+        if (this != &other) {
+            basePrice_ = other.basePrice_;
+            tickSize_ = other.tickSize_;
+            slots_ = std::exchange(other.slots_, {});
+            occupied_ = std::exchange(other.occupied_, {});
+            occupiedCount_ = std::exchange(other.occupiedCount_, 0);
+            best_ = std::exchange(other.best_, npos);
+            depthQuantity_ = std::exchange(other.depthQuantity_, {});
+            depthSlotQuantity_ = std::exchange(other.depthSlotQuantity_, {});
+            fallback_ = std::exchange(other.fallback_, {});
+        }
+        return *this;
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+    [[nodiscard]] std::size_t size() const noexcept { return occupiedCount_ + fallback_.size(); }
+
+    iterator begin() { return { this, fallback_.begin(), best_ }; }
+    iterator end() { return { this, fallback_.end(), npos }; }
+    const_iterator begin() const { return { this, fallback_.begin(), best_ }; }
+    const_iterator end() const { return { this, fallback_.end(), npos }; }
+
+    /**
+     * Returns the level at price, creating an empty one if needed.
+     */
+    Level& operator[](Price price) {
+        auto slot = SlotFor(price);
+        if (slot == npos)
+            return fallback_[price];
+
+        if (!IsOccupied(slot)) {
+            occupied_[slot / WordBits] |= std::uint64_t{1} << (slot % WordBits);
+            ++occupiedCount_;
+            if (best_ == npos || (Ascending ? slot < best_ : slot > best_))
+                best_ = slot;
+        }
+        return slots_[slot];
+    }
+
+    Level* find(Price price) {
+        return const_cast<Level*>(std::as_const(*this).find(price));
+    }
+
+    const Level* find(Price price) const {
+        auto slot = SlotFor(price);
+        if (slot == npos) {
+            auto it = fallback_.find(price);
+            return it == fallback_.end() ? nullptr : &it->second;
+        }
+        return IsOccupied(slot) ? &slots_[slot] : nullptr;
+    }
+
+    /**
+     * Removes the level at price. The level is expected to be empty.
+     */
+    void erase(Price price) {
+        auto slot = SlotFor(price);
+        if (slot == npos) {
+            fallback_.erase(price);
+            return;
+        }
+        if (!IsOccupied(slot))
+            return;
+
+        occupied_[slot / WordBits] &= ~(std::uint64_t{1} << (slot % WordBits));
+        --occupiedCount_;
+        slots_[slot] = Level{};
+        if (slot == best_)
+            best_ = NextSlot(slot);
+    }
+
+    /**
+     * Records that the quantity of the level at price changed by delta.
+     */
+    void AdjustDepth(Price price, std::int64_t delta) noexcept
+        requires TrackDepth
+    {
+        auto slot = SlotFor(price);
+        if (slot == npos || delta == 0)
+            return;
+
+        // Unsigned wrap-around keeps the sums exact as long as the true totals fit
+        auto quantity = static_cast<std::uint64_t>(delta);
+        auto slotQuantity = quantity * slot;
+        for (auto i = PriorityIndex(slot) + 1; i < depthQuantity_.size(); i += i & (~i + 1)) {
+            depthQuantity_[i] += quantity;
+            depthSlotQuantity_[i] += slotQuantity;
+        }
+    }
+
+    /**
+     * Total quantity of the levels at limit or better.
+     */
+    std::uint64_t DepthTo(Price limit) const noexcept
+        requires TrackDepth
+    {
+        auto depth = DepthPrefix(SlotsBetterThan(limit, true)).first;
+        for (const auto& [price, level] : fallback_) {
+            if (Compare{}(limit, price))
+                break;
+            depth += level.totalQuantity;
+        }
+        return depth;
+    }
+
+    /**
+     * Takes up to quantity from the levels, best first. The result holds less
+     * than quantity when the levels run out first.
+     */
+    FillCost Sweep(std::uint64_t quantity) const noexcept
+        requires TrackDepth
+    {
+        FillCost cost;
+        if (quantity == 0)
+            return cost;
+
+        // Ladder slots passed so far, in priority order, and their prefix sums
+        std::size_t taken = 0;
+        std::uint64_t takenQuantity = 0;
+        std::uint64_t takenSlotQuantity = 0;
+
+        // Takes from the slots before end; true once quantity is reached
+        auto TakeSlots = [&](std::size_t end) {
+            if (end <= taken)
+                return false;
+
+            auto [endQuantity, endSlotQuantity] = DepthPrefix(end);
+            auto available = endQuantity - takenQuantity;
+            auto wanted = quantity - cost.quantity;
+            if (available < wanted) {
+                if (available != 0) {
+                    cost.quantity += available;
+                    cost.notional += LadderNotional(available, endSlotQuantity - takenSlotQuantity);
+                    cost.worstPrice = SlotPrice(PriorityIndex(DepthCountBelow(endQuantity)));
+                }
+                taken = end;
+                takenQuantity = endQuantity;
+                takenSlotQuantity = endSlotQuantity;
+                return false;
+            }
+
+            // Every slot before the one the quantity runs out in is taken whole
+            auto last = DepthCountBelow(takenQuantity + wanted);
+            auto [lastQuantity, lastSlotQuantity] = DepthPrefix(last);
+            auto price = SlotPrice(PriorityIndex(last));
+            cost.notional += LadderNotional(lastQuantity - takenQuantity, lastSlotQuantity - takenSlotQuantity) +
+                             static_cast<std::uint64_t>(price) * (wanted - (lastQuantity - takenQuantity));
+            cost.quantity = quantity;
+            cost.worstPrice = price;
+            return true;
+        };
+
+        // Map levels interleave with the band, so take the slots better than each first
+        for (const auto& [price, level] : fallback_) {
+            if (TakeSlots(SlotsBetterThan(price, false)))
+                return cost;
+
+            auto take = std::min<std::uint64_t>(level.totalQuantity, quantity - cost.quantity);
+            cost.quantity += take;
+            cost.notional += static_cast<std::uint64_t>(price) * take;
+            cost.worstPrice = price;
+            if (cost.quantity == quantity)
+                return cost;
+        }
+        TakeSlots(slots_.size());
+        return cost;
+    }
+
+private:
+    static const LadderConfig& Validate(const LadderConfig& config) {
+        if (config.tickSize <= 0)
+            throw std::invalid_argument("Ladder tick size must be positive");
+        if (config.levelCount == 0)
+            throw std::invalid_argument("Ladder must have at least one level");
+        if (config.basePrice < 0)
+            throw std::invalid_argument("Ladder base price must not be negative");
+        return config;
+    }
+
+    std::size_t SlotFor(Price price) const noexcept {
+        if (slots_.empty() || price < basePrice_)
+            return npos;
+
+        auto offset = static_cast<std::int64_t>(price) - basePrice_;
+        if (offset % tickSize_ != 0)
+            return npos;
+
+        auto slot = static_cast<std::size_t>(offset / tickSize_);
+        return slot < slots_.size() ? slot : npos;
+    }
+
+    Price SlotPrice(std::size_t slot) const noexcept {
+        return static_cast<Price>(basePrice_ + static_cast<std::int64_t>(slot) * tickSize_);
+    }
+
+    // Position of a slot in priority order, and back: the mapping is its own inverse
+    std::size_t PriorityIndex(std::size_t slot) const noexcept {
+        return Ascending ? slot : slots_.size() - 1 - slot;
+    }
+
+    // Number of slots whose price is better than price (or as good, with orEqual)
+    std::size_t SlotsBetterThan(Price price, bool orEqual) const noexcept {
+        auto count = static_cast<std::int64_t>(slots_.size());
+        auto offset = static_cast<std::int64_t>(price) - basePrice_;
+        auto floor = offset >= 0 ? offset / tickSize_ : -((-offset + tickSize_ - 1) / tickSize_);
+        auto ceil = offset >= 0 ? (offset + tickSize_ - 1) / tickSize_ : -(-offset / tickSize_);
+
+        // Better is lower for asks, so the slots below price; higher for bids, so the ones above
+        auto better = Ascending ? (orEqual ? floor + 1 : ceil) : count - (orEqual ? ceil : floor + 1);
+        return static_cast<std::size_t>(std::clamp<std::int64_t>(better, 0, count));
+    }
+
+    // Quantity and slot x quantity of the first `count` slots in priority order
+    std::pair<std::uint64_t, std::uint64_t> DepthPrefix(std::size_t count) const noexcept {
+        std::uint64_t quantity = 0;
+        std::uint64_t slotQuantity = 0;
+        for (auto i = count; i > 0; i &= i - 1) {
+            quantity += depthQuantity_[i];
+            slotQuantity += depthSlotQuantity_[i];
+        }
+        return { quantity, slotQuantity };
+    }
+
+    // Largest count of leading slots in priority order that hold less than target
+    std::size_t DepthCountBelow(std::uint64_t target) const noexcept {
+        std::size_t count = 0;
+        for (auto step = std::bit_floor(slots_.size()); step > 0; step >>= 1) {
+            if (count + step <= slots_.size() && depthQuantity_[count + step] < target) {
+                count += step;
+                target -= depthQuantity_[count];
+            }
+        }
+        return count;
+    }
+
+    // Notional of ladder levels from their quantity and slot x quantity totals
+    std::uint64_t LadderNotional(std::uint64_t quantity, std::uint64_t slotQuantity) const noexcept {
+        return static_cast<std::uint64_t>(basePrice_) * quantity + static_cast<std::uint64_t>(tickSize_) * slotQuantity;
+    }
+
+    bool IsOccupied(std::size_t slot) const noexcept {
+        return (occupied_[slot / WordBits] >> (slot % WordBits)) & 1;
+    }
+
+    // Next occupied slot after `slot` in priority order, or npos
+    std::size_t NextSlot(std::size_t slot) const noexcept {
+        if constexpr (Ascending) {
+            auto start = slot + 1;
+            if (start >= slots_.size())
+                return npos;
+
+            auto word = start / WordBits;
+            auto bits = occupied_[word] & (~std::uint64_t{0} << (start % WordBits));
+            while (bits == 0) {
+                if (++word == occupied_.size())
+                    return npos;
+                bits = occupied_[word];
+            }
+            return word * WordBits + std::countr_zero(bits);
+        } else {
+            if (slot == 0)
+                return npos;
+
+            auto start = slot - 1;
+            auto word = start / WordBits;
+            auto shift = start % WordBits;
+            auto mask = (shift == WordBits - 1) ? ~std::uint64_t{0}
+                                                : (std::uint64_t{1} << (shift + 1)) - 1;
+            auto bits = occupied_[word] & mask;
+            while (bits == 0) {
+                if (word == 0)
+                    return npos;
+                bits = occupied_[--word];
+            }
+            return word * WordBits + (WordBits - 1 - std::countl_zero(bits));
+        }
+    }
+
+    Price basePrice_{ 0 };
+    Price tickSize_{ 1 };
+    std::vector<Level> slots_;
+    std::vector<std::uint64_t> occupied_;
+    std::size_t occupiedCount_{ 0 };
+    std::size_t best_{ npos };
+
+    // Fenwick trees for TrackDepth, 1-based over priority order
+    std::vector<std::uint64_t> depthQuantity_;
+    std::vector<std::uint64_t> depthSlotQuantity_;
+
+    Fallback fallback_;
+};
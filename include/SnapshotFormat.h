@@ -0,0 +1,56 @@
+#pragma once
+#include "Order.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * Snapshot layout, all integers little-endian:
+ *
+ *   header (80 bytes)   "OBSNAPSH" | u32 version | u32 record size | u64 resting count |
+ *                       u64 stop count | u64 payload checksum | u64 book time |
+ *                       u64 session first close | u64 session length | u8 in auction |
+ *                       3 pad | i32 auction reference price | zero padding
+ *   order  (48 bytes)   u8 order type | u8 side | u8 has stop | 1 pad | u32 owner |
+ *                       u64 order ID | i32 price | i32 stop price | u32 initial qty |
+ *                       u32 remaining qty | u32 peak | u32 visible qty | u64 expiry
+ *
+ * Version 3 has 40-byte records without the expiry, and versions 1 and 2
+ * 32-byte records without the iceberg fields that restore as fully displayed
+ * orders; version 1 also predates owners and had zero padding where the owner
+ * now is, so it restores with every owner NoOwner. Before version 4 the book
+ * time was padding and restores as 0. Before version 5 the header is 64 bytes
+ * and ends after the book time, and the snapshot has no session schedule; a
+ * session length of 0 also means none was set. Before version 6 the auction
+ * fields were padding and restore as continuous trading.
+ * Resting orders come first, bids then asks, each best level first and FIFO
+ * within a level, followed by stops in StopBook trigger order. Records are
+ * fixed-size and aligned, so a mapped file can be walked in place.
+ *
+ * BasicOrderbook::SaveSnapshot / LoadSnapshot lay the records out; the
+ * encoding of each record lives here so every book configuration shares it.
+ */
+namespace snapshot_format {
+    inline constexpr char Magic[8] = { 'O', 'B', 'S', 'N', 'A', 'P', 'S', 'H' };
+    inline constexpr std::uint32_t Version = 6;
+    inline constexpr std::size_t HeaderSize = 80;
+    inline constexpr std::size_t RecordSize = 48;
+
+    // Header and record size of a snapshot of the given version
+    std::size_t HeaderSizeOf(std::uint32_t version) noexcept;
+    std::size_t RecordSizeOf(std::uint32_t version) noexcept;
+
+    // Word-at-a-time FNV-style hash; catches truncation and bit rot before anything is built
+    std::uint64_t PayloadChecksum(std::span<const std::byte> payload);
+
+    void EncodeOrder(std::byte* out, const Order& order);
+
+    /**
+     * Validates record number `record` of a snapshot saved at book time `time`.
+     *
+     * @throws std::runtime_error if it could not have been saved from a book
+     */
+    void CheckOrder(const std::byte* in, std::size_t recordSize, bool stop, Timestamp time, std::size_t record);
+
+    Order DecodeOrder(const std::byte* in, std::size_t recordSize);
+}
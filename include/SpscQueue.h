@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Bounded lock-free single-producer / single-consumer ring buffer.
+ *
+ * Exactly one thread may push and exactly one (other) thread may pop.
+ * Head and tail sit on separate cache lines, and each side caches the other's
+ * index so the shared atomic is only re-read when the ring looks full/empty.
+ */
+template <typename T>
+class SpscQueue {
+    static constexpr std::size_t CacheLine = 64;
+
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : slots_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity)),
+          mask_{ slots_.size() - 1 } { }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return slots_.size(); }
+
+    // Producer side
+    bool TryPush(const T& value) {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ == slots_.size()) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == slots_.size())
+                return false;
+        }
+
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool TryPop(T& value) {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_)
+                return false;
+        }
+
+        value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with push/pop
+    [[nodiscard]] bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_;
+
+    alignas(CacheLine) std::atomic<std::size_t> head_{ 0 };  // written by consumer
+    std::size_t cachedTail_{ 0 };                            // consumer's view of tail_
+
+    alignas(CacheLine) std::atomic<std::size_t> tail_{ 0 };  // written by producer
+    std::size_t cachedHead_{ 0 };                            // producer's view of head_
+};
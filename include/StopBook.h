@@ -0,0 +1,65 @@
+#pragma once
+#include "OrderIndex.h"
+#include "OrderPool.h"
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <vector>
+
+/**
+ * Pending stop orders, sorted by stop price and indexed by order ID.
+ *
+ * Buy stops trigger when a trade prints at or above their stop price, so they are
+ * kept ascending; sell stops trigger at or below, so they are kept descending.
+ * Either way the orders a trade triggers form a prefix of their side, and
+ * stops sharing a stop price keep arrival order.
+ */
+class StopBook {
+public:
+    [[nodiscard]] std::size_t size() const noexcept { return index_.size(); }
+    [[nodiscard]] bool contains(OrderID orderID) const noexcept { return index_.contains(orderID); }
+    [[nodiscard]] OrderNode* find(OrderID orderID) const noexcept { return index_.find(orderID); }
+
+    void reserve(std::size_t count) { index_.reserve(count); }
+
+    void Add(OrderNode* node);
+
+    /**
+     * Visits every pending stop in trigger order: buy stops, then sell stops,
+     * each in stop-price then arrival order. Add-ing them back in this order
+     * rebuilds an identical book.
+     */
+    template <typename Visitor>
+    void ForEach(Visitor&& visit) const {
+        for (const auto& [stopPrice, queue] : buyStops_)
+            for (const auto& order : queue)
+                visit(order);
+        for (const auto& [stopPrice, queue] : sellStops_)
+            for (const auto& order : queue)
+                visit(order);
+    }
+
+    /**
+     * Removes the stop with orderID and returns its node, or nullptr if absent.
+     */
+    OrderNode* Extract(OrderID orderID);
+
+    /**
+     * O(1) check for whether a trade at tradePrice would trigger anything.
+     */
+    [[nodiscard]] bool CouldTrigger(Price tradePrice) const noexcept;
+
+    /**
+     * Removes every stop triggered by tradePrice and appends it to triggered,
+     * buy stops first, each side in stop-price then arrival order.
+     */
+    void TakeTriggered(Price tradePrice, std::vector<OrderNode*>& triggered);
+
+private:
+    template <typename Levels>
+    static void TakeLevel(Levels& levels, OrderIndex& index, std::vector<OrderNode*>& triggered);
+
+    std::map<Price, OrderQueue, std::less<Price>> buyStops_;
+    std::map<Price, OrderQueue, std::greater<Price>> sellStops_;
+    OrderIndex index_;
+};
@@ -1,19 +1,23 @@
 #pragma once
 #include "Types.h"
+#include <cstdint>
 #include <vector>
 
 /**
- * Information about one side of the trade
+ * Information about one side of the trade, including whose order it was
  */
 struct TradeInfo {
     OrderID orderID;
     Price price;
     Quantity quantity;
+    OwnerID owner{ NoOwner };
+
+    bool operator==(const TradeInfo&) const = default;
 };
 
 /**
  * Represents a trade between a bid and an ask
- * Both sides trade at the same price (maker's price)
+ * Both sides trade at the same price: the maker's, or the equilibrium in an auction uncross
  */
 
 class Trade {
@@ -23,9 +27,29 @@ public:
     const TradeInfo& GetBidTrade() const { return bidTrade_; }
     const TradeInfo& GetAskTrade() const { return askTrade_; }
 
+    bool operator==(const Trade&) const = default;
+
 private:
     TradeInfo bidTrade_;
     TradeInfo askTrade_;
 };
 
-using Trades = std::vector<Trade>;
\ No newline at end of file
+using Trades = std::vector<Trade>;
+
+/**
+ * Running, order-sensitive hash of a trade sequence (FNV-1a over every field
+ * but the owners, so checksums recorded before trades carried them still match).
+ * Two runs that produce the same trades in the same order have equal checksums.
+ */
+class TradeChecksum {
+public:
+    void Add(const Trade& trade);
+    void Add(const Trades& trades);
+
+    [[nodiscard]] std::uint64_t Value() const noexcept { return value_; }
+    [[nodiscard]] std::uint64_t Count() const noexcept { return count_; }
+
+private:
+    std::uint64_t value_{ 14695981039346656037ull };
+    std::uint64_t count_{ 0 };
+};
@@ -6,6 +6,22 @@
 using Price = std::int32_t;
 using Quantity = std::uint32_t;
 using OrderID = std::uint64_t;
+using InstrumentID = std::uint32_t;
+
+// Point on the book's clock, in whatever unit its caller advances it by (e.g. nanoseconds since the epoch)
+using Timestamp = std::uint64_t;
+
+// When Day orders expire: closes fall at firstClose and every length after it
+struct SessionSchedule {
+    Timestamp firstClose{ 0 };
+    Timestamp length{ 0 };
+
+    bool operator==(const SessionSchedule&) const = default;
+};
+
+// Participant (account) an order belongs to; orders with NoOwner never count as self-trades
+using OwnerID = std::uint32_t;
+constexpr OwnerID NoOwner = 0;
 
 // Order execution types with different matching behaviours
 enum class OrderType {
@@ -14,7 +30,9 @@ enum class OrderType {
     GoodTillCancel,
     StopOrder,
     FillAndKill, // IOC
-    FillOrKill   // All or nothing
+    FillOrKill,  // All or nothing
+    GoodTillDate, // Rests until filled, cancelled or its expiry
+    Day           // Rests until filled, cancelled or the session close
 };
 
 enum class Side {
@@ -22,6 +40,15 @@ enum class Side {
     Sell
 };
 
+// What the book does when an order would trade against a resting order of the same owner
+enum class SelfTradePrevention {
+    None,               // trade as usual
+    CancelNewest,       // cancel the incoming order's remainder; the resting order stays
+    CancelOldest,       // cancel the resting order and keep matching
+    CancelBoth,         // cancel both
+    DecrementAndCancel  // shrink both by the smaller quantity; whichever reaches zero is cancelled
+};
+
 // Market sell orders use MIN_PRICE (0) to cross with all bids
 constexpr Price MIN_PRICE = 0;
 constexpr Price MAX_PRICE = std::numeric_limits<Price>::max();
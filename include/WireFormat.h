@@ -0,0 +1,43 @@
+#pragma once
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Little-endian load/store helpers shared by the on-disk and wire formats.
+ *
+ * All persisted integers are little-endian regardless of host byte order, and
+ * are read and written through memcpy so records need no alignment.
+ */
+
+template <typename T>
+    requires std::integral<T>
+inline void StoreLE(std::byte* out, T value) noexcept {
+    using U = std::make_unsigned_t<T>;
+    auto bits = static_cast<U>(value);
+
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out, &bits, sizeof(U));
+    } else {
+        for (std::size_t i = 0; i < sizeof(U); ++i)
+            out[i] = static_cast<std::byte>(bits >> (8 * i));
+    }
+}
+
+template <typename T>
+    requires std::integral<T>
+[[nodiscard]] inline T LoadLE(const std::byte* in) noexcept {
+    using U = std::make_unsigned_t<T>;
+    U bits{ 0 };
+
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(&bits, in, sizeof(U));
+    } else {
+        for (std::size_t i = 0; i < sizeof(U); ++i)
+            bits |= static_cast<U>(std::to_integer<U>(in[i]) << (8 * i));
+    }
+
+    return static_cast<T>(bits);
+}
@@ -0,0 +1,96 @@
+#include "DepthPublisher.h"
+#include "Orderbook.h"
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    // Each level takes two words: price and quantity, then the order count
+    constexpr std::size_t LevelWords = 2;
+
+    void Pack(const LevelInfo& level, std::uint64_t* words) noexcept {
+        words[0] = static_cast<std::uint32_t>(level.price_) | (static_cast<std::uint64_t>(level.quantity_) << 32);
+        words[1] = level.orderCount_;
+    }
+
+    LevelInfo Unpack(const std::atomic<std::uint64_t>* words) noexcept {
+        auto word = words[0].load(std::memory_order_relaxed);
+        return LevelInfo{ static_cast<Price>(static_cast<std::uint32_t>(word)), static_cast<Quantity>(word >> 32),
+                          static_cast<std::uint32_t>(words[1].load(std::memory_order_relaxed)) };
+    }
+}
+
+DepthPublisher::DepthPublisher(std::size_t depth)
+    : depth_{ depth } {
+    if (depth == 0)
+        throw std::invalid_argument("DepthPublisher depth must be positive");
+
+    auto words = 1 + 2 * LevelWords * depth;
+    scratch_.resize(depth);
+    next_.resize(words);
+    last_.resize(words);
+    words_ = std::make_unique<std::atomic<std::uint64_t>[]>(words);
+}
+
+bool DepthPublisher::Publish(const Orderbook& book) {
+    std::fill(next_.begin(), next_.end(), 0);
+
+    auto bids = book.GetTopLevels(Side::Buy, scratch_);
+    for (std::size_t i = 0; i < bids; ++i)
+        Pack(scratch_[i], &next_[1 + LevelWords * i]);
+
+    auto asks = book.GetTopLevels(Side::Sell, scratch_);
+    for (std::size_t i = 0; i < asks; ++i)
+        Pack(scratch_[i], &next_[1 + LevelWords * (depth_ + i)]);
+
+    next_[0] = bids | (static_cast<std::uint64_t>(asks) << 32);
+    if (next_ == last_)
+        return false;
+
+    // Seqlock write: odd sequence, then the data, then the next even sequence.
+    // Only words that changed are stored, so unchanged lines stay shared in readers' caches.
+    auto sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t i = 0; i < next_.size(); ++i)
+        if (next_[i] != last_[i])
+            words_[i].store(next_[i], std::memory_order_relaxed);
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+    next_.swap(last_);
+    return true;
+}
+
+void DepthPublisher::Read(DepthSnapshot& out) const {
+    // The writer finishes a publication in a few dozen stores; yield in case it was preempted mid-way
+    while (!TryRead(out))
+        std::this_thread::yield();
+}
+
+bool DepthPublisher::TryRead(DepthSnapshot& out) const {
+    auto before = sequence_.load(std::memory_order_acquire);
+    if (before & 1)
+        return false;
+
+    // Counts may be torn if we race the writer; clamp so the copy stays in bounds
+    auto counts = words_[0].load(std::memory_order_relaxed);
+    auto bids = std::min<std::size_t>(counts & 0xffffffff, depth_);
+    auto asks = std::min<std::size_t>(counts >> 32, depth_);
+
+    out.bids.resize(bids);
+    for (std::size_t i = 0; i < bids; ++i)
+        out.bids[i] = Unpack(&words_[1 + LevelWords * i]);
+
+    out.asks.resize(asks);
+    for (std::size_t i = 0; i < asks; ++i)
+        out.asks[i] = Unpack(&words_[1 + LevelWords * (depth_ + i)]);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) != before)
+        return false;
+
+    out.version = before / 2;
+    return true;
+}
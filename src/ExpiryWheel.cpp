@@ -0,0 +1,105 @@
+#include "ExpiryWheel.h"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+bool ExpiryWheel::empty() const noexcept {
+    return std::all_of(occupied_.begin(), occupied_.end(), [](std::uint64_t mask) { return mask == 0; });
+}
+
+void ExpiryWheel::Reset(Timestamp now) noexcept {
+    now_ = now;
+}
+
+void ExpiryWheel::Add(OrderNode* node) noexcept {
+    auto expiry = node->order->GetExpiry();
+    auto level = static_cast<unsigned>(std::bit_width(expiry ^ now_) - 1) / SlotBits;
+    auto digit = static_cast<unsigned>(expiry >> (level * SlotBits)) & (SlotCount - 1);
+    auto slot = level * SlotCount + digit;
+
+    // Appended at the tail, which the head's prev points to, so a slot hands
+    // orders with equal expiries back in the order they arrived
+    auto*& head = slots_[slot];
+    node->expiryNext = nullptr;
+    if (head) {
+        node->expiryPrev = head->expiryPrev;
+        head->expiryPrev->expiryNext = node;
+        head->expiryPrev = node;
+    } else {
+        node->expiryPrev = node;
+        head = node;
+    }
+
+    node->expirySlot = static_cast<std::uint16_t>(slot);
+    occupied_[level] |= std::uint64_t{ 1 } << digit;
+}
+
+void ExpiryWheel::Unlink(OrderNode* node) noexcept {
+    auto slot = node->expirySlot;
+    auto*& head = slots_[slot];
+    if (node == head)
+        head = node->expiryNext;
+    else
+        node->expiryPrev->expiryNext = node->expiryNext;
+
+    if (node->expiryNext)
+        node->expiryNext->expiryPrev = node->expiryPrev;
+    else if (head)
+        head->expiryPrev = node->expiryPrev;
+
+    if (!head)
+        occupied_[slot / SlotCount] &= ~(std::uint64_t{ 1 } << (slot % SlotCount));
+
+    node->expiryPrev = nullptr;
+    node->expiryNext = nullptr;
+    node->expirySlot = OrderNode::NotExpiring;
+}
+
+OrderNode* ExpiryWheel::TakeSlot(unsigned level, unsigned digit) noexcept {
+    auto* head = std::exchange(slots_[level * SlotCount + digit], nullptr);
+    occupied_[level] &= ~(std::uint64_t{ 1 } << digit);
+    return head;
+}
+
+void ExpiryWheel::Advance(Timestamp now, std::vector<OrderNode*>& expired) {
+    if (now <= now_)
+        return;
+
+    auto Expire = [&](OrderNode* node) {
+        node->expiryPrev = nullptr;
+        node->expiryNext = nullptr;
+        node->expirySlot = OrderNode::NotExpiring;
+        expired.push_back(node);
+    };
+    auto ExpireAll = [&](OrderNode* node) {
+        while (node) {
+            auto* next = node->expiryNext;
+            Expire(node);
+            node = next;
+        }
+    };
+
+    // Orders below the highest changed digit share the old time's digits there, so they are all due
+    auto top = static_cast<unsigned>(std::bit_width(now ^ now_) - 1) / SlotBits;
+    for (unsigned level = 0; level < top; ++level)
+        while (occupied_[level])
+            ExpireAll(TakeSlot(level, static_cast<unsigned>(std::countr_zero(occupied_[level]))));
+
+    // On that level every slot before the new digit is due (those up to the old digit are empty)
+    auto digit = static_cast<unsigned>(now >> (top * SlotBits)) & (SlotCount - 1);
+    auto passed = occupied_[top] & ((std::uint64_t{ 1 } << digit) - 1);
+    for (; passed; passed &= passed - 1)
+        ExpireAll(TakeSlot(top, static_cast<unsigned>(std::countr_zero(passed))));
+
+    // The slot landed in holds orders due now and later; the later ones move down relative to the new time
+    auto* landed = (occupied_[top] >> digit) & 1 ? TakeSlot(top, digit) : nullptr;
+    now_ = now;
+    while (landed) {
+        auto* next = landed->expiryNext;
+        if (landed->order->GetExpiry() <= now)
+            Expire(landed);
+        else
+            Add(landed);
+        landed = next;
+    }
+}
@@ -0,0 +1,84 @@
+#include "FileIO.h"
+#include <cerrno>
+#include <cstdio>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    [[noreturn]] void ThrowErrno(const std::string& what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+}
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        ThrowErrno("open " + path);
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        ThrowErrno("stat " + path);
+    }
+
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            ThrowErrno("mmap " + path);
+        }
+        ::madvise(mapped, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const std::byte*>(mapped);
+    }
+
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_)
+        ::munmap(const_cast<std::byte*>(data_), size_);
+}
+
+void WriteAll(int fd, std::span<const std::byte> bytes, const std::string& what) {
+    const auto* data = bytes.data();
+    auto remaining = bytes.size();
+    while (remaining > 0) {
+        auto written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            ThrowErrno("write " + what);
+        }
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+}
+
+void WriteFileAtomically(const std::string& path, std::span<const std::byte> bytes) {
+    auto temporary = path + ".tmp";
+
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        ThrowErrno("open " + temporary);
+
+    try {
+        WriteAll(fd, bytes, temporary);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    if (::fsync(fd) != 0) {
+        ::close(fd);
+        ThrowErrno("sync " + temporary);
+    }
+    ::close(fd);
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        ThrowErrno("rename " + temporary);
+}
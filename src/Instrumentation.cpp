@@ -0,0 +1,77 @@
+#include "Instrumentation.h"
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<instrumentation::ThreadBlock>> blocks;
+    };
+
+    Registry& GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    void Fold(const std::array<instrumentation::Cell, LatencyHistogram::BucketCount>& buckets, LatencyHistogram& out) {
+        for (std::size_t i = 0; i < buckets.size(); ++i)
+            out.Record(LatencyHistogram::BucketHighestValue(i), buckets[i].Load());
+    }
+}
+
+std::atomic<std::uint32_t> instrumentation::samplePeriod{ 1 };
+
+instrumentation::ThreadBlock* instrumentation::RegisterThread() {
+    auto& registry = GetRegistry();
+    std::lock_guard lock{ registry.mutex };
+    return registry.blocks.emplace_back(std::make_unique<ThreadBlock>()).get();
+}
+
+void SetInstrumentationSamplePeriod(std::uint32_t period) {
+    if (period == 0)
+        throw std::invalid_argument("Instrumentation sample period must be positive");
+    instrumentation::samplePeriod.store(period, std::memory_order_relaxed);
+}
+
+InstrumentationSnapshot TakeInstrumentationSnapshot() {
+    InstrumentationSnapshot snapshot;
+    if constexpr (!InstrumentationEnabled)
+        return snapshot;
+
+    auto& registry = GetRegistry();
+    std::lock_guard lock{ registry.mutex };
+
+    for (const auto& block : registry.blocks) {
+        auto count = [&](InstrumentationCounter counter) {
+            return block->counters[static_cast<std::size_t>(counter)].Load();
+        };
+
+        snapshot.adds += count(InstrumentationCounter::Adds);
+        snapshot.cancels += count(InstrumentationCounter::Cancels);
+        snapshot.modifies += count(InstrumentationCounter::Modifies);
+        snapshot.fills += count(InstrumentationCounter::Fills);
+        snapshot.rejectedFillAndKill += count(InstrumentationCounter::RejectedFillAndKill);
+        snapshot.rejectedFillOrKill += count(InstrumentationCounter::RejectedFillOrKill);
+        snapshot.rejectedPostOnly += count(InstrumentationCounter::RejectedPostOnly);
+        snapshot.stopTriggers += count(InstrumentationCounter::StopTriggers);
+        snapshot.stopCascades += count(InstrumentationCounter::StopCascades);
+        snapshot.selfTradesPrevented += count(InstrumentationCounter::SelfTradesPrevented);
+        snapshot.icebergReplenishments += count(InstrumentationCounter::IcebergReplenishments);
+        snapshot.ordersExpired += count(InstrumentationCounter::OrdersExpired);
+        snapshot.levelsCreated += count(InstrumentationCounter::LevelsCreated);
+        snapshot.levelsDestroyed += count(InstrumentationCounter::LevelsDestroyed);
+        snapshot.maxCascadeDepth = std::max(snapshot.maxCascadeDepth, block->maxCascadeDepth.Load());
+
+        auto cycles = [&](InstrumentationSection section) -> const auto& {
+            return block->cycles[static_cast<std::size_t>(section)];
+        };
+        Fold(cycles(InstrumentationSection::MatchAggressiveOrder), snapshot.matchCycles);
+        Fold(cycles(InstrumentationSection::CancelOrder), snapshot.cancelCycles);
+        Fold(cycles(InstrumentationSection::CheckAndTriggerStopOrders), snapshot.stopTriggerCycles);
+    }
+
+    snapshot.threads = registry.blocks.size();
+    return snapshot;
+}
@@ -0,0 +1,293 @@
+#include "Journal.h"
+#include "Orderbook.h"
+#include "WireFormat.h"
+#include <cerrno>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char Magic[8] = { 'O', 'B', 'J', 'O', 'U', 'R', 'N', 'L' };
+    constexpr std::size_t LegacyRecordSize = 32;  // versions 1 to 3
+
+    [[noreturn]] void ThrowErrno(const std::string& what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    void EncodeHeader(std::byte* out, const std::optional<SessionSchedule>& session) {
+        std::memset(out, 0, JournalRecordSize);
+        std::memcpy(out, Magic, sizeof(Magic));
+        StoreLE(out + 8, JournalVersion);
+        StoreLE(out + 12, static_cast<std::uint32_t>(JournalRecordSize));
+        if (session) {
+            StoreLE(out + 16, session->firstClose);
+            StoreLE(out + 24, session->length);
+        }
+    }
+
+    // Returns the journal's version
+    std::uint32_t CheckHeader(const std::byte* in, std::size_t size, const std::string& path) {
+        if (size < LegacyRecordSize || std::memcmp(in, Magic, sizeof(Magic)) != 0)
+            throw std::runtime_error(std::format("{} is not an orderbook journal", path));
+
+        auto version = LoadLE<std::uint32_t>(in + 8);
+        auto recordSize = LoadLE<std::uint32_t>(in + 12);
+        if (version == 0 || version > JournalVersion ||
+            recordSize != (version < 4 ? LegacyRecordSize : JournalRecordSize) || size < recordSize)
+            throw std::runtime_error(std::format("{} has unsupported journal version {}", path, version));
+        return version;
+    }
+
+    // Values of a command's extra byte, saying what the field at offset 24 holds (0: nothing)
+    constexpr std::uint8_t StopExtra = 1;
+    constexpr std::uint8_t PeakExtra = 2;
+
+    void EncodeCommand(std::byte* out, const OrderCommand& command) {
+        std::memset(out, 0, JournalRecordSize);
+        out[0] = static_cast<std::byte>(JournalRecordType::Command);
+        out[1] = static_cast<std::byte>(command.type);
+        out[2] = static_cast<std::byte>(command.orderType);
+        out[3] = static_cast<std::byte>(command.side);
+        StoreLE(out + 8, command.orderID);
+        StoreLE(out + 16, command.price);
+        StoreLE(out + 20, command.quantity);
+        if (command.stopPrice) {
+            out[4] = static_cast<std::byte>(StopExtra);
+            StoreLE(out + 24, *command.stopPrice);
+        } else if (command.peak != 0) {
+            out[4] = static_cast<std::byte>(PeakExtra);
+            StoreLE(out + 24, command.peak);
+        }
+        StoreLE(out + 28, command.owner);
+        StoreLE(out + 32, command.time);
+    }
+
+    void EncodeCheckpoint(std::byte* out, const JournalCheckpoint& checkpoint) {
+        std::memset(out, 0, JournalRecordSize);
+        out[0] = static_cast<std::byte>(JournalRecordType::Checkpoint);
+        StoreLE(out + 8, checkpoint.commandCount);
+        StoreLE(out + 16, checkpoint.tradeCount);
+        StoreLE(out + 24, checkpoint.tradeChecksum);
+    }
+
+    bool DecodeCommand(const std::byte* in, std::size_t recordSize, OrderCommand& command) {
+        auto type = std::to_integer<std::uint8_t>(in[1]);
+        auto orderType = std::to_integer<std::uint8_t>(in[2]);
+        auto side = std::to_integer<std::uint8_t>(in[3]);
+        auto extra = std::to_integer<std::uint8_t>(in[4]);
+
+        if (type > static_cast<std::uint8_t>(CommandType::Uncross) ||
+            orderType > static_cast<std::uint8_t>(OrderType::Day) ||
+            side > static_cast<std::uint8_t>(Side::Sell) || extra > PeakExtra)
+            return false;
+
+        command.type = static_cast<CommandType>(type);
+        command.orderType = static_cast<OrderType>(orderType);
+        command.side = static_cast<Side>(side);
+        command.orderID = LoadLE<OrderID>(in + 8);
+        command.price = LoadLE<Price>(in + 16);
+        command.quantity = LoadLE<Quantity>(in + 20);
+        command.stopPrice = extra == StopExtra ? std::optional<Price>{ LoadLE<Price>(in + 24) } : std::nullopt;
+        command.peak = extra == PeakExtra ? LoadLE<Quantity>(in + 24) : 0;
+        command.owner = LoadLE<OwnerID>(in + 28);
+        command.time = recordSize == JournalRecordSize ? LoadLE<Timestamp>(in + 32) : 0;
+        return true;
+    }
+
+    // Forwards events and folds trades into the replay checksum
+    class ReplayListener final : public OrderbookListener {
+    public:
+        ReplayListener(TradeChecksum& trades, OrderbookListener* next) : trades_{ trades }, next_{ next } { }
+
+        void OnOrderAccepted(const Order& order) override { if (next_) next_->OnOrderAccepted(order); }
+        void OnOrderRejected(const Order& order, RejectReason reason) override { if (next_) next_->OnOrderRejected(order, reason); }
+        void OnTrade(const Trade& trade) override {
+            trades_.Add(trade);
+            if (next_) next_->OnTrade(trade);
+        }
+        void OnOrderRested(const Order& order) override { if (next_) next_->OnOrderRested(order); }
+        void OnOrderCancelled(const Order& order) override { if (next_) next_->OnOrderCancelled(order); }
+        void OnOrderReduced(const Order& order) override { if (next_) next_->OnOrderReduced(order); }
+        void OnOrderReplenished(const Order& order) override { if (next_) next_->OnOrderReplenished(order); }
+        void OnStopTriggered(const Order& order) override { if (next_) next_->OnStopTriggered(order); }
+        void OnLevelUpdate(const LevelUpdate& update) override { if (next_) next_->OnLevelUpdate(update); }
+        void OnAuctionIndication(const AuctionIndication& indication) override {
+            if (next_) next_->OnAuctionIndication(indication);
+        }
+        void OnUncross(const AuctionIndication& uncross) override { if (next_) next_->OnUncross(uncross); }
+
+    private:
+        TradeChecksum& trades_;
+        OrderbookListener* next_;
+    };
+}
+
+// ===============================
+//          JournalWriter
+// ===============================
+
+JournalWriter::JournalWriter(const std::string& path, const JournalWriterOptions& options)
+    : options_{ options } {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+        ThrowErrno("open " + path);
+
+    struct stat info;
+    if (::fstat(fd_, &info) != 0) {
+        ::close(fd_);
+        ThrowErrno("stat " + path);
+    }
+
+    try {
+        if (info.st_size == 0) {
+            if (options_.session && options_.session->length == 0)
+                throw std::invalid_argument("Session length must be positive");
+            EncodeHeader(Reserve(), options_.session);
+            Commit();
+        } else {
+            JournalReader reader{path};
+            if (reader.Version() != JournalVersion)
+                throw std::runtime_error(std::format("{} is a version {} journal; start a new one to append",
+                                                     path, reader.Version()));
+            if (options_.session && options_.session != reader.Session())
+                throw std::runtime_error(std::format("{} was started with another session schedule", path));
+            options_.session = reader.Session();
+
+            JournalRecord record;
+            while (reader.Next(record))
+                commandCount_ += record.type == JournalRecordType::Command;
+
+            // Drop a torn record left by a crash mid-write
+            auto complete = static_cast<off_t>((reader.RecordCount() + 1) * JournalRecordSize);
+            if (info.st_size != complete && ::ftruncate(fd_, complete) != 0)
+                ThrowErrno("truncate " + path);
+        }
+    } catch (...) {
+        ::close(fd_);
+        throw;
+    }
+}
+
+JournalWriter::~JournalWriter() {
+    try {
+        Commit();
+    } catch (...) {
+        // Destructors must not throw; callers that care about durability Commit explicitly
+    }
+    ::close(fd_);
+}
+
+void JournalWriter::Append(const OrderCommand& command) {
+    if (command.stopPrice && command.peak != 0)
+        throw std::invalid_argument("An order cannot have both a stop price and an iceberg peak");
+
+    EncodeCommand(Reserve(), command);
+    ++commandCount_;
+}
+
+void JournalWriter::Append(std::span<const OrderCommand> commands) {
+    for (const auto& command : commands)
+        Append(command);
+}
+
+void JournalWriter::AppendCheckpoint(const TradeChecksum& trades) {
+    EncodeCheckpoint(Reserve(), JournalCheckpoint{ commandCount_, trades.Count(), trades.Value() });
+}
+
+void JournalWriter::Commit() {
+    WriteAll(fd_, buffer_, "journal");
+
+    if (!buffer_.empty() && options_.sync && ::fdatasync(fd_) != 0)
+        ThrowErrno("sync journal");
+
+    buffer_.clear();
+}
+
+std::byte* JournalWriter::Reserve() {
+    if (buffer_.size() + JournalRecordSize > options_.groupCommitBytes && !buffer_.empty())
+        Commit();
+
+    buffer_.resize(buffer_.size() + JournalRecordSize);
+    return buffer_.data() + buffer_.size() - JournalRecordSize;
+}
+
+// ===============================
+//          JournalReader
+// ===============================
+
+JournalReader::JournalReader(const std::string& path)
+    : file_{ path } {
+    auto bytes = file_.data();
+    version_ = CheckHeader(bytes.data(), bytes.size(), path);
+    recordSize_ = version_ < 4 ? LegacyRecordSize : JournalRecordSize;
+    if (version_ >= 5 && LoadLE<Timestamp>(bytes.data() + 24) != 0)
+        session_ = SessionSchedule{ LoadLE<Timestamp>(bytes.data() + 16), LoadLE<Timestamp>(bytes.data() + 24) };
+    recordCount_ = bytes.size() / recordSize_ - 1;
+}
+
+bool JournalReader::Next(JournalRecord& record) {
+    if (next_ == recordCount_)
+        return false;
+
+    const auto* in = file_.data().data() + (next_ + 1) * recordSize_;
+    auto kind = static_cast<JournalRecordType>(in[0]);
+
+    bool valid = false;
+    if (kind == JournalRecordType::Command) {
+        valid = DecodeCommand(in, recordSize_, record.command);
+    } else if (kind == JournalRecordType::Checkpoint) {
+        record.checkpoint = JournalCheckpoint{
+            LoadLE<std::uint64_t>(in + 8), LoadLE<std::uint64_t>(in + 16), LoadLE<std::uint64_t>(in + 24)
+        };
+        valid = true;
+    }
+
+    if (!valid)
+        throw std::runtime_error(std::format("Malformed journal record ({})", next_));
+
+    record.type = kind;
+    ++next_;
+    return true;
+}
+
+// ===============================
+//             Replay
+// ===============================
+
+JournalReplayResult ReplayJournal(const std::string& path, Orderbook& book, OrderbookListener* listener) {
+    JournalReplayResult result;
+    ReplayListener replayListener{ result.trades, listener };
+
+    JournalReader reader{path};
+    if (reader.Session())
+        book.SetSessionSchedule(*reader.Session());
+
+    JournalRecord record;
+    while (reader.Next(record)) {
+        if (record.type == JournalRecordType::Checkpoint) {
+            const auto& expected = record.checkpoint;
+            if (expected.commandCount != result.commands || expected.tradeCount != result.trades.Count() ||
+                expected.tradeChecksum != result.trades.Value())
+                throw std::runtime_error(std::format(
+                    "Journal checkpoint after {} commands expected {} trades (checksum {:016x}), replay produced {} ({:016x})",
+                    expected.commandCount, expected.tradeCount, expected.tradeChecksum,
+                    result.trades.Count(), result.trades.Value()));
+
+            ++result.checkpoints;
+            continue;
+        }
+
+        ++result.commands;
+        try {
+            book.ProcessBatch({ &record.command, 1 }, replayListener);
+        } catch (const std::invalid_argument&) {
+            ++result.failedCommands;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,41 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) noexcept {
+    for (std::size_t i = 0; i < BucketCount; ++i)
+        counts_[i] += other.counts_[i];
+
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::Reset() noexcept {
+    *this = LatencyHistogram{};
+}
+
+std::uint64_t LatencyHistogram::ValueAtPercentile(double percentile) const noexcept {
+    if (count_ == 0)
+        return 0;
+
+    auto fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+    auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * count_)));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= target)
+            return std::clamp(BucketHighestValue(i), Min(), max_);
+    }
+    return max_;
+}
+
+std::uint64_t LatencyHistogram::BucketHighestValue(std::size_t index) noexcept {
+    if (index < 2 * SubBuckets)
+        return index;
+
+    auto exponent = static_cast<unsigned>(index >> SubBucketBits) - 1;
+    auto mantissa = static_cast<std::uint64_t>(index - (static_cast<std::size_t>(exponent) << SubBucketBits));
+    return (mantissa << exponent) + ((std::uint64_t{ 1 } << exponent) - 1);
+}
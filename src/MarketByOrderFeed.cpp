@@ -0,0 +1,129 @@
+#include "MarketByOrderFeed.h"
+#include "FileIO.h"
+#include "WireFormat.h"
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <thread>
+
+MarketByOrderMessage DecodeMarketByOrder(const std::byte* in) {
+    auto type = std::to_integer<std::uint8_t>(in[0]);
+    auto side = std::to_integer<std::uint8_t>(in[1]);
+
+    switch (static_cast<MarketByOrderType>(type)) {
+    case MarketByOrderType::Add:
+    case MarketByOrderType::Execute:
+    case MarketByOrderType::Reduce:
+    case MarketByOrderType::Delete:
+        break;
+    default:
+        throw std::runtime_error(std::format("Unknown market-by-order message type ({})", type));
+    }
+
+    if (side > static_cast<std::uint8_t>(Side::Sell))
+        throw std::runtime_error(std::format("Malformed market-by-order side ({})", side));
+
+    return MarketByOrderMessage{
+        LoadLE<std::uint64_t>(in + 8),
+        static_cast<MarketByOrderType>(type),
+        static_cast<Side>(side),
+        LoadLE<OrderID>(in + 16),
+        LoadLE<Price>(in + 24),
+        LoadLE<Quantity>(in + 4)
+    };
+}
+
+MarketByOrderFeed::MarketByOrderFeed(std::size_t capacity)
+    : ring_{ capacity } { }
+
+void MarketByOrderFeed::OnOrderAccepted(const Order& order) {
+    aggressor_ = order.GetOrderID();
+    incoming_ = order.GetOrderID();
+}
+
+void MarketByOrderFeed::OnStopTriggered(const Order& order) {
+    aggressor_ = order.GetOrderID();
+}
+
+void MarketByOrderFeed::OnTrade(const Trade& trade) {
+    // Trades follow the accept or trigger of their aggressor, so the other side is the resting order
+    const auto& bid = trade.GetBidTrade();
+    const auto& ask = trade.GetAskTrade();
+    if (bid.orderID != aggressor_)
+        Publish(MarketByOrderType::Execute, Side::Buy, bid.orderID, bid.price, bid.quantity);
+    if (ask.orderID != aggressor_)
+        Publish(MarketByOrderType::Execute, Side::Sell, ask.orderID, ask.price, ask.quantity);
+}
+
+void MarketByOrderFeed::OnOrderRested(const Order& order) {
+    incoming_ = 0;
+    Publish(MarketByOrderType::Add, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+            order.GetVisibleQuantity());
+}
+
+void MarketByOrderFeed::OnOrderReduced(const Order& order) {
+    Publish(MarketByOrderType::Reduce, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+            order.GetVisibleQuantity());
+}
+
+void MarketByOrderFeed::OnOrderReplenished(const Order& order) {
+    Publish(MarketByOrderType::Add, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+            order.GetVisibleQuantity());
+}
+
+void MarketByOrderFeed::OnOrderCancelled(const Order& order) {
+    // Remainders of IOC/FOK/Market orders and stops never reached the visible book,
+    // nor did an incoming order that self-trade prevention cancelled before it rested
+    if (!order.CanRest() || order.GetOrderID() == incoming_)
+        return;
+
+    Publish(MarketByOrderType::Delete, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+            order.GetVisibleQuantity());
+}
+
+void MarketByOrderFeed::OnUncross(const AuctionIndication& /*uncross*/) {
+    // Both sides of an uncross trade were resting, and nothing is incoming
+    aggressor_ = 0;
+    incoming_ = 0;
+}
+
+void MarketByOrderFeed::Publish(MarketByOrderType type, Side side, OrderID orderID, Price price, Quantity quantity) {
+    Message message{};
+    message[0] = static_cast<std::byte>(type);
+    message[1] = static_cast<std::byte>(side);
+    StoreLE(message.data() + 4, quantity);
+    StoreLE(message.data() + 8, ++sequence_);
+    StoreLE(message.data() + 16, orderID);
+    StoreLE(message.data() + 24, price);
+
+    if (ring_.TryPush(message))
+        return;
+
+    stalls_.fetch_add(1, std::memory_order_relaxed);
+    while (!ring_.TryPush(message))
+        std::this_thread::yield();
+}
+
+std::size_t MarketByOrderFeed::Read(std::span<std::byte> out) {
+    std::size_t written = 0;
+    Message message;
+    while (out.size() - written >= MarketByOrderMessageSize && ring_.TryPop(message)) {
+        std::memcpy(out.data() + written, message.data(), MarketByOrderMessageSize);
+        written += MarketByOrderMessageSize;
+    }
+    return written;
+}
+
+std::size_t MarketByOrderFeed::Flush(int fd) {
+    std::array<std::byte, 256 * MarketByOrderMessageSize> buffer;
+    std::size_t messages = 0;
+
+    for (;;) {
+        auto bytes = Read(buffer);
+        if (bytes == 0)
+            return messages;
+
+        WriteAll(fd, std::span{ buffer }.first(bytes), "market-by-order feed");
+        messages += bytes / MarketByOrderMessageSize;
+    }
+}
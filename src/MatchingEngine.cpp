@@ -0,0 +1,164 @@
+#include "MatchingEngine.h"
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+    OrderbookListener nullListener;
+}
+
+MatchingEngine::MatchingEngine(const MatchingEngineConfig& config)
+    : config_{ config } {
+    if (config.workerCount == 0)
+        throw std::invalid_argument("MatchingEngine needs at least one worker");
+
+    workers_.reserve(config.workerCount);
+    for (std::size_t i = 0; i < config.workerCount; ++i)
+        workers_.push_back(std::make_unique<Worker>(config.queueCapacity));
+}
+
+MatchingEngine::~MatchingEngine() {
+    Stop();
+}
+
+void MatchingEngine::AddInstrument(InstrumentID instrument, std::optional<LadderConfig> ladder,
+                                   OrderbookListener* listener, DepthPublisher* depth,
+                                   std::optional<SessionSchedule> session) {
+    if (running_)
+        throw std::invalid_argument("Instruments must be added before the engine starts");
+
+    if (routes_.contains(instrument))
+        throw std::invalid_argument(std::format("Instrument ({}) already exists", instrument));
+
+    if (session && session->length == 0)
+        throw std::invalid_argument("Session length must be positive");
+
+    auto least = std::min_element(workers_.begin(), workers_.end(), [](const auto& a, const auto& b) {
+        return a->books.size() < b->books.size();
+    });
+
+    auto& worker = **least;
+    auto& book = worker.books.emplace_back(std::make_unique<Book>(Book{
+        ladder ? Orderbook{*ladder} : Orderbook{},
+        listener ? listener : &nullListener,
+        depth
+    }));
+    if (session)
+        book->orderbook.SetSessionSchedule(*session);
+
+    routes_.emplace(instrument, Route{ static_cast<std::size_t>(least - workers_.begin()), book.get() });
+}
+
+void MatchingEngine::Start() {
+    if (running_.exchange(true))
+        return;
+
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        auto& worker = *workers_[i];
+        worker.thread = std::thread([this, &worker, core = config_.firstCore + i] { Run(worker, core); });
+    }
+}
+
+void MatchingEngine::Stop() {
+    if (!running_.exchange(false))
+        return;
+
+    for (auto& worker : workers_)
+        if (worker->thread.joinable())
+            worker->thread.join();
+}
+
+void MatchingEngine::Submit(InstrumentID instrument, const OrderCommand& command) {
+    const auto& route = RouteFor(instrument);
+    auto& worker = *workers_[route.worker];
+    if (!running_.load(std::memory_order_acquire))
+        throw std::logic_error("MatchingEngine::Submit needs a running engine; use TrySubmit before Start");
+
+    while (!worker.queue.TryPush(Task{ route.book, command }))
+        std::this_thread::yield();
+
+    ++worker.submitted;
+}
+
+bool MatchingEngine::TrySubmit(InstrumentID instrument, const OrderCommand& command) {
+    const auto& route = RouteFor(instrument);
+    auto& worker = *workers_[route.worker];
+
+    if (!worker.queue.TryPush(Task{ route.book, command }))
+        return false;
+
+    ++worker.submitted;
+    return true;
+}
+
+void MatchingEngine::WaitIdle() const {
+    for (const auto& worker : workers_) {
+        if (!running_.load(std::memory_order_acquire) &&
+            worker->processed.load(std::memory_order_acquire) != worker->submitted)
+            throw std::logic_error("Commands are queued but the engine is not running");
+        while (worker->processed.load(std::memory_order_acquire) != worker->submitted)
+            std::this_thread::yield();
+    }
+}
+
+std::size_t MatchingEngine::WorkerFor(InstrumentID instrument) const {
+    return RouteFor(instrument).worker;
+}
+
+Orderbook& MatchingEngine::GetBook(InstrumentID instrument) {
+    return RouteFor(instrument).book->orderbook;
+}
+
+std::uint64_t MatchingEngine::FailedCommands() const noexcept {
+    std::uint64_t failed = 0;
+    for (const auto& worker : workers_)
+        failed += worker->failed.load(std::memory_order_relaxed);
+    return failed;
+}
+
+void MatchingEngine::Run(Worker& worker, std::size_t core) {
+#ifdef __linux__
+    if (config_.pinThreads) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#else
+    (void)core;
+#endif
+
+    Task task;
+    for (;;) {
+        if (!worker.queue.TryPop(task)) {
+            // Drain everything queued before Stop was requested
+            if (!running_.load(std::memory_order_acquire) && worker.queue.empty())
+                return;
+            std::this_thread::yield();
+            continue;
+        }
+
+        try {
+            task.book->orderbook.ProcessBatch({ &task.command, 1 }, *task.book->listener);
+        } catch (const std::exception&) {
+            worker.failed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (task.book->depth)
+            task.book->depth->Publish(task.book->orderbook);
+
+        worker.processed.fetch_add(1, std::memory_order_release);
+    }
+}
+
+const MatchingEngine::Route& MatchingEngine::RouteFor(InstrumentID instrument) const {
+    auto it = routes_.find(instrument);
+    if (it == routes_.end())
+        throw std::invalid_argument(std::format("Unknown instrument ({})", instrument));
+    return it->second;
+}
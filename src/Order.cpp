@@ -1,17 +1,23 @@
 #include "Order.h"
+#include <algorithm>
 #include <format>
 #include <stdexcept>
 #include <limits>
 
 
-Order::Order(OrderType orderType, OrderID orderID, Side side, Price price, Quantity quantity, std::optional<Price> stopPrice) :
+Order::Order(OrderType orderType, OrderID orderID, Side side, Price price, Quantity quantity,
+             std::optional<Price> stopPrice, OwnerID owner, Quantity peak, Timestamp expiry) :
     orderType_ { orderType },
+    owner_ { owner },
     orderID_ { orderID },
     side_ { side },
     price_ { (orderType == OrderType::Market) ? ((side == Side::Buy) ? MAX_PRICE : MIN_PRICE) : price},
     stopPrice_ { stopPrice},
     initialQuantity_ { quantity },
-    remainingQuantity_ { quantity }
+    remainingQuantity_ { quantity },
+    peakQuantity_ { peak },
+    visibleQuantity_ { (peak != 0) ? std::min(peak, quantity) : quantity },
+    expiry_ { expiry }
     { }
 
 bool Order::IsFilled() const noexcept { 
@@ -22,9 +28,59 @@ bool Order::IsStopOrder() const noexcept {
     return stopPrice_.has_value();
 }
 
+bool Order::CanRest() const noexcept {
+    return !IsStopOrder() &&
+        (GetOrderType() == OrderType::GoodTillCancel || GetOrderType() == OrderType::PostOnly || CanExpire());
+}
+
+bool Order::CanExpire() const noexcept {
+    return GetOrderType() == OrderType::GoodTillDate || GetOrderType() == OrderType::Day;
+}
+
+void Order::Validate() const {
+    if (GetRemainingQuantity() == 0)
+        throw std::invalid_argument("Order quantity must be greater than zero");
+
+    if (GetPrice() < 0)
+        throw std::invalid_argument("Order price must be positive");
+
+    if (IsIceberg() && !CanRest())
+        throw std::invalid_argument("Only orders that can rest can be icebergs");
+
+    if (!CanExpire() && GetExpiry() != 0)
+        throw std::invalid_argument("Only GoodTillDate and Day orders can have an expiry");
+
+    if (GetOrderType() == OrderType::GoodTillDate && GetExpiry() == 0)
+        throw std::invalid_argument("GoodTillDate orders need an expiry");
+}
+
 void Order::Fill(Quantity quantity) {
     if (quantity > GetRemainingQuantity())
             throw std::logic_error(std::format("Order ({}) cannot be filled for more than its remaining quantity.", GetOrderID()));
 
         remainingQuantity_ -= quantity;
+        // Resting orders only fill from what is displayed; an aggressive iceberg trades its whole size
+        visibleQuantity_ -= std::min(quantity, visibleQuantity_);
+}
+
+void Order::Reduce(Quantity quantity) {
+    if (quantity > GetRemainingQuantity())
+        throw std::logic_error(std::format("Order ({}) cannot be reduced by more than its remaining quantity.", GetOrderID()));
+
+    initialQuantity_ -= quantity;
+    remainingQuantity_ -= quantity;
+    // Comes out of the hidden reserve first
+    visibleQuantity_ = std::min(visibleQuantity_, remainingQuantity_);
+}
+
+void Order::Replenish() noexcept {
+    visibleQuantity_ = IsIceberg() ? std::min(peakQuantity_, remainingQuantity_) : remainingQuantity_;
+}
+
+void Order::SetVisibleQuantity(Quantity quantity) {
+    if (quantity == 0 || quantity > GetRemainingQuantity() || (IsIceberg() && quantity > GetPeakQuantity()) ||
+        (!IsIceberg() && quantity != GetRemainingQuantity()))
+        throw std::logic_error(std::format("Order ({}) cannot display {} of its remaining quantity.", GetOrderID(), quantity));
+
+    visibleQuantity_ = quantity;
 }
\ No newline at end of file
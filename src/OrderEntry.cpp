@@ -0,0 +1,315 @@
+#include "OrderEntry.h"
+#include "Orderbook.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+namespace {
+    // Values of a new order's extra byte, saying what its last field holds (0: nothing)
+    constexpr std::uint8_t StopExtra = 1;
+    constexpr std::uint8_t PeakExtra = 2;
+
+    // Size of the message starting with type byte, or 0 if the type is unknown
+    std::size_t MessageSize(std::uint8_t type) noexcept {
+        switch (static_cast<OrderEntryType>(type)) {
+        case OrderEntryType::New: return NewOrderMessageSize;
+        case OrderEntryType::Cancel: return CancelOrderMessageSize;
+        case OrderEntryType::Modify: return ModifyOrderMessageSize;
+        }
+        return 0;
+    }
+
+    bool IsValid(const std::byte* in) noexcept {
+        auto byte = [&](std::size_t offset) { return std::to_integer<std::uint8_t>(in[offset]); };
+        constexpr auto MaxSide = static_cast<std::uint8_t>(Side::Sell);
+
+        switch (static_cast<OrderEntryType>(byte(0))) {
+        case OrderEntryType::New:
+            return byte(1) <= static_cast<std::uint8_t>(OrderType::Day) && byte(2) <= MaxSide && byte(3) <= PeakExtra;
+        case OrderEntryType::Modify:
+            return byte(1) <= MaxSide;
+        case OrderEntryType::Cancel:
+            return true;
+        }
+        return false;
+    }
+}
+
+// ===============================
+//        Inbound messages
+// ===============================
+
+std::size_t OrderEntryMessage::Size() const noexcept {
+    return MessageSize(std::to_integer<std::uint8_t>(data_[0]));
+}
+
+std::optional<Price> OrderEntryMessage::GetStopPrice() const noexcept {
+    if (std::to_integer<std::uint8_t>(data_[3]) != StopExtra)
+        return std::nullopt;
+    return LoadLE<Price>(data_ + 20);
+}
+
+Quantity OrderEntryMessage::GetPeakQuantity() const noexcept {
+    if (std::to_integer<std::uint8_t>(data_[3]) != PeakExtra)
+        return 0;
+    return LoadLE<Quantity>(data_ + 20);
+}
+
+OrderCommand OrderEntryMessage::ToCommand() const {
+    switch (GetType()) {
+    case OrderEntryType::New:
+        return OrderCommand::Add(GetOrderType(), GetOrderID(), GetSide(), GetPrice(), GetQuantity(), GetStopPrice(),
+                                 NoOwner, GetPeakQuantity(), GetExpiry());
+    case OrderEntryType::Cancel:
+        return OrderCommand::Cancel(GetOrderID());
+    case OrderEntryType::Modify:
+        break;
+    }
+    return OrderCommand::Modify(OrderModify{ GetOrderID(), GetSide(), GetPrice(), GetQuantity() });
+}
+
+bool OrderEntryReader::Next(OrderEntryMessage& message) {
+    if (offset_ == buffer_.size())
+        return false;
+
+    const auto* in = buffer_.data() + offset_;
+    auto size = MessageSize(std::to_integer<std::uint8_t>(in[0]));
+    if (size == 0 || (buffer_.size() - offset_ >= size && !IsValid(in)))
+        throw std::runtime_error(std::format("Malformed order-entry message at offset {}", offset_));
+
+    if (buffer_.size() - offset_ < size)
+        return false;
+
+    message = OrderEntryMessage{ in };
+    offset_ += size;
+    return true;
+}
+
+std::size_t EncodeOrderEntry(const OrderCommand& command, std::byte* out) {
+    std::memset(out, 0, MaxOrderEntryMessageSize);
+    StoreLE(out + 8, command.orderID);
+
+    switch (command.type) {
+    case CommandType::Add:
+        if (command.stopPrice && command.peak != 0)
+            throw std::invalid_argument("An order cannot have both a stop price and an iceberg peak");
+
+        out[0] = static_cast<std::byte>(OrderEntryType::New);
+        out[1] = static_cast<std::byte>(command.orderType);
+        out[2] = static_cast<std::byte>(command.side);
+        StoreLE(out + 4, command.quantity);
+        StoreLE(out + 16, command.price);
+        if (command.stopPrice) {
+            out[3] = static_cast<std::byte>(StopExtra);
+            StoreLE(out + 20, *command.stopPrice);
+        } else if (command.peak != 0) {
+            out[3] = static_cast<std::byte>(PeakExtra);
+            StoreLE(out + 20, command.peak);
+        }
+        StoreLE(out + 24, command.time);
+        return NewOrderMessageSize;
+    case CommandType::Cancel:
+        out[0] = static_cast<std::byte>(OrderEntryType::Cancel);
+        return CancelOrderMessageSize;
+    case CommandType::Modify:
+        break;
+    case CommandType::AdvanceTime:
+        throw std::invalid_argument("Time is not advanced through order entry");
+    case CommandType::StartAuction:
+    case CommandType::Uncross:
+        throw std::invalid_argument("Auctions are not run through order entry");
+    }
+
+    out[0] = static_cast<std::byte>(OrderEntryType::Modify);
+    out[1] = static_cast<std::byte>(command.side);
+    StoreLE(out + 4, command.quantity);
+    StoreLE(out + 16, command.price);
+    return ModifyOrderMessageSize;
+}
+
+// ===============================
+//        Execution reports
+// ===============================
+
+void EncodeExecutionReport(const ExecutionReport& report, std::byte* out) noexcept {
+    std::fill_n(out, ExecutionReportSize, std::byte{ 0 });
+    out[0] = static_cast<std::byte>(report.type);
+    out[1] = static_cast<std::byte>(report.side);
+    out[2] = static_cast<std::byte>(report.reason);
+    StoreLE(out + 4, report.quantity);
+    StoreLE(out + 8, report.orderID);
+    StoreLE(out + 16, report.price);
+    StoreLE(out + 20, report.owner);
+    StoreLE(out + 24, report.sequence);
+}
+
+ExecutionReport DecodeExecutionReport(const std::byte* in) {
+    auto type = std::to_integer<std::uint8_t>(in[0]);
+    switch (static_cast<ExecutionReportType>(type)) {
+    case ExecutionReportType::Accepted:
+    case ExecutionReportType::Rejected:
+    case ExecutionReportType::Fill:
+    case ExecutionReportType::Cancelled:
+    case ExecutionReportType::Reduced:
+    case ExecutionReportType::Triggered:
+        break;
+    default:
+        throw std::runtime_error(std::format("Unknown execution report type ({})", type));
+    }
+
+    auto side = std::to_integer<std::uint8_t>(in[1]);
+    if (side > static_cast<std::uint8_t>(Side::Sell))
+        throw std::runtime_error(std::format("Malformed execution report side ({})", side));
+
+    return ExecutionReport{
+        LoadLE<std::uint64_t>(in + 24),
+        static_cast<ExecutionReportType>(type),
+        static_cast<Side>(side),
+        std::to_integer<std::uint8_t>(in[2]),
+        LoadLE<OrderID>(in + 8),
+        LoadLE<Price>(in + 16),
+        LoadLE<Quantity>(in + 4),
+        LoadLE<OwnerID>(in + 20)
+    };
+}
+
+void ExecutionReportBuilder::OnOrderAccepted(const Order& order) {
+    Build(ExecutionReportType::Accepted, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+          order.GetRemainingQuantity(), order.GetOwner());
+}
+
+void ExecutionReportBuilder::OnOrderRejected(const Order& order, RejectReason reason) {
+    Build(ExecutionReportType::Rejected, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+          order.GetRemainingQuantity(), order.GetOwner(), static_cast<std::uint8_t>(reason));
+}
+
+void ExecutionReportBuilder::OnTrade(const Trade& trade) {
+    OnFill(Side::Buy, trade.GetBidTrade());
+    OnFill(Side::Sell, trade.GetAskTrade());
+}
+
+void ExecutionReportBuilder::OnFill(Side side, const TradeInfo& fill) {
+    Build(ExecutionReportType::Fill, side, fill.orderID, fill.price, fill.quantity, fill.owner);
+}
+
+void ExecutionReportBuilder::OnOrderCancelled(const Order& order) {
+    Build(ExecutionReportType::Cancelled, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+          order.GetRemainingQuantity(), order.GetOwner());
+}
+
+void ExecutionReportBuilder::OnOrderReduced(const Order& order) {
+    Build(ExecutionReportType::Reduced, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+          order.GetRemainingQuantity(), order.GetOwner());
+}
+
+void ExecutionReportBuilder::OnStopTriggered(const Order& order) {
+    Build(ExecutionReportType::Triggered, order.GetSide(), order.GetOrderID(), order.GetPrice(),
+          order.GetRemainingQuantity(), order.GetOwner());
+}
+
+void ExecutionReportBuilder::RejectInvalid(const OrderCommand& command, std::uint8_t reason) {
+    Build(ExecutionReportType::Rejected, command.side, command.orderID, command.price, command.quantity,
+          command.owner, reason);
+}
+
+void ExecutionReportBuilder::Build(ExecutionReportType type, Side side, OrderID orderID, Price price,
+                                   Quantity quantity, OwnerID owner, std::uint8_t reason) {
+    Emit(ExecutionReport{ ++sequence_, type, side, reason, orderID, price, quantity, owner });
+}
+
+void ExecutionReportEncoder::Emit(const ExecutionReport& report) {
+    buffer_.resize(buffer_.size() + ExecutionReportSize);
+    EncodeExecutionReport(report, buffer_.data() + buffer_.size() - ExecutionReportSize);
+}
+
+// ===============================
+//             Router
+// ===============================
+
+ExecutionReportBuilder* ExecutionReportRouter::Find(OwnerID owner) const noexcept {
+    auto it = sessions_.find(owner);
+    return it == sessions_.end() ? nullptr : it->second;
+}
+
+void ExecutionReportRouter::OnOrderAccepted(const Order& order) {
+    if (auto* session = Find(order.GetOwner()))
+        session->OnOrderAccepted(order);
+}
+
+void ExecutionReportRouter::OnOrderRejected(const Order& order, RejectReason reason) {
+    if (auto* session = Find(order.GetOwner()))
+        session->OnOrderRejected(order, reason);
+}
+
+void ExecutionReportRouter::OnTrade(const Trade& trade) {
+    if (auto* session = Find(trade.GetBidTrade().owner))
+        session->OnFill(Side::Buy, trade.GetBidTrade());
+    if (auto* session = Find(trade.GetAskTrade().owner))
+        session->OnFill(Side::Sell, trade.GetAskTrade());
+}
+
+void ExecutionReportRouter::OnOrderCancelled(const Order& order) {
+    if (auto* session = Find(order.GetOwner()))
+        session->OnOrderCancelled(order);
+}
+
+void ExecutionReportRouter::OnOrderReduced(const Order& order) {
+    if (auto* session = Find(order.GetOwner()))
+        session->OnOrderReduced(order);
+}
+
+void ExecutionReportRouter::OnStopTriggered(const Order& order) {
+    if (auto* session = Find(order.GetOwner()))
+        session->OnStopTriggered(order);
+}
+
+// ===============================
+//            Session
+// ===============================
+
+OrderEntrySession::OrderEntrySession(Orderbook& book, OwnerID owner)
+    : book_{ book }, owner_{ owner } { }
+
+OrderEntrySession::OrderEntrySession(ExecutionReportRouter& router, OwnerID owner)
+    : book_{ router.GetBook() }, owner_{ owner }, router_{ &router } {
+    if (owner == NoOwner)
+        throw std::invalid_argument("A session sharing a book needs an owner");
+    if (!router.sessions_.emplace(owner, &encoder_).second)
+        throw std::invalid_argument(std::format("Owner ({}) already has a session", owner));
+}
+
+OrderEntrySession::~OrderEntrySession() {
+    if (router_)
+        router_->sessions_.erase(owner_);
+}
+
+std::size_t OrderEntrySession::Process(std::span<const std::byte> input) {
+    OrderEntryReader reader{input};
+    OrderEntryMessage message;
+    while (reader.Next(message)) {
+        auto command = message.ToCommand();
+        command.owner = owner_;
+        ++messages_;
+
+        // Unknown IDs go through: the book ignores them, as it would for the owner
+        if (command.type != CommandType::Add) {
+            const auto* order = book_.GetOrder(command.orderID);
+            if (order && order->GetOwner() != owner_) {
+                encoder_.RejectInvalid(command, NotOwnerReason);
+                continue;
+            }
+        }
+
+        try {
+            if (router_)
+                book_.ProcessBatch({ &command, 1 }, *router_);
+            else
+                book_.ProcessBatch({ &command, 1 }, encoder_);
+        } catch (const std::invalid_argument&) {
+            encoder_.RejectInvalid(command);
+        }
+    }
+
+    return reader.Consumed();
+}
@@ -0,0 +1,258 @@
+#include "OrderFlowFile.h"
+#include "FileIO.h"
+#include "OrderEntry.h"
+#include <array>
+#include <charconv>
+#include <format>
+#include <stdexcept>
+
+namespace {
+    struct OrderTypeName {
+        OrderType type;
+        std::string_view name;
+    };
+
+    constexpr std::array<OrderTypeName, 8> OrderTypeNames{ {
+        { OrderType::GoodTillCancel, "GTC" },
+        { OrderType::PostOnly, "POST" },
+        { OrderType::Market, "MKT" },
+        { OrderType::StopOrder, "STOP" },
+        { OrderType::FillAndKill, "FAK" },
+        { OrderType::FillOrKill, "FOK" },
+        { OrderType::GoodTillDate, "GTD" },
+        { OrderType::Day, "DAY" }
+    } };
+
+    std::string_view OrderTypeToName(OrderType type) {
+        for (const auto& entry : OrderTypeNames)
+            if (entry.type == type)
+                return entry.name;
+        throw std::invalid_argument("Unknown order type");
+    }
+
+    // Splits one CSV line into fields without copying; fails the line instead of
+    // guessing when a field is missing or malformed
+    class LineParser {
+    public:
+        LineParser(std::string_view line, std::size_t lineNumber) : rest_{ line }, lineNumber_{ lineNumber } { }
+
+        [[nodiscard]] bool AtEnd() const noexcept { return done_; }
+
+        std::string_view Field() {
+            if (done_)
+                Fail("missing field");
+
+            auto comma = rest_.find(',');
+            auto field = rest_.substr(0, comma);
+            if (comma == std::string_view::npos)
+                done_ = true;
+            else
+                rest_.remove_prefix(comma + 1);
+            return field;
+        }
+
+        template <typename T>
+        T Number() {
+            auto field = Field();
+            T value{};
+            auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+            if (error != std::errc{} || end != field.data() + field.size())
+                Fail(std::format("bad number '{}'", field));
+            return value;
+        }
+
+        template <typename T>
+        std::optional<T> OptionalNumber() {
+            if (!done_ && (rest_.empty() || rest_.front() == ',')) {
+                Field();
+                return std::nullopt;
+            }
+            return Number<T>();
+        }
+
+        Side GetSide() {
+            auto field = Field();
+            if (field == "B")
+                return Side::Buy;
+            if (field == "S")
+                return Side::Sell;
+            Fail(std::format("bad side '{}'", field));
+        }
+
+        OrderType GetOrderType() {
+            auto field = Field();
+            for (const auto& entry : OrderTypeNames)
+                if (entry.name == field)
+                    return entry.type;
+            Fail(std::format("bad order type '{}'", field));
+        }
+
+        void ExpectEnd() {
+            if (!done_)
+                Fail("too many fields");
+        }
+
+        [[noreturn]] void Fail(const std::string& what) const {
+            throw std::runtime_error(std::format("Order flow line {}: {}", lineNumber_, what));
+        }
+
+    private:
+        std::string_view rest_;
+        std::size_t lineNumber_;
+        bool done_{ false };
+    };
+
+    OrderCommand ParseLine(std::string_view line, std::size_t lineNumber) {
+        LineParser parser{line, lineNumber};
+        auto kind = parser.Field();
+
+        OrderCommand command;
+        if (kind == "A") {
+            auto orderType = parser.GetOrderType();
+            auto orderID = parser.Number<OrderID>();
+            auto side = parser.GetSide();
+            auto price = parser.Number<Price>();
+            auto quantity = parser.Number<Quantity>();
+            std::optional<Price> stopPrice;
+            OwnerID owner = NoOwner;
+            Quantity peak = 0;
+            Timestamp expiry = 0;
+            if (!parser.AtEnd())
+                stopPrice = parser.OptionalNumber<Price>();
+            if (!parser.AtEnd())
+                owner = parser.OptionalNumber<OwnerID>().value_or(NoOwner);
+            if (!parser.AtEnd())
+                peak = parser.OptionalNumber<Quantity>().value_or(0);
+            if (!parser.AtEnd())
+                expiry = parser.Number<Timestamp>();
+            command = OrderCommand::Add(orderType, orderID, side, price, quantity, stopPrice, owner, peak, expiry);
+        } else if (kind == "C") {
+            command = OrderCommand::Cancel(parser.Number<OrderID>());
+        } else if (kind == "M") {
+            auto orderID = parser.Number<OrderID>();
+            auto side = parser.GetSide();
+            auto price = parser.Number<Price>();
+            auto quantity = parser.Number<Quantity>();
+            command = OrderCommand::Modify(OrderModify{ orderID, side, price, quantity });
+        } else if (kind == "T") {
+            command = OrderCommand::AdvanceTime(parser.Number<Timestamp>());
+        } else if (kind == "S") {
+            command = OrderCommand::StartAuction(parser.Number<Price>());
+        } else if (kind == "U") {
+            command = OrderCommand::Uncross();
+        } else {
+            parser.Fail(std::format("unknown command '{}'", kind));
+        }
+
+        parser.ExpectEnd();
+        return command;
+    }
+
+    bool IsCsv(const std::string& path) {
+        return path.ends_with(".csv");
+    }
+
+    std::vector<OrderCommand> DecodeOrderEntryCapture(std::span<const std::byte> bytes) {
+        std::vector<OrderCommand> commands;
+        commands.reserve(bytes.size() / NewOrderMessageSize);
+
+        OrderEntryReader reader{bytes};
+        OrderEntryMessage message;
+        while (reader.Next(message))
+            commands.push_back(message.ToCommand());
+
+        if (reader.Consumed() != bytes.size())
+            throw std::runtime_error(std::format("Order flow ends with a partial message ({} bytes)",
+                                                 bytes.size() - reader.Consumed()));
+        return commands;
+    }
+}
+
+std::vector<OrderCommand> ParseOrderFlowCsv(std::string_view text) {
+    std::vector<OrderCommand> commands;
+    // Lines are at least a dozen bytes; avoids most regrowth on large files
+    commands.reserve(text.size() / 16);
+
+    std::size_t lineNumber = 0;
+    while (!text.empty()) {
+        auto newline = text.find('\n');
+        auto line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        ++lineNumber;
+
+        if (line.ends_with('\r'))
+            line.remove_suffix(1);
+        if (line.empty() || line.front() == '#')
+            continue;
+
+        commands.push_back(ParseLine(line, lineNumber));
+    }
+
+    return commands;
+}
+
+std::string FormatOrderFlowCsv(std::span<const OrderCommand> commands) {
+    std::string text;
+    auto sideName = [](Side side) { return side == Side::Buy ? 'B' : 'S'; };
+
+    for (const auto& command : commands) {
+        switch (command.type) {
+        case CommandType::Add:
+            text += std::format("A,{},{},{},{},{}", OrderTypeToName(command.orderType), command.orderID,
+                                sideName(command.side), command.price, command.quantity);
+            // Optional trailing fields, written up to the last one that is set
+            if (command.stopPrice || command.owner != NoOwner || command.peak != 0 || command.time != 0)
+                text += command.stopPrice ? std::format(",{}", *command.stopPrice) : ",";
+            if (command.owner != NoOwner || command.peak != 0 || command.time != 0)
+                text += command.owner != NoOwner ? std::format(",{}", command.owner) : ",";
+            if (command.peak != 0 || command.time != 0)
+                text += command.peak != 0 ? std::format(",{}", command.peak) : ",";
+            if (command.time != 0)
+                text += std::format(",{}", command.time);
+            break;
+        case CommandType::Cancel:
+            text += std::format("C,{}", command.orderID);
+            break;
+        case CommandType::Modify:
+            text += std::format("M,{},{},{},{}", command.orderID, sideName(command.side), command.price,
+                                command.quantity);
+            break;
+        case CommandType::AdvanceTime:
+            text += std::format("T,{}", command.time);
+            break;
+        case CommandType::StartAuction:
+            text += std::format("S,{}", command.price);
+            break;
+        case CommandType::Uncross:
+            text += "U";
+            break;
+        }
+        text.push_back('\n');
+    }
+
+    return text;
+}
+
+std::vector<OrderCommand> LoadOrderFlow(const std::string& path) {
+    MappedFile file{path};
+    auto bytes = file.data();
+
+    if (!IsCsv(path))
+        return DecodeOrderEntryCapture(bytes);
+    return ParseOrderFlowCsv({ reinterpret_cast<const char*>(bytes.data()), bytes.size() });
+}
+
+void SaveOrderFlow(const std::string& path, std::span<const OrderCommand> commands) {
+    if (IsCsv(path)) {
+        auto text = FormatOrderFlowCsv(commands);
+        WriteFileAtomically(path, std::as_bytes(std::span{ text }));
+        return;
+    }
+
+    std::vector<std::byte> bytes(commands.size() * MaxOrderEntryMessageSize);
+    std::size_t size = 0;
+    for (const auto& command : commands)
+        size += EncodeOrderEntry(command, bytes.data() + size);
+    bytes.resize(size);
+    WriteFileAtomically(path, bytes);
+}
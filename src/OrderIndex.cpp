@@ -0,0 +1,96 @@
+#include "OrderIndex.h"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+OrderIndex::OrderIndex(std::size_t capacity) {
+    Rehash(std::bit_ceil(std::max<std::size_t>(capacity, 16)));
+}
+
+OrderIndex::OrderIndex(OrderIndex&& other) noexcept
+    : slots_{ std::exchange(other.slots_, {}) }, mask_{ std::exchange(other.mask_, 0) },
+      shift_{ std::exchange(other.shift_, 64) }, size_{ std::exchange(other.size_, 0) } { }
+
+OrderIndex& OrderIndex::operator=(OrderIndex&& other) noexcept {
+    if (this != &other) {
+        slots_ = std::exchange(other.slots_, {});
+        mask_ = std::exchange(other.mask_, 0);
+        shift_ = std::exchange(other.shift_, 64);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+bool OrderIndex::insert(OrderID orderID, OrderNode* node) {
+    // Keep load factor at or below 1/2; a moved-from index starts over at 16 slots
+    if ((size_ + 1) * 2 > slots_.size())
+        Rehash(std::max<std::size_t>(slots_.size() * 2, 16));
+
+    for (auto slot = SlotFor(orderID);; slot = (slot + 1) & mask_) {
+        auto& entry = slots_[slot];
+        if (!entry.node) {
+            entry = { orderID, node };
+            ++size_;
+            return true;
+        }
+        if (entry.orderID == orderID)
+            return false;
+    }
+}
+
+OrderNode* OrderIndex::extract(OrderID orderID) noexcept {
+    if (size_ == 0)
+        return nullptr;
+
+    auto hole = SlotFor(orderID);
+    for (;; hole = (hole + 1) & mask_) {
+        const auto& entry = slots_[hole];
+        if (!entry.node)
+            return nullptr;
+        if (entry.orderID == orderID)
+            break;
+    }
+
+    auto* node = slots_[hole].node;
+
+    // Backward-shift: pull later entries of the cluster into the hole when their
+    // home slot does not lie cyclically in (hole, current]
+    for (auto slot = (hole + 1) & mask_; slots_[slot].node; slot = (slot + 1) & mask_) {
+        auto home = SlotFor(slots_[slot].orderID);
+        if (((slot - home) & mask_) >= ((slot - hole) & mask_)) {
+            slots_[hole] = slots_[slot];
+            hole = slot;
+        }
+    }
+
+    slots_[hole] = Entry{};
+    --size_;
+    return node;
+}
+
+void OrderIndex::reserve(std::size_t count) {
+    auto capacity = std::bit_ceil(std::max<std::size_t>(count * 2, 16));
+    if (capacity > slots_.size())
+        Rehash(capacity);
+}
+
+void OrderIndex::clear() noexcept {
+    std::fill(slots_.begin(), slots_.end(), Entry{});
+    size_ = 0;
+}
+
+void OrderIndex::Rehash(std::size_t capacity) {
+    auto previous = std::exchange(slots_, std::vector<Entry>(capacity));
+    mask_ = capacity - 1;
+    shift_ = 64 - static_cast<unsigned>(std::countr_zero(capacity));
+
+    for (const auto& entry : previous) {
+        if (!entry.node)
+            continue;
+
+        auto slot = SlotFor(entry.orderID);
+        while (slots_[slot].node)
+            slot = (slot + 1) & mask_;
+        slots_[slot] = entry;
+    }
+}
@@ -3,6 +3,11 @@
 OrderModify::OrderModify(OrderID orderID, Side side, Price price, Quantity quantity)
     : orderID_{orderID}, side_{side}, price_{price}, quantity_{quantity} {}
 
-OrderPointer OrderModify::ToOrderPointer(OrderType type) const {
-    return std::make_shared<Order>(type, GetOrderID(), GetSide(), GetPrice(), GetQuantity());
+OrderPointer OrderModify::ToOrderPointer(OrderType type, OwnerID owner, Quantity peak, Timestamp expiry) const {
+    return std::make_shared<Order>(type, GetOrderID(), GetSide(), GetPrice(), GetQuantity(), std::nullopt, owner, peak,
+                                   expiry);
+}
+
+Order OrderModify::ToOrder(OrderType type, OwnerID owner, Quantity peak, Timestamp expiry) const {
+    return Order{type, GetOrderID(), GetSide(), GetPrice(), GetQuantity(), std::nullopt, owner, peak, expiry};
 }
\ No newline at end of file
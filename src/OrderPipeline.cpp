@@ -0,0 +1,332 @@
+#include "OrderPipeline.h"
+#include "Journal.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+    std::size_t RingSize(std::size_t capacity, const char* ring) {
+        if (capacity == 0)
+            throw std::invalid_argument(std::string{ "OrderPipeline needs a non-empty " } + ring + " ring");
+        return std::bit_ceil(capacity);
+    }
+}
+
+// ===============================
+//          Event writer
+// ===============================
+
+/**
+ * The matcher's listener: builds execution reports and copies them, and the
+ * book's level updates, straight into event ring slots. Events are made
+ * visible once per command, or early if the ring fills mid-command.
+ */
+class OrderPipeline::EventWriter final : public ExecutionReportBuilder {
+public:
+    explicit EventWriter(OrderPipeline& pipeline) : pipeline_{ pipeline } { }
+
+    void Begin(std::uint64_t command) noexcept { command_ = command; }
+
+    void Publish() noexcept {
+        pipeline_.eventsPublished_.value.store(written_, std::memory_order_release);
+    }
+
+    void OnLevelUpdate(const LevelUpdate& update) override {
+        Next(PipelineEvent::Kind::LevelUpdate).level = update;
+    }
+
+protected:
+    void Emit(const ExecutionReport& report) override {
+        Next(PipelineEvent::Kind::Report).report = report;
+    }
+
+private:
+    PipelineEvent& Next(PipelineEvent::Kind kind) noexcept {
+        auto& events = pipeline_.events_;
+        if (pipeline_.stages_.empty())
+            return scratch_;
+
+        if (written_ - gate_ == events.size()) {
+            // Stages may be waiting on this very command's events
+            Publish();
+            while (written_ - (gate_ = pipeline_.EventGate()) == events.size()) {
+                // Nobody will free the slot; drop events until the matcher sees the halt
+                if (pipeline_.halted_.load(std::memory_order_acquire))
+                    return scratch_;
+                std::this_thread::yield();
+            }
+        }
+
+        auto& event = events[written_++ & pipeline_.eventMask_];
+        event.command = command_;
+        event.kind = kind;
+        return event;
+    }
+
+    OrderPipeline& pipeline_;
+    std::uint64_t command_{ 0 };
+    std::uint64_t written_{ 0 };
+    std::uint64_t gate_{ 0 };   // matcher's view of EventGate()
+    PipelineEvent scratch_;
+};
+
+// ===============================
+//            Pipeline
+// ===============================
+
+OrderPipeline::OrderPipeline(const OrderPipelineConfig& config, JournalWriter* journal,
+                             std::vector<PipelineStage*> stages)
+    : config_{ config },
+      book_{ config.ladder ? Orderbook{*config.ladder} : Orderbook{} },
+      journal_{ journal },
+      commands_(RingSize(config.commandCapacity, "command")),
+      commandMask_{ commands_.size() - 1 },
+      events_(RingSize(config.eventCapacity, "event")),
+      eventMask_{ events_.size() - 1 } {
+    for (auto* consumer : stages) {
+        if (!consumer)
+            throw std::invalid_argument("OrderPipeline stages cannot be null");
+        stages_.push_back(std::make_unique<Stage>());
+        stages_.back()->consumer = consumer;
+    }
+
+    // A replay of the journal must stamp Day orders with the same closes
+    if (journal_ && journal_->Session() != config.session)
+        throw std::invalid_argument("OrderPipeline session schedule differs from the journal's");
+    if (config.session)
+        book_.SetSessionSchedule(*config.session);
+
+    if (config.reserveOrders != 0)
+        book_.Reserve(config.reserveOrders);
+    writer_ = std::make_unique<EventWriter>(*this);
+}
+
+OrderPipeline::~OrderPipeline() {
+    Join();
+}
+
+void OrderPipeline::Start() {
+    if (running_.exchange(true))
+        return;
+
+    time_ = std::max(time_, book_.GetTime());
+    upstreamDone_.store(false, std::memory_order_relaxed);
+
+    matcher_ = std::thread([this] { RunMatcher(); });
+    if (journal_)
+        journalThread_ = std::thread([this] { RunJournal(); });
+    for (auto& stage : stages_)
+        stage->thread = std::thread([this, &stage = *stage] { RunStage(stage); });
+}
+
+void OrderPipeline::Stop() {
+    Join();
+    ThrowIfHalted();
+}
+
+void OrderPipeline::Join() noexcept {
+    if (!running_.exchange(false))
+        return;
+
+    // Stages stop once nothing more can reach them
+    if (matcher_.joinable())
+        matcher_.join();
+    if (journalThread_.joinable())
+        journalThread_.join();
+    upstreamDone_.store(true, std::memory_order_release);
+
+    for (auto& stage : stages_)
+        if (stage->thread.joinable())
+            stage->thread.join();
+}
+
+std::uint64_t OrderPipeline::Submit(const OrderCommand& command) {
+    ThrowIfHalted();
+
+    if (command.type == CommandType::Add)
+        command.ToOrder().Validate();
+    else if (command.type == CommandType::AdvanceTime && command.time < time_)
+        throw std::invalid_argument("Orderbook time cannot move backwards");
+
+    if (submitted_ - commandGate_ == commands_.size()) {
+        while (submitted_ - (commandGate_ = CommandGate()) == commands_.size()) {
+            ThrowIfHalted();
+            std::this_thread::yield();
+        }
+    }
+
+    commands_[submitted_ & commandMask_] = command;
+    published_.value.store(++submitted_, std::memory_order_release);
+
+    if (command.type == CommandType::AdvanceTime)
+        time_ = command.time;
+    return submitted_;
+}
+
+void OrderPipeline::WaitIdle() const {
+    auto WaitFor = [this](const Cursor& cursor, std::uint64_t target) {
+        while (cursor.value.load(std::memory_order_acquire) < target) {
+            ThrowIfHalted();
+            std::this_thread::yield();
+        }
+    };
+
+    WaitFor(matched_, submitted_);
+    if (journal_)
+        WaitFor(journaled_, submitted_);
+
+    // Every event is written once the matcher has caught up
+    auto events = eventsPublished_.value.load(std::memory_order_acquire);
+    for (const auto& stage : stages_)
+        WaitFor(stage->consumed, events);
+}
+
+std::uint64_t OrderPipeline::CommandGate() const noexcept {
+    auto gate = matched_.value.load(std::memory_order_acquire);
+    if (journal_)
+        gate = std::min(gate, journaled_.value.load(std::memory_order_acquire));
+    return gate;
+}
+
+std::uint64_t OrderPipeline::EventGate() const noexcept {
+    auto gate = std::numeric_limits<std::uint64_t>::max();
+    for (const auto& stage : stages_)
+        gate = std::min(gate, stage->consumed.value.load(std::memory_order_acquire));
+    return gate;
+}
+
+void OrderPipeline::RunMatcher() {
+#ifdef __linux__
+    if (config_.pinMatcher) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(config_.matcherCore, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+
+    auto next = matched_.value.load(std::memory_order_relaxed);
+    for (;;) {
+        if (halted_.load(std::memory_order_acquire))
+            return;
+
+        auto available = published_.value.load(std::memory_order_acquire);
+        if (next == available) {
+            // Drain everything sequenced before Stop was requested
+            if (!running_.load(std::memory_order_acquire) &&
+                published_.value.load(std::memory_order_acquire) == next)
+                return;
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (; next != available; ++next) {
+            const auto& command = commands_[next & commandMask_];
+            writer_->Begin(next + 1);
+
+            try {
+                book_.ProcessBatch({ &command, 1 }, *writer_);
+            } catch (const std::exception&) {
+                writer_->RejectInvalid(command);
+                failed_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            writer_->Publish();
+            matched_.value.store(next + 1, std::memory_order_release);
+        }
+    }
+}
+
+void OrderPipeline::RunJournal() {
+    auto next = journaled_.value.load(std::memory_order_relaxed);
+    try {
+        for (;;) {
+            if (halted_.load(std::memory_order_acquire))
+                return;
+
+            auto available = published_.value.load(std::memory_order_acquire);
+            if (next == available) {
+                if (!running_.load(std::memory_order_acquire) &&
+                    published_.value.load(std::memory_order_acquire) == next)
+                    return;
+                std::this_thread::yield();
+                continue;
+            }
+
+            // A run that wraps around the ring goes in as two spans
+            while (next != available) {
+                auto begin = next & commandMask_;
+                auto count = std::min<std::uint64_t>(available - next, commands_.size() - begin);
+                journal_->Append(std::span<const OrderCommand>{ commands_.data() + begin, count });
+                next += count;
+            }
+
+            journal_->Commit();
+            journaled_.value.store(next, std::memory_order_release);
+        }
+    } catch (...) {
+        Halt(std::current_exception());
+    }
+}
+
+void OrderPipeline::RunStage(Stage& stage) {
+    auto next = stage.consumed.value.load(std::memory_order_relaxed);
+    try {
+        for (;;) {
+            if (halted_.load(std::memory_order_acquire))
+                return;
+
+            // Read the journal's cursor first: a stale one only holds events back
+            auto committed = journal_ ? journaled_.value.load(std::memory_order_acquire)
+                                      : std::numeric_limits<std::uint64_t>::max();
+            auto available = eventsPublished_.value.load(std::memory_order_acquire);
+
+            auto end = next;
+            for (; end != available; ++end) {
+                const auto& event = events_[end & eventMask_];
+                if (event.command > committed)
+                    break;
+                stage.consumer->OnEvent(event);
+            }
+
+            if (end == next) {
+                if (upstreamDone_.load(std::memory_order_acquire) &&
+                    eventsPublished_.value.load(std::memory_order_acquire) == next)
+                    return;
+                std::this_thread::yield();
+                continue;
+            }
+
+            stage.consumer->OnBatchEnd();
+            next = end;
+            stage.consumed.value.store(next, std::memory_order_release);
+        }
+    } catch (...) {
+        Halt(std::current_exception());
+    }
+}
+
+void OrderPipeline::Halt(std::exception_ptr error) noexcept {
+    {
+        std::lock_guard lock{ errorMutex_ };
+        if (!error_)
+            error_ = std::move(error);
+    }
+    halted_.store(true, std::memory_order_release);
+}
+
+void OrderPipeline::ThrowIfHalted() const {
+    if (!halted_.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard lock{ errorMutex_ };
+    std::rethrow_exception(error_);
+}
@@ -0,0 +1,96 @@
+#include "OrderPool.h"
+#include <utility>
+
+void OrderQueue::PushBack(OrderNode* node) noexcept {
+    node->prev = tail_;
+    node->next = nullptr;
+
+    if (tail_)
+        tail_->next = node;
+    else
+        head_ = node;
+
+    tail_ = node;
+}
+
+void OrderQueue::Remove(OrderNode* node) noexcept {
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        head_ = node->next;
+
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        tail_ = node->prev;
+
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+// The source keeps no free list: its nodes now belong to this pool
+OrderPool::OrderPool(OrderPool&& other) noexcept
+    : chunks_{ std::exchange(other.chunks_, {}) }, freeList_{ std::exchange(other.freeList_, nullptr) } { }
+
+OrderPool& OrderPool::operator=(OrderPool&& other) noexcept {
+    if (this != &other) {
+        chunks_ = std::exchange(other.chunks_, {});
+        freeList_ = std::exchange(other.freeList_, nullptr);
+    }
+    return *this;
+}
+
+void OrderPool::Reserve(std::size_t count) {
+    chunks_.reserve((count + ChunkSize - 1) / ChunkSize);
+    while (chunks_.size() * ChunkSize < count)
+        AddChunk();
+}
+
+OrderNode* OrderPool::Allocate() {
+    if (!freeList_)
+        AddChunk();
+
+    auto* node = freeList_;
+    freeList_ = node->next;
+    node->next = nullptr;
+    return node;
+}
+
+void OrderPool::Release(OrderNode* node) noexcept {
+    node->order = nullptr;
+    node->owner.reset();
+    node->storage.reset();
+    node->prev = nullptr;
+    node->level = nullptr;
+    ++node->generation;
+
+    node->next = freeList_;
+    freeList_ = node;
+}
+
+OrderNode* OrderPool::Get(OrderHandle handle) const noexcept {
+    if (!handle.IsValid())
+        return nullptr;
+
+    auto chunk = handle.index / ChunkSize;
+    if (chunk >= chunks_.size())
+        return nullptr;
+
+    auto* node = &chunks_[chunk][handle.index % ChunkSize];
+    if (node->generation != handle.generation || !node->order)
+        return nullptr;
+
+    return node;
+}
+
+void OrderPool::AddChunk() {
+    auto base = static_cast<std::uint32_t>(chunks_.size() * ChunkSize);
+    auto& chunk = chunks_.emplace_back(std::make_unique<OrderNode[]>(ChunkSize));
+
+    // Thread the new nodes onto the free list in index order
+    for (std::size_t i = ChunkSize; i-- > 0;) {
+        chunk[i].index = base + static_cast<std::uint32_t>(i);
+        chunk[i].next = freeList_;
+        freeList_ = &chunk[i];
+    }
+}
@@ -1,5 +1,52 @@
 #include "OrderbookLevelInfos.h"
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <stdexcept>
 
 
 OrderbookLevelInfos::OrderbookLevelInfos(const LevelInfos& bids, const LevelInfos& asks)
-    : bids_{ bids }, asks_ { asks } { }
\ No newline at end of file
+    : bids_{ bids }, asks_ { asks } { }
+
+namespace {
+    // Levels are kept best first: descending prices for bids, ascending for asks
+    template <typename Compare>
+    void ApplyTo(LevelInfos& levels, const LevelUpdate& update, Compare compare) {
+        auto it = std::lower_bound(levels.begin(), levels.end(), update.price,
+            [&](const LevelInfo& level, Price price) { return compare(level.price_, price); });
+        bool exists = it != levels.end() && it->price_ == update.price;
+
+        if (update.quantity == 0) {
+            if (exists)
+                levels.erase(it);
+        } else if (exists) {
+            it->quantity_ = update.quantity;
+            it->orderCount_ = update.orderCount;
+        } else {
+            levels.insert(it, LevelInfo{ update.price, update.quantity, update.orderCount });
+        }
+    }
+}
+
+void OrderbookLevelInfos::Apply(const LevelUpdate& update) {
+    if (update.side == Side::Buy)
+        ApplyTo(bids_, update, std::greater<Price>{});
+    else
+        ApplyTo(asks_, update, std::less<Price>{});
+}
+
+OrderbookLevelInfos ApplyLevelUpdates(OrderbookLevelInfos snapshot, std::uint64_t snapshotSequence,
+                                      std::span<const LevelUpdate> updates) {
+    auto expected = snapshotSequence + 1;
+    for (const auto& update : updates) {
+        if (update.sequence < expected)
+            continue;
+        if (update.sequence != expected)
+            throw std::runtime_error(std::format("Level update gap: expected sequence {}, got {}",
+                                                 expected, update.sequence));
+        ++expected;
+        snapshot.Apply(update);
+    }
+
+    return snapshot;
+}
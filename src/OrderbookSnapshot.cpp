@@ -0,0 +1,90 @@
+#include "SnapshotFormat.h"
+#include "WireFormat.h"
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <stdexcept>
+
+std::size_t snapshot_format::HeaderSizeOf(std::uint32_t version) noexcept {
+    return version < 5 ? 64 : HeaderSize;
+}
+
+std::size_t snapshot_format::RecordSizeOf(std::uint32_t version) noexcept {
+    return version < 3 ? 32 : version < 4 ? 40 : RecordSize;
+}
+
+std::uint64_t snapshot_format::PayloadChecksum(std::span<const std::byte> payload) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t offset = 0; offset < payload.size(); offset += 8) {
+        hash ^= LoadLE<std::uint64_t>(payload.data() + offset);
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+void snapshot_format::EncodeOrder(std::byte* out, const Order& order) {
+    out[0] = static_cast<std::byte>(order.GetOrderType());
+    out[1] = static_cast<std::byte>(order.GetSide());
+    out[2] = static_cast<std::byte>(order.IsStopOrder());
+    StoreLE(out + 4, order.GetOwner());
+    StoreLE(out + 8, order.GetOrderID());
+    StoreLE(out + 16, order.GetPrice());
+    StoreLE(out + 20, order.GetStopPrice().value_or(0));
+    StoreLE(out + 24, order.GetInitialQuantity());
+    StoreLE(out + 28, order.GetRemainingQuantity());
+    StoreLE(out + 32, order.GetPeakQuantity());
+    StoreLE(out + 36, order.GetVisibleQuantity());
+    StoreLE(out + 40, order.GetExpiry());
+}
+
+void snapshot_format::CheckOrder(const std::byte* in, std::size_t recordSize, bool stop, Timestamp time, std::size_t record) {
+    auto orderType = std::to_integer<std::uint8_t>(in[0]);
+    auto side = std::to_integer<std::uint8_t>(in[1]);
+    auto hasStop = std::to_integer<std::uint8_t>(in[2]);
+    auto price = LoadLE<Price>(in + 16);
+    auto initial = LoadLE<Quantity>(in + 24);
+    auto remaining = LoadLE<Quantity>(in + 28);
+    auto peak = recordSize >= 40 ? LoadLE<Quantity>(in + 32) : 0;
+    auto visible = recordSize >= 40 ? LoadLE<Quantity>(in + 36) : remaining;
+    auto expiry = recordSize >= 48 ? LoadLE<Timestamp>(in + 40) : 0;
+
+    // Only the types that can rest are in the book; icebergs among them show between 1 and their peak
+    bool canExpire = orderType == static_cast<std::uint8_t>(OrderType::GoodTillDate) ||
+                     orderType == static_cast<std::uint8_t>(OrderType::Day);
+    bool canRest = orderType == static_cast<std::uint8_t>(OrderType::GoodTillCancel) ||
+                   orderType == static_cast<std::uint8_t>(OrderType::PostOnly) || canExpire;
+    bool canBeIceberg = !stop && canRest;
+    bool visibleValid = peak == 0 ? visible == remaining
+                                  : canBeIceberg && visible != 0 && visible <= std::min(peak, remaining);
+    // Expiring orders still in the book expire after its time
+    bool expiryValid = canExpire ? expiry > time : expiry == 0;
+
+    if (orderType > static_cast<std::uint8_t>(OrderType::Day) ||
+        side > static_cast<std::uint8_t>(Side::Sell) ||
+        hasStop != static_cast<std::uint8_t>(stop) ||
+        (!stop && !canRest) || price < 0 ||
+        remaining == 0 || remaining > initial || !visibleValid || !expiryValid)
+        throw std::runtime_error(std::format("Malformed snapshot record ({})", record));
+}
+
+Order snapshot_format::DecodeOrder(const std::byte* in, std::size_t recordSize) {
+    std::optional<Price> stopPrice;
+    if (in[2] != std::byte{ 0 })
+        stopPrice = LoadLE<Price>(in + 20);
+
+    Order order{
+        static_cast<OrderType>(in[0]),
+        LoadLE<OrderID>(in + 8),
+        static_cast<Side>(in[1]),
+        LoadLE<Price>(in + 16),
+        LoadLE<Quantity>(in + 24),
+        stopPrice,
+        LoadLE<OwnerID>(in + 4),
+        recordSize >= 40 ? LoadLE<Quantity>(in + 32) : 0,
+        recordSize >= 48 ? LoadLE<Timestamp>(in + 40) : 0
+    };
+    order.Fill(order.GetInitialQuantity() - LoadLE<Quantity>(in + 28));
+    if (order.IsIceberg())
+        order.SetVisibleQuantity(LoadLE<Quantity>(in + 36));
+    return order;
+}
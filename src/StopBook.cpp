@@ -0,0 +1,62 @@
+#include "StopBook.h"
+
+void StopBook::Add(OrderNode* node) {
+    const auto& order = *node->order;
+    auto stopPrice = order.GetStopPrice().value();
+
+    if (order.GetSide() == Side::Buy)
+        buyStops_[stopPrice].PushBack(node);
+    else
+        sellStops_[stopPrice].PushBack(node);
+
+    index_.insert(order.GetOrderID(), node);
+}
+
+OrderNode* StopBook::Extract(OrderID orderID) {
+    auto* node = index_.extract(orderID);
+    if (!node)
+        return nullptr;
+
+    const auto& order = *node->order;
+    auto stopPrice = order.GetStopPrice().value();
+
+    auto RemoveFrom = [&](auto& levels) {
+        auto it = levels.find(stopPrice);
+        it->second.Remove(node);
+        if (it->second.empty())
+            levels.erase(it);
+    };
+
+    if (order.GetSide() == Side::Buy)
+        RemoveFrom(buyStops_);
+    else
+        RemoveFrom(sellStops_);
+
+    return node;
+}
+
+bool StopBook::CouldTrigger(Price tradePrice) const noexcept {
+    return (!buyStops_.empty() && tradePrice >= buyStops_.begin()->first) ||
+           (!sellStops_.empty() && tradePrice <= sellStops_.begin()->first);
+}
+
+void StopBook::TakeTriggered(Price tradePrice, std::vector<OrderNode*>& triggered) {
+    while (!buyStops_.empty() && tradePrice >= buyStops_.begin()->first)
+        TakeLevel(buyStops_, index_, triggered);
+
+    while (!sellStops_.empty() && tradePrice <= sellStops_.begin()->first)
+        TakeLevel(sellStops_, index_, triggered);
+}
+
+template <typename Levels>
+void StopBook::TakeLevel(Levels& levels, OrderIndex& index, std::vector<OrderNode*>& triggered) {
+    auto& queue = levels.begin()->second;
+
+    while (auto* node = queue.Front()) {
+        queue.Remove(node);
+        index.erase(node->order->GetOrderID());
+        triggered.push_back(node);
+    }
+
+    levels.erase(levels.begin());
+}
@@ -1,4 +1,30 @@
 #include "Trade.h"
 
 Trade::Trade(const TradeInfo& bidTrade, const TradeInfo& askTrade)
-    : bidTrade_ { bidTrade }, askTrade_ { askTrade } { };
\ No newline at end of file
+    : bidTrade_ { bidTrade }, askTrade_ { askTrade } { };
+
+namespace {
+    void Mix(std::uint64_t& hash, std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash ^= (value >> (8 * i)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+
+    void Mix(std::uint64_t& hash, const TradeInfo& info) {
+        Mix(hash, info.orderID);
+        Mix(hash, static_cast<std::uint32_t>(info.price));
+        Mix(hash, info.quantity);
+    }
+}
+
+void TradeChecksum::Add(const Trade& trade) {
+    Mix(value_, trade.GetBidTrade());
+    Mix(value_, trade.GetAskTrade());
+    ++count_;
+}
+
+void TradeChecksum::Add(const Trades& trades) {
+    for (const auto& trade : trades)
+        Add(trade);
+}
@@ -1,6 +1,100 @@
 #include <gtest/gtest.h>
 #include "Orderbook.h"
+#include "OrderbookImpl.h"
+#include "MatchingEngine.h"
+#include "OrderPipeline.h"
+#include "Journal.h"
+#include "DepthPublisher.h"
+#include "MarketByOrderFeed.h"
+#include "OrderEntry.h"
+#include "OrderFlowFile.h"
+#include "LatencyHistogram.h"
+#include "Instrumentation.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Random mix of adds, cancels and modifies around a mid price of 100
+static std::vector<OrderCommand> MakeRandomCommands(std::uint64_t seed, std::size_t count) {
+    std::mt19937_64 rng{seed};
+    std::vector<OrderCommand> commands;
+    commands.reserve(count);
+
+    OrderID nextID = 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        auto roll = rng() % 10;
+        auto side = (rng() % 2) ? Side::Buy : Side::Sell;
+        Price price = 90 + Price(rng() % 21);
+        Quantity quantity = 1 + Quantity(rng() % 20);
+
+        if (roll < 6 || nextID == 1) {
+            static constexpr OrderType types[] = {
+                OrderType::GoodTillCancel, OrderType::GoodTillCancel, OrderType::GoodTillCancel,
+                OrderType::FillAndKill, OrderType::FillOrKill, OrderType::PostOnly, OrderType::Market,
+                OrderType::GoodTillDate
+            };
+            auto type = types[rng() % std::size(types)];
+            std::optional<Price> stop;
+            Quantity peak = 0;
+            if (rng() % 20 == 0)
+                stop = 90 + Price(rng() % 21);
+            else if ((type == OrderType::GoodTillCancel || type == OrderType::PostOnly ||
+                      type == OrderType::GoodTillDate) && rng() % 8 == 0)
+                peak = 1 + Quantity(rng() % 5);
+            // Time never advances here, so GoodTillDate orders behave as GoodTillCancel ones
+            Timestamp expiry = type == OrderType::GoodTillDate ? 1 + rng() % 1000 : 0;
+            commands.push_back(OrderCommand::Add(type, nextID++, side, price, quantity, stop, NoOwner, peak, expiry));
+        } else if (roll < 9) {
+            commands.push_back(OrderCommand::Cancel(1 + rng() % (nextID - 1)));
+        } else {
+            commands.push_back(OrderCommand::Modify(OrderModify{1 + rng() % (nextID - 1), side, price, quantity}));
+        }
+    }
+
+    return commands;
+}
+
+// Applies commands one at a time through the classic API
+static Trades ApplyOneByOne(Orderbook& book, const std::vector<OrderCommand>& commands) {
+    Trades trades;
+    for (const auto& command : commands) {
+        Trades result;
+        switch (command.type) {
+        case CommandType::Add:
+            result = book.AddOrder(std::make_shared<Order>(command.ToOrder()));
+            break;
+        case CommandType::Cancel:
+            book.CancelOrder(command.orderID);
+            break;
+        case CommandType::Modify:
+            result = book.ModifyOrder(command.ToModify());
+            break;
+        case CommandType::AdvanceTime:
+            book.AdvanceTime(command.time);
+            break;
+        case CommandType::StartAuction:
+            if (!book.InAuction())
+                book.StartAuction(command.price);
+            break;
+        case CommandType::Uncross:
+            if (book.InAuction())
+                book.Uncross(result);
+            break;
+        }
+        trades.insert(trades.end(), result.begin(), result.end());
+    }
+    return trades;
+}
 
 // ===============================
 //          Basic tests
@@ -407,6 +501,3115 @@ TEST(OrderbookTest, TradeAtMakerPrice) {
     EXPECT_EQ(trades[0].GetAskTrade().price, 100);
 }
 
+// ===============================
+//       Price Ladder Tests
+// ===============================
+
+TEST(OrderbookTest, LadderWalkTheBook) {
+    Orderbook book{LadderConfig{90, 1, 32}};
+
+    auto ask1 = std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10);
+    auto ask2 = std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 101, 20);
+    auto ask3 = std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Sell, 102, 30);
+
+    book.AddOrder(ask3);
+    book.AddOrder(ask1);
+    book.AddOrder(ask2);
+
+    auto bid = std::make_shared<Order>(OrderType::GoodTillCancel, 4, Side::Buy, 105, 50);
+    auto trades = book.AddOrder(bid);
+
+    ASSERT_EQ(trades.size(), 3);
+
+    EXPECT_EQ(trades[0].GetAskTrade().price, 100);
+    EXPECT_EQ(trades[1].GetAskTrade().price, 101);
+    EXPECT_EQ(trades[2].GetAskTrade().price, 102);
+    EXPECT_EQ(trades[2].GetAskTrade().quantity, 20);
+
+    EXPECT_EQ(book.Size(), 1);
+}
+
+TEST(OrderbookTest, MovedFromLadderBookIsEmptyAndReusable) {
+    Orderbook book{LadderConfig{90, 1, 32}};
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 95, 10}, trades);
+
+    Orderbook moved{std::move(book)};
+    EXPECT_EQ(moved.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 10, 1 } }));
+    EXPECT_TRUE(book.GetOrderInfos().GetAsks().empty());
+    EXPECT_TRUE(book.GetOrderInfos().GetBids().empty());
+
+    // The moved-from book keeps working, on the map alone
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 100, 5}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 101, 3}, trades);
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 2, 1 } }));
+    EXPECT_EQ(moved.GetOrderInfos().GetBids(), (LevelInfos{ { 95, 10, 1 } }));
+}
+
+TEST(OrderbookTest, LadderFallsBackOutsideBand) {
+    Orderbook book{LadderConfig{100, 5, 4}}; // 100, 105, 110, 115
+
+    // 95 is below the band, 103 is off-tick, 200 is above the band
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 95, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 105, 2));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 103, 3));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 4, Side::Sell, 200, 4));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 5, Side::Sell, 115, 5));
+
+    auto infos = book.GetOrderInfos();
+    const auto& bids = infos.GetBids();
+    const auto& asks = infos.GetAsks();
+
+    ASSERT_EQ(bids.size(), 3);
+    EXPECT_EQ(bids[0].price_, 105);
+    EXPECT_EQ(bids[1].price_, 103);
+    EXPECT_EQ(bids[2].price_, 95);
+
+    ASSERT_EQ(asks.size(), 2);
+    EXPECT_EQ(asks[0].price_, 115);
+    EXPECT_EQ(asks[1].price_, 200);
+
+    // Market sell walks ladder and fallback levels in price order
+    auto marketSell = std::make_shared<Order>(OrderType::Market, 6, Side::Sell, 0, 6);
+    auto trades = book.AddOrder(marketSell);
+
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].GetBidTrade().orderID, 2);
+    EXPECT_EQ(trades[1].GetBidTrade().orderID, 3);
+    EXPECT_EQ(trades[2].GetBidTrade().orderID, 1);
+    EXPECT_EQ(book.Size(), 2);
+}
+
+TEST(OrderbookTest, LadderCancelUpdatesBestPrice) {
+    Orderbook book{LadderConfig{0, 1, 1024}};
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 900, 10));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 100, 10));
+    book.CancelOrder(2);
+
+    // Best ask moved from 100 to 900, so a bid at 500 must rest
+    auto bid = std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 500, 10);
+    auto trades = book.AddOrder(bid);
+
+    EXPECT_EQ(trades.size(), 0);
+    EXPECT_EQ(book.Size(), 2);
+
+    auto infos = book.GetOrderInfos();
+    ASSERT_EQ(infos.GetAsks().size(), 1);
+    EXPECT_EQ(infos.GetAsks()[0].price_, 900);
+}
+
+TEST(OrderbookTest, InvalidLadderThrows) {
+    EXPECT_THROW(Orderbook(LadderConfig{100, 0, 10}), std::invalid_argument);
+    EXPECT_THROW(Orderbook(LadderConfig{100, 1, 0}), std::invalid_argument);
+    EXPECT_THROW(Orderbook(LadderConfig{-1, 1, 10}), std::invalid_argument);
+    EXPECT_NO_THROW(Orderbook(LadderConfig{0, 1, 10}));
+}
+
+// ===============================
+//     Pooled Order API Tests
+// ===============================
+
+TEST(OrderbookTest, PooledAddReturnsHandle) {
+    Orderbook book;
+    Trades trades;
+
+    auto handle = book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}, trades);
+
+    ASSERT_TRUE(handle.IsValid());
+    EXPECT_TRUE(trades.empty());
+    EXPECT_EQ(book.Size(), 1);
+
+    const auto* order = book.GetOrder(handle);
+    ASSERT_NE(order, nullptr);
+    EXPECT_EQ(order->GetOrderID(), 1);
+    EXPECT_EQ(order->GetRemainingQuantity(), 10);
+}
+
+TEST(OrderbookTest, PooledAndSharedOrdersShareFIFO) {
+    Orderbook book;
+    Trades trades;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10));
+    auto pooled = book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 100, 10}, trades);
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Sell, 100, 10));
+
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 100, 15}, trades);
+
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].GetAskTrade().orderID, 1);
+    EXPECT_EQ(trades[1].GetAskTrade().orderID, 2);
+    EXPECT_EQ(trades[1].GetAskTrade().quantity, 5);
+
+    // Resting pooled order reflects the partial fill
+    ASSERT_NE(book.GetOrder(pooled), nullptr);
+    EXPECT_EQ(book.GetOrder(pooled)->GetRemainingQuantity(), 5);
+    EXPECT_EQ(book.Size(), 2);
+}
+
+TEST(OrderbookTest, CancelByHandleInvalidatesHandle) {
+    Orderbook book;
+    Trades trades;
+
+    auto handle = book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}, trades);
+    book.CancelOrder(handle);
+
+    EXPECT_EQ(book.Size(), 0);
+    EXPECT_EQ(book.GetOrder(handle), nullptr);
+
+    // Node is reused for the next order, old handle must stay stale
+    auto reused = book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 10}, trades);
+    EXPECT_EQ(reused.index, handle.index);
+    EXPECT_EQ(book.GetOrder(handle), nullptr);
+
+    book.CancelOrder(handle);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+TEST(OrderbookTest, PooledFilledOrderHasNoHandle) {
+    Orderbook book;
+    Trades trades;
+
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 10}, trades);
+    auto handle = book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 10}, trades);
+
+    EXPECT_FALSE(handle.IsValid());
+    EXPECT_EQ(trades.size(), 1);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+// ===============================
+//       Order Index Tests
+// ===============================
+
+TEST(OrderIndexTest, InsertFindExtract) {
+    OrderIndex index;
+    OrderNode a, b;
+
+    EXPECT_TRUE(index.insert(1, &a));
+    EXPECT_TRUE(index.insert(2, &b));
+    EXPECT_FALSE(index.insert(1, &b)); // duplicate
+
+    EXPECT_EQ(index.size(), 2);
+    EXPECT_EQ(index.find(1), &a);
+    EXPECT_EQ(index.find(2), &b);
+    EXPECT_EQ(index.find(3), nullptr);
+
+    EXPECT_EQ(index.extract(1), &a);
+    EXPECT_EQ(index.extract(1), nullptr);
+    EXPECT_EQ(index.size(), 1);
+    EXPECT_EQ(index.find(2), &b);
+}
+
+TEST(OrderIndexTest, MatchesUnorderedMapUnderChurn) {
+    OrderIndex index{16};
+    std::unordered_map<OrderID, OrderNode*> reference;
+    std::vector<OrderNode> nodes(64);
+
+    std::mt19937_64 rng{42};
+    for (int i = 0; i < 100000; ++i) {
+        OrderID id = rng() % 5000;
+        auto* node = &nodes[id % nodes.size()];
+
+        if (rng() % 3 == 0) {
+            auto it = reference.find(id);
+            auto* expected = it == reference.end() ? nullptr : it->second;
+            ASSERT_EQ(index.extract(id), expected);
+            reference.erase(id);
+        } else {
+            ASSERT_EQ(index.insert(id, node), reference.insert({id, node}).second);
+        }
+    }
+
+    ASSERT_EQ(index.size(), reference.size());
+    for (OrderID id = 0; id < 5000; ++id) {
+        auto it = reference.find(id);
+        ASSERT_EQ(index.find(id), it == reference.end() ? nullptr : it->second);
+    }
+}
+
+TEST(OrderIndexTest, MovedFromIndexIsEmptyAndReusable) {
+    OrderIndex index;
+    OrderNode a, b;
+    index.insert(1, &a);
+
+    OrderIndex moved{std::move(index)};
+    EXPECT_EQ(moved.find(1), &a);
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(index.find(1), nullptr);
+    EXPECT_EQ(index.extract(1), nullptr);
+
+    EXPECT_TRUE(index.insert(2, &b));
+    EXPECT_EQ(index.find(2), &b);
+    moved = std::move(index);
+    EXPECT_EQ(moved.find(2), &b);
+    EXPECT_EQ(moved.find(1), nullptr);
+    EXPECT_TRUE(index.empty());
+}
+
+TEST(OrderbookTest, MovedFromBookIsEmptyAndReusable) {
+    Orderbook book;
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 101, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 99, 10}, trades);
+
+    Orderbook moved{std::move(book)};
+    EXPECT_EQ(moved.Size(), 2);
+    EXPECT_EQ(book.Size(), 0);
+    EXPECT_EQ(book.GetOrder(1), nullptr);
+
+    // The moved-from book takes new orders from its own, empty pool
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 100, 5}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 100, 3}, trades);
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(book.Size(), 1);
+    EXPECT_EQ(book.GetOrder(3)->GetRemainingQuantity(), 2);
+    book.CancelOrder(3);
+    EXPECT_EQ(book.Size(), 0);
+
+    // And the book it moved into is untouched by any of that
+    EXPECT_EQ(moved.Size(), 2);
+    moved.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Buy, 101, 10}, trades);
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades.back().GetAskTrade().orderID, 1);
+    EXPECT_EQ(moved.Size(), 1);
+
+    // Move-assigning into the reused book frees its orders and takes the other's
+    book.AddOrder(Order{OrderType::GoodTillCancel, 6, Side::Sell, 105, 1}, trades);
+    book = std::move(moved);
+    EXPECT_EQ(book.Size(), 1);
+    EXPECT_NE(book.GetOrder(2), nullptr);
+    EXPECT_EQ(book.GetOrder(6), nullptr);
+    EXPECT_EQ(moved.Size(), 0);
+    moved.AddOrder(Order{OrderType::GoodTillCancel, 7, Side::Buy, 99, 1}, trades);
+    EXPECT_EQ(moved.Size(), 1);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+// ===============================
+//      Level Aggregate Tests
+// ===============================
+
+TEST(OrderbookTest, LevelQuantityTracksFillsAndCancels) {
+    Orderbook book;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 100, 20));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Sell, 101, 30));
+
+    // Partially fill order 1
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 4, Side::Buy, 100, 4));
+
+    auto infos = book.GetOrderInfos();
+    ASSERT_EQ(infos.GetAsks().size(), 2);
+    EXPECT_EQ(infos.GetAsks()[0].quantity_, 26);
+    EXPECT_EQ(infos.GetAsks()[1].quantity_, 30);
+
+    book.CancelOrder(2);
+
+    infos = book.GetOrderInfos();
+    ASSERT_EQ(infos.GetAsks().size(), 2);
+    EXPECT_EQ(infos.GetAsks()[0].quantity_, 6);
+
+    book.CancelOrder(1);
+
+    infos = book.GetOrderInfos();
+    ASSERT_EQ(infos.GetAsks().size(), 1);
+    EXPECT_EQ(infos.GetAsks()[0].price_, 101);
+}
+
+TEST(OrderbookTest, GetTopLevelsLimitsDepth) {
+    Orderbook book;
+
+    for (OrderID id = 1; id <= 5; ++id) {
+        book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, id, Side::Buy, 100 - Price(id), 10));
+        book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, id + 10, Side::Sell, 100 + Price(id), 10));
+    }
+
+    auto top = book.GetTopLevels(2);
+
+    ASSERT_EQ(top.GetBids().size(), 2);
+    EXPECT_EQ(top.GetBids()[0].price_, 99);
+    EXPECT_EQ(top.GetBids()[1].price_, 98);
+
+    ASSERT_EQ(top.GetAsks().size(), 2);
+    EXPECT_EQ(top.GetAsks()[0].price_, 101);
+    EXPECT_EQ(top.GetAsks()[1].price_, 102);
+
+    EXPECT_EQ(book.GetTopLevels(10).GetBids().size(), 5);
+}
+
+TEST(OrderbookTest, FillOrKillUsesLevelTotals) {
+    Orderbook book;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 30));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 100, 30));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 99, 30));
+
+    auto tooLarge = std::make_shared<Order>(OrderType::FillOrKill, 4, Side::Sell, 100, 61);
+    EXPECT_TRUE(book.AddOrder(tooLarge).empty());
+
+    auto exact = std::make_shared<Order>(OrderType::FillOrKill, 5, Side::Sell, 100, 60);
+    EXPECT_EQ(book.AddOrder(exact).size(), 2);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+// ===============================
+//        Stop Book Tests
+// ===============================
+
+TEST(OrderbookTest, StopTriggersOnlyCrossedPrefix) {
+    Orderbook book;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 10));
+
+    // Sell stops at 101, 100 and 99; a trade at 100 triggers the first two only
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 50, 1, 99));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Sell, 50, 1, 101));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 4, Side::Sell, 50, 1, 100));
+
+    auto trades = book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 5, Side::Sell, 100, 1));
+
+    // Aggressor, then the 101 stop, then the 100 stop
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[1].GetAskTrade().orderID, 3);
+    EXPECT_EQ(trades[2].GetAskTrade().orderID, 4);
+    EXPECT_EQ(book.PendingStopCount(), 1);
+}
+
+TEST(OrderbookTest, StopCascadeTriggersFurtherStops) {
+    Orderbook book;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 98, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 96, 1));
+
+    // Stop at 100 trades at 98, which triggers the stop at 98, which trades at 96
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 10, Side::Sell, 0, 1, 100));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 11, Side::Sell, 0, 1, 98));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 12, Side::Sell, 0, 1, 90));
+
+    auto trades = book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 20, Side::Sell, 100, 1));
+
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[0].GetBidTrade().price, 100);
+    EXPECT_EQ(trades[1].GetBidTrade().price, 98);
+    EXPECT_EQ(trades[1].GetAskTrade().orderID, 10);
+    EXPECT_EQ(trades[2].GetBidTrade().price, 96);
+    EXPECT_EQ(trades[2].GetAskTrade().orderID, 11);
+
+    EXPECT_EQ(book.PendingStopCount(), 1);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(OrderbookTest, CancelStopAmongMany) {
+    Orderbook book;
+
+    for (OrderID id = 1; id <= 1000; ++id)
+        book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, id, Side::Buy, 200, 1, 100 + Price(id % 7)));
+
+    book.CancelOrder(500);
+    book.CancelOrder(500);
+
+    EXPECT_EQ(book.PendingStopCount(), 999);
+
+    // Duplicate ID of a pending stop is rejected
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 200, 1, 100));
+    EXPECT_EQ(book.PendingStopCount(), 999);
+}
+
+// ===============================
+//         Batch API Tests
+// ===============================
+
+TEST(OrderbookTest, BatchMatchesOneByOne) {
+    auto commands = MakeRandomCommands(7, 20000);
+
+    Orderbook sequential;
+    auto expected = ApplyOneByOne(sequential, commands);
+
+    Orderbook batched;
+    Trades trades;
+    for (std::size_t i = 0; i < commands.size(); i += 256) {
+        auto count = std::min<std::size_t>(256, commands.size() - i);
+        batched.ProcessBatch(std::span{commands}.subspan(i, count), trades);
+    }
+
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(trades, expected);
+    EXPECT_EQ(batched.Size(), sequential.Size());
+    EXPECT_EQ(batched.PendingStopCount(), sequential.PendingStopCount());
+    EXPECT_EQ(batched.GetOrderInfos().GetBids(), sequential.GetOrderInfos().GetBids());
+    EXPECT_EQ(batched.GetOrderInfos().GetAsks(), sequential.GetOrderInfos().GetAsks());
+}
+
+TEST(OrderbookTest, AddOrdersAppendsToBuffer) {
+    Orderbook book;
+    std::vector<Order> orders{
+        Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 10},
+        Order{OrderType::GoodTillCancel, 2, Side::Sell, 101, 10},
+        Order{OrderType::GoodTillCancel, 3, Side::Buy, 101, 15},
+    };
+
+    Trades trades;
+    trades.emplace_back(TradeInfo{99, 1, 1}, TradeInfo{98, 1, 1});
+
+    book.AddOrders(orders, trades);
+
+    ASSERT_EQ(trades.size(), 3);
+    EXPECT_EQ(trades[1].GetAskTrade().orderID, 1);
+    EXPECT_EQ(trades[2].GetAskTrade().orderID, 2);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+// ===============================
+//      Event Listener Tests
+// ===============================
+
+struct RecordingListener : OrderbookListener {
+    std::vector<std::string> events;
+    Trades trades;
+
+    void OnOrderAccepted(const Order& order) override {
+        events.push_back("accepted " + std::to_string(order.GetOrderID()));
+    }
+    void OnOrderRejected(const Order& order, RejectReason reason) override {
+        events.push_back("rejected " + std::to_string(order.GetOrderID()) + " " +
+                         std::to_string(static_cast<int>(reason)));
+    }
+    void OnTrade(const Trade& trade) override {
+        trades.push_back(trade);
+        events.push_back("trade " + std::to_string(trade.GetBidTrade().orderID) + "/" +
+                         std::to_string(trade.GetAskTrade().orderID));
+    }
+    void OnOrderCancelled(const Order& order) override {
+        events.push_back("cancelled " + std::to_string(order.GetOrderID()));
+    }
+    void OnOrderReduced(const Order& order) override {
+        events.push_back("reduced " + std::to_string(order.GetOrderID()));
+    }
+    void OnStopTriggered(const Order& order) override {
+        events.push_back("triggered " + std::to_string(order.GetOrderID()));
+    }
+    void OnOrderReplenished(const Order& order) override {
+        events.push_back("replenished " + std::to_string(order.GetOrderID()));
+    }
+};
+
+TEST(OrderbookTest, ListenerSeesAcceptTradeAndRemainderCancel) {
+    Orderbook book;
+    RecordingListener listener;
+
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 5}, listener);
+    book.AddOrder(Order{OrderType::FillAndKill, 2, Side::Buy, 100, 8}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Buy, 99, 5}, listener);
+    book.CancelOrder(3, listener);
+
+    std::vector<std::string> expected{
+        "accepted 1",
+        "accepted 2", "trade 2/1", "cancelled 2",
+        "accepted 3", "cancelled 3",
+    };
+    EXPECT_EQ(listener.events, expected);
+    ASSERT_EQ(listener.trades.size(), 1);
+    EXPECT_EQ(listener.trades[0].GetBidTrade().quantity, 5);
+}
+
+TEST(OrderbookTest, ListenerSeesRejections) {
+    Orderbook book;
+    RecordingListener listener;
+
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 5}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 5}, listener);
+    book.AddOrder(Order{OrderType::FillOrKill, 2, Side::Buy, 100, 6}, listener);
+    book.AddOrder(Order{OrderType::PostOnly, 3, Side::Buy, 100, 1}, listener);
+    book.AddOrder(Order{OrderType::FillAndKill, 4, Side::Buy, 99, 1}, listener);
+
+    std::vector<std::string> expected{
+        "accepted 1",
+        "rejected 1 " + std::to_string(static_cast<int>(RejectReason::DuplicateOrderID)),
+        "rejected 2 " + std::to_string(static_cast<int>(RejectReason::InsufficientLiquidity)),
+        "rejected 3 " + std::to_string(static_cast<int>(RejectReason::WouldCross)),
+        "rejected 4 " + std::to_string(static_cast<int>(RejectReason::NoLiquidity)),
+    };
+    EXPECT_EQ(listener.events, expected);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+TEST(OrderbookTest, ListenerSeesStopTrigger) {
+    Orderbook book;
+    RecordingListener listener;
+
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 95, 20, 100}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 100, 5}, listener);
+
+    std::vector<std::string> expected{
+        "accepted 1",
+        "accepted 2",
+        "accepted 3", "trade 1/3", "triggered 2", "trade 1/2", "cancelled 2",
+    };
+    EXPECT_EQ(listener.events, expected);
+}
+
+// ===============================
+//         Modify Tests
+// ===============================
+
+TEST(OrderbookTest, ModifyReduceKeepsPriority) {
+    Orderbook book;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 100, 10));
+
+    RecordingListener listener;
+    book.ModifyOrder(OrderModify{1, Side::Sell, 100, 4}, listener);
+
+    std::vector<std::string> expected{ "reduced 1" };
+    EXPECT_EQ(listener.events, expected);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks()[0].quantity_, 14);
+
+    auto trades = book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 100, 6));
+
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].GetAskTrade().orderID, 1);
+    EXPECT_EQ(trades[0].GetAskTrade().quantity, 4);
+    EXPECT_EQ(trades[1].GetAskTrade().orderID, 2);
+    EXPECT_EQ(trades[1].GetAskTrade().quantity, 2);
+}
+
+TEST(OrderbookTest, ModifyReduceUpdatesPooledOrder) {
+    Orderbook book;
+    Trades trades;
+
+    auto handle = book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 100, 3}, trades);
+
+    book.ModifyOrder(OrderModify{1, Side::Buy, 100, 5});
+
+    const auto* order = book.GetOrder(handle);
+    ASSERT_NE(order, nullptr);
+    EXPECT_EQ(order->GetRemainingQuantity(), 5);
+    EXPECT_EQ(order->GetFilledQuantity(), 3);
+    EXPECT_EQ(order->GetInitialQuantity(), 8);
+}
+
+TEST(OrderbookTest, ModifyIncreaseLosesPriority) {
+    Orderbook book;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 100, 10));
+
+    book.ModifyOrder(OrderModify{1, Side::Sell, 100, 12});
+
+    auto trades = book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 100, 5));
+
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].GetAskTrade().orderID, 2);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks()[0].quantity_, 17);
+}
+
+TEST(OrderbookTest, ModifyPriceChangeMatches) {
+    Orderbook book;
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 101, 10));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 99, 5));
+
+    auto trades = book.ModifyOrder(OrderModify{2, Side::Buy, 101, 5});
+
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].GetBidTrade().orderID, 2);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+// ===============================
+//     Matching Engine Tests
+// ===============================
+
+TEST(SpscQueueTest, PreservesOrderAcrossThreads) {
+    constexpr std::uint64_t Count = 100000;
+    SpscQueue<std::uint64_t> queue{64};
+    EXPECT_EQ(queue.capacity(), 64);
+
+    std::thread producer([&] {
+        for (std::uint64_t i = 0; i < Count; ++i)
+            while (!queue.TryPush(i))
+                std::this_thread::yield();
+    });
+
+    std::uint64_t expected = 0, value;
+    while (expected < Count) {
+        if (queue.TryPop(value))
+            ASSERT_EQ(value, expected++);
+        else
+            std::this_thread::yield();
+    }
+
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MatchingEngineTest, ShardedBooksMatchStandaloneBooks) {
+    constexpr InstrumentID Instruments = 8;
+
+    MatchingEngine engine{MatchingEngineConfig{.workerCount = 3, .queueCapacity = 16}};
+    std::vector<Trades> engineTrades(Instruments);
+    std::vector<std::unique_ptr<TradeCollector>> collectors;
+    for (InstrumentID instrument = 0; instrument < Instruments; ++instrument) {
+        collectors.push_back(std::make_unique<TradeCollector>(engineTrades[instrument]));
+        engine.AddInstrument(instrument, std::nullopt, collectors.back().get());
+    }
+
+    std::vector<std::vector<OrderCommand>> flows;
+    for (InstrumentID instrument = 0; instrument < Instruments; ++instrument)
+        flows.push_back(MakeRandomCommands(100 + instrument, 2000));
+
+    // Interleave instruments so every worker queue fills and wraps
+    engine.Start();
+    for (std::size_t i = 0; i < flows[0].size(); ++i)
+        for (InstrumentID instrument = 0; instrument < Instruments; ++instrument)
+            engine.Submit(instrument, flows[instrument][i]);
+    engine.WaitIdle();
+
+    for (InstrumentID instrument = 0; instrument < Instruments; ++instrument) {
+        Orderbook expected;
+        Trades expectedTrades;
+        expected.ProcessBatch(flows[instrument], expectedTrades);
+
+        auto& book = engine.GetBook(instrument);
+        EXPECT_EQ(engineTrades[instrument], expectedTrades);
+        EXPECT_EQ(book.Size(), expected.Size());
+        EXPECT_EQ(book.GetOrderInfos().GetBids(), expected.GetOrderInfos().GetBids());
+        EXPECT_EQ(book.GetOrderInfos().GetAsks(), expected.GetOrderInfos().GetAsks());
+    }
+
+    engine.Stop();
+}
+
+TEST(MatchingEngineTest, SpreadsInstrumentsAcrossWorkers) {
+    MatchingEngine engine{MatchingEngineConfig{.workerCount = 2}};
+    engine.AddInstrument(10);
+    engine.AddInstrument(20);
+    engine.AddInstrument(30);
+
+    EXPECT_NE(engine.WorkerFor(10), engine.WorkerFor(20));
+    EXPECT_THROW(engine.AddInstrument(10), std::invalid_argument);
+    EXPECT_THROW(engine.Submit(99, OrderCommand::Cancel(1)), std::invalid_argument);
+}
+
+TEST(MatchingEngineTest, StopDrainsQueuedCommands) {
+    MatchingEngine engine;
+    engine.AddInstrument(1);
+    engine.Start();
+
+    for (OrderID id = 1; id <= 1000; ++id)
+        engine.Submit(1, OrderCommand::Add(OrderType::GoodTillCancel, id, Side::Buy, 100, 1));
+    engine.Submit(1, OrderCommand::Add(OrderType::GoodTillCancel, 1001, Side::Buy, 100, 0));  // invalid
+    engine.Stop();
+
+    EXPECT_EQ(engine.GetBook(1).Size(), 1000);
+    EXPECT_EQ(engine.FailedCommands(), 1);
+}
+
+TEST(MatchingEngineTest, SubmitNeedsARunningEngine) {
+    MatchingEngine engine{MatchingEngineConfig{.queueCapacity = 4}};
+    engine.AddInstrument(1);
+
+    // Nothing drains the queue yet: Submit refuses rather than spin, TrySubmit queues until full
+    EXPECT_THROW(engine.Submit(1, OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Buy, 100, 1)), std::logic_error);
+    OrderID id = 1;
+    while (engine.TrySubmit(1, OrderCommand::Add(OrderType::GoodTillCancel, id, Side::Buy, 100, 1)))
+        ++id;
+    EXPECT_EQ(id, 5);
+    EXPECT_THROW(engine.WaitIdle(), std::logic_error);
+
+    engine.Start();
+    engine.WaitIdle();
+    EXPECT_EQ(engine.GetBook(1).Size(), 4);
+
+    engine.Stop();
+    EXPECT_THROW(engine.Submit(1, OrderCommand::Cancel(1)), std::logic_error);
+    EXPECT_NO_THROW(engine.WaitIdle());
+}
+
+// ===============================
+//          Journal Tests
+// ===============================
+
+// Per-test scratch file, removed when the test ends
+struct TempFile {
+    std::filesystem::path path;
+
+    explicit TempFile(const std::string& extension = ".bin")
+        : path{ std::filesystem::temp_directory_path() /
+                (std::string{::testing::UnitTest::GetInstance()->current_test_info()->name()} + extension) } {
+        std::filesystem::remove(path);
+    }
+    ~TempFile() { std::filesystem::remove(path); }
+};
+
+TEST(JournalTest, ReplayReproducesTradesAndBook) {
+    TempFile file;
+    auto commands = MakeRandomCommands(11, 5000);
+
+    Orderbook live;
+    TradeChecksum liveTrades;
+    {
+        JournalWriter writer{file.path, JournalWriterOptions{.groupCommitBytes = 4096, .sync = false}};
+        for (std::size_t i = 0; i < commands.size(); i += 250) {
+            std::span batch{commands.data() + i, std::min<std::size_t>(250, commands.size() - i)};
+            writer.Append(batch);
+            writer.Commit();
+
+            Trades trades;
+            live.ProcessBatch(batch, trades);
+            liveTrades.Add(trades);
+            writer.AppendCheckpoint(liveTrades);
+        }
+    }
+
+    Orderbook replayed;
+    auto result = ReplayJournal(file.path, replayed);
+
+    EXPECT_EQ(result.commands, commands.size());
+    EXPECT_EQ(result.checkpoints, 20);
+    EXPECT_EQ(result.trades.Count(), liveTrades.Count());
+    EXPECT_EQ(result.trades.Value(), liveTrades.Value());
+    EXPECT_EQ(replayed.Size(), live.Size());
+    EXPECT_EQ(replayed.PendingStopCount(), live.PendingStopCount());
+    EXPECT_EQ(replayed.GetOrderInfos().GetBids(), live.GetOrderInfos().GetBids());
+    EXPECT_EQ(replayed.GetOrderInfos().GetAsks(), live.GetOrderInfos().GetAsks());
+}
+
+TEST(JournalTest, CheckpointMismatchThrows) {
+    TempFile file;
+    {
+        JournalWriter writer{file.path, JournalWriterOptions{.sync = false}};
+        writer.Append(OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5));
+        writer.Append(OrderCommand::Add(OrderType::GoodTillCancel, 2, Side::Buy, 100, 5));
+        writer.AppendCheckpoint(TradeChecksum{});  // claims no trades happened
+    }
+
+    Orderbook book;
+    EXPECT_THROW(ReplayJournal(file.path, book), std::runtime_error);
+}
+
+TEST(JournalTest, ReopenTrimsTornRecordAndAppends) {
+    TempFile file;
+    {
+        JournalWriter writer{file.path, JournalWriterOptions{.sync = false}};
+        writer.Append(OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Buy, 100, 5));
+    }
+    {
+        // Half a record, as if the process died mid-write
+        std::ofstream out{file.path, std::ios::binary | std::ios::app};
+        out.write("\x01\x00\x00\x00", 4);
+    }
+    {
+        JournalWriter writer{file.path, JournalWriterOptions{.sync = false}};
+        EXPECT_EQ(writer.CommandCount(), 1);
+        writer.Append(OrderCommand::Cancel(1));
+    }
+
+    JournalReader reader{file.path};
+    EXPECT_EQ(reader.RecordCount(), 2);
+
+    Orderbook book;
+    auto result = ReplayJournal(file.path, book);
+    EXPECT_EQ(result.commands, 2);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(JournalTest, RejectsForeignFile) {
+    TempFile file;
+    std::ofstream{file.path} << "definitely not a journal, but long enough to hold a header";
+
+    EXPECT_THROW(JournalReader{file.path}, std::runtime_error);
+}
+
+// ===============================
+//         Snapshot Tests
+// ===============================
+
+TEST(SnapshotTest, RestoredBookBehavesIdentically) {
+    auto commands = MakeRandomCommands(21, 4000);
+    auto tail = MakeRandomCommands(22, 2000);
+    for (auto& command : tail)
+        command.orderID += 100000;
+
+    Orderbook original{LadderConfig{80, 1, 40}};
+    Trades ignored;
+    original.ProcessBatch(commands, ignored);
+    ASSERT_GT(original.Size(), 0);
+
+    Orderbook restored;
+    restored.LoadSnapshot(original.SaveSnapshot());
+
+    EXPECT_EQ(restored.Size(), original.Size());
+    EXPECT_EQ(restored.PendingStopCount(), original.PendingStopCount());
+    EXPECT_EQ(restored.GetOrderInfos().GetBids(), original.GetOrderInfos().GetBids());
+    EXPECT_EQ(restored.GetOrderInfos().GetAsks(), original.GetOrderInfos().GetAsks());
+
+    // Same FIFO order and stops, so the same future flow yields the same trades
+    Trades expected, actual;
+    original.ProcessBatch(tail, expected);
+    restored.ProcessBatch(tail, actual);
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(restored.SaveSnapshot(), original.SaveSnapshot());
+}
+
+TEST(SnapshotTest, KeepsPartialFills) {
+    Orderbook book;
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 10}, trades);
+    book.AddOrder(Order{OrderType::FillAndKill, 2, Side::Buy, 100, 4}, trades);
+
+    TempFile file;
+    book.SaveSnapshot(file.path);
+
+    Orderbook restored;
+    restored.LoadSnapshot(file.path.string());
+    restored.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Buy, 100, 10}, trades);
+
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[1].GetAskTrade().quantity, 6);
+    EXPECT_EQ(restored.Size(), 1);
+}
+
+TEST(SnapshotTest, RejectsCorruptSnapshotWithoutChangingBook) {
+    Orderbook book;
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 10));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 0, 5, 90));
+    auto snapshot = book.SaveSnapshot();
+
+    Orderbook restored;
+    auto corrupt = snapshot;
+    corrupt.back() ^= std::byte{1};
+    EXPECT_THROW(restored.LoadSnapshot(corrupt), std::runtime_error);
+
+    auto truncated = snapshot;
+    truncated.resize(truncated.size() - 32);
+    EXPECT_THROW(restored.LoadSnapshot(truncated), std::runtime_error);
+    EXPECT_EQ(restored.Size(), 0);
+    EXPECT_EQ(restored.PendingStopCount(), 0);
+
+    restored.LoadSnapshot(snapshot);
+    EXPECT_EQ(restored.Size(), 1);
+    EXPECT_EQ(restored.PendingStopCount(), 1);
+    EXPECT_THROW(restored.LoadSnapshot(snapshot), std::logic_error);
+}
+
+TEST(SnapshotTest, RejectsRestingRecordsNoBookCouldHold) {
+    Orderbook source;
+    source.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 10));
+    auto snapshot = source.SaveSnapshot();
+
+    using namespace snapshot_format;
+    auto Patched = [&](auto patch) {
+        auto copy = snapshot;
+        auto payload = std::span{ copy }.subspan(HeaderSize);
+        patch(payload.data());
+        StoreLE(copy.data() + 32, PayloadChecksum(payload));
+        return copy;
+    };
+
+    // Market, FillAndKill and FillOrKill orders never rest, and no order has a negative price
+    for (auto type : { OrderType::Market, OrderType::FillAndKill, OrderType::FillOrKill }) {
+        Orderbook book;
+        EXPECT_THROW(book.LoadSnapshot(Patched([&](std::byte* record) { record[0] = static_cast<std::byte>(type); })),
+                     std::runtime_error);
+        EXPECT_EQ(book.Size(), 0);
+    }
+    Orderbook book;
+    EXPECT_THROW(book.LoadSnapshot(Patched([](std::byte* record) { StoreLE(record + 16, Price{ -1 }); })),
+                 std::runtime_error);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(SnapshotTest, RejectedLoadLeavesLevelSequenceAndDepthUnchanged) {
+    Orderbook source;
+    source.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 10));
+    source.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 99, 10));
+    source.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Sell, 105, 5));
+    auto snapshot = source.SaveSnapshot();
+
+    // Give the last record the first one's ID; the duplicate is only found mid-load
+    using namespace snapshot_format;
+    auto payload = std::span{ snapshot }.subspan(HeaderSize);
+    StoreLE(payload.data() + 2 * RecordSize + 8, OrderID{ 1 });
+    StoreLE(snapshot.data() + 32, PayloadChecksum(payload));
+
+    Orderbook book;
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 50, Side::Sell, 110, 1));
+    book.CancelOrder(50);
+    auto sequence = book.LevelUpdateSequence();
+
+    EXPECT_THROW(book.LoadSnapshot(snapshot), std::runtime_error);
+    EXPECT_EQ(book.LevelUpdateSequence(), sequence);
+    EXPECT_TRUE(book.GetOrderInfos().GetBids().empty());
+    EXPECT_TRUE(book.GetOrderInfos().GetAsks().empty());
+    EXPECT_EQ(book.Size(), 0);
+
+    // Nothing from the unwound load leaks into the next command's updates
+    struct Recorder : OrderbookListener {
+        LevelUpdates updates;
+        void OnLevelUpdate(const LevelUpdate& update) override { updates.push_back(update); }
+    } recorder;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 7, Side::Buy, 100, 1}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{ { sequence + 1, Side::Buy, 100, 1, 1 } }));
+}
+
+// ===============================
+//       Depth Publisher Tests
+// ===============================
+
+TEST(DepthPublisherTest, PublishesTopLevelsAndSkipsNoOps) {
+    Orderbook book;
+    for (Price price : {97, 98, 99})
+        book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, price, Side::Buy, price, 10));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 101, Side::Sell, 101, 4));
+
+    DepthPublisher depth{2};
+    DepthSnapshot snapshot;
+    depth.Read(snapshot);
+    EXPECT_EQ(snapshot.version, 0);
+    EXPECT_FALSE(snapshot.BestBid());
+
+    EXPECT_TRUE(depth.Publish(book));
+    EXPECT_FALSE(depth.Publish(book));
+    depth.Read(snapshot);
+    EXPECT_EQ(snapshot.version, 1);
+    EXPECT_EQ(snapshot.bids, (LevelInfos{ {99, 10, 1}, {98, 10, 1} }));
+    EXPECT_EQ(snapshot.asks, (LevelInfos{ {101, 4, 1} }));
+
+    book.CancelOrder(101);
+    EXPECT_TRUE(depth.Publish(book));
+    depth.Read(snapshot);
+    EXPECT_EQ(depth.Version(), 2);
+    EXPECT_FALSE(snapshot.BestAsk());
+    EXPECT_EQ(snapshot.BestBid()->price_, 99);
+}
+
+TEST(DepthPublisherTest, ReadersSeeConsistentDepthWhileEngineRuns) {
+    constexpr Quantity Steps = 5000;
+    constexpr Price AskBase = 1000000;
+
+    // Step k rests a bid at k for k and an ask at AskBase - k for k, so in any
+    // consistent view the bids count down by one and the two sides are at most a step apart
+    DepthPublisher depth{4};
+    MatchingEngine engine{MatchingEngineConfig{.queueCapacity = 64}};
+    engine.AddInstrument(1, std::nullopt, nullptr, &depth);
+    engine.Start();
+
+    std::atomic<bool> done{ false };
+    auto Reader = [&] {
+        DepthSnapshot snapshot;
+        std::uint64_t lastVersion = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            depth.Read(snapshot);
+            ASSERT_GE(snapshot.version, lastVersion);
+            lastVersion = snapshot.version;
+
+            for (std::size_t i = 0; i < snapshot.bids.size(); ++i) {
+                ASSERT_EQ(snapshot.bids[i].price_, snapshot.bids[0].price_ - Price(i));
+                ASSERT_EQ(snapshot.bids[i].quantity_, Quantity(snapshot.bids[i].price_));
+            }
+            if (auto bid = snapshot.BestBid(), ask = snapshot.BestAsk(); bid && ask) {
+                ASSERT_EQ(ask->quantity_, Quantity(AskBase - ask->price_));
+                ASSERT_LE(bid->quantity_ - ask->quantity_, 1u);
+            }
+            std::this_thread::yield();
+        }
+    };
+    std::thread readers[] = { std::thread{Reader}, std::thread{Reader} };
+
+    for (Quantity k = 1; k <= Steps; ++k) {
+        engine.Submit(1, OrderCommand::Add(OrderType::GoodTillCancel, 2 * k, Side::Buy, Price(k), k));
+        engine.Submit(1, OrderCommand::Add(OrderType::GoodTillCancel, 2 * k + 1, Side::Sell, AskBase - Price(k), k));
+    }
+    engine.WaitIdle();
+    done = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    DepthSnapshot snapshot;
+    depth.Read(snapshot);
+    EXPECT_EQ(snapshot.version, 2 * Steps);
+    EXPECT_EQ(snapshot.bids.size(), 4);
+    EXPECT_EQ(snapshot.BestBid()->price_, Price(Steps));
+    EXPECT_EQ(snapshot.BestAsk()->price_, AskBase - Price(Steps));
+}
+
+// ===============================
+//        Level Update Tests
+// ===============================
+
+struct LevelUpdateRecorder : OrderbookListener {
+    LevelUpdates updates;
+    void OnLevelUpdate(const LevelUpdate& update) override { updates.push_back(update); }
+};
+
+TEST(LevelUpdateTest, SweepReportsOneUpdatePerTouchedLevel) {
+    Orderbook book;
+    LevelUpdateRecorder recorder;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 101, 5}, recorder);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 101, 5}, recorder);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 102, 10}, recorder);
+    ASSERT_EQ(recorder.updates.size(), 3);
+    EXPECT_EQ(recorder.updates[1], (LevelUpdate{2, Side::Sell, 101, 10, 2}));
+
+    // Two fills at 101 and one at 102 collapse to one update per level
+    recorder.updates.clear();
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 102, 14}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{
+        {4, Side::Sell, 101, 0},
+        {5, Side::Sell, 102, 6, 1}
+    }));
+
+    recorder.updates.clear();
+    book.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Buy, 102, 10}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{
+        {6, Side::Sell, 102, 0},
+        {7, Side::Buy, 102, 4, 1}
+    }));
+    EXPECT_EQ(book.LevelUpdateSequence(), 7);
+}
+
+TEST(LevelUpdateTest, ModifyReportsNetChangeOnly) {
+    Orderbook book;
+    LevelUpdateRecorder recorder;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}, recorder);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 5}, recorder);
+    recorder.updates.clear();
+
+    // Cancel-replace at the same price: 15 -> 5 -> 25 is reported as 25
+    book.ModifyOrder(OrderModify{1, Side::Buy, 100, 20}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{ {3, Side::Buy, 100, 25, 2} }));
+
+    recorder.updates.clear();
+    book.ModifyOrder(OrderModify{2, Side::Buy, 99, 5}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{
+        {4, Side::Buy, 100, 20, 1},
+        {5, Side::Buy, 99, 5, 1}
+    }));
+
+    // Cancelling an unknown order changes nothing
+    recorder.updates.clear();
+    book.CancelOrder(42, recorder);
+    EXPECT_TRUE(recorder.updates.empty());
+}
+
+TEST(LevelUpdateTest, ThrowingCommandLeavesNothingForTheNext) {
+    Orderbook book;
+    LevelUpdateRecorder recorder;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}, recorder);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 99, 5}, recorder);
+    recorder.updates.clear();
+
+    // An invalid replacement is refused before the original is taken out
+    EXPECT_THROW(book.ModifyOrder(OrderModify{1, Side::Buy, 101, 0}, recorder), std::invalid_argument);
+    EXPECT_TRUE(recorder.updates.empty());
+    EXPECT_EQ(book.LevelUpdateSequence(), 2);
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ {100, 10, 1}, {99, 5, 1} }));
+
+    // A listener throwing mid-command drops that command's changes
+    struct ThrowOnCancel : OrderbookListener {
+        void OnOrderCancelled(const Order&) override { throw std::runtime_error("listener failed"); }
+    } throwing;
+    EXPECT_THROW(book.CancelOrder(2, throwing), std::runtime_error);
+    EXPECT_EQ(book.LevelUpdateSequence(), 2);
+
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 105, 4}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{ {3, Side::Sell, 105, 4, 1} }));
+}
+
+TEST(LevelUpdateTest, LevelsCountTheirOrders) {
+    Orderbook book;
+    LevelUpdateRecorder recorder;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 5}, recorder);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 100, 20, std::nullopt, NoOwner, 5}, recorder);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 100, 5}, recorder);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Sell, 101, 5}, recorder);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ {100, 15, 3}, {101, 5, 1} }));
+
+    // Reduced in place: same orders, less quantity
+    recorder.updates.clear();
+    book.ModifyOrder(OrderModify{3, Side::Sell, 100, 2}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{ {5, Side::Sell, 100, 12, 3} }));
+
+    // A fill that takes an order out of the level
+    recorder.updates.clear();
+    book.AddOrder(Order{OrderType::FillAndKill, 5, Side::Buy, 100, 5}, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{ {6, Side::Sell, 100, 7, 2} }));
+
+    // The iceberg's peak refills at the back: neither quantity nor count moves, so nothing is reported
+    recorder.updates.clear();
+    book.AddOrder(Order{OrderType::FillAndKill, 6, Side::Buy, 100, 5}, recorder);
+    EXPECT_TRUE(recorder.updates.empty());
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ {100, 7, 2}, {101, 5, 1} }));
+
+    recorder.updates.clear();
+    book.CancelOrder(3, recorder);
+    EXPECT_EQ(recorder.updates, (LevelUpdates{ {7, Side::Sell, 100, 5, 1} }));
+
+    std::array<LevelInfo, 1> top;
+    ASSERT_EQ(book.GetTopLevels(Side::Sell, top), 1);
+    EXPECT_EQ(top[0], (LevelInfo{ 100, 5, 1 }));
+    EXPECT_EQ(book.GetTopLevels(2).GetAsks(), book.GetOrderInfos().GetAsks());
+}
+
+TEST(LevelUpdateTest, DeltasRebuildDepthFromSnapshot) {
+    auto commands = MakeRandomCommands(7, 4000);
+    std::span<const OrderCommand> all{ commands };
+
+    Orderbook book;
+    LevelUpdateRecorder recorder;
+    book.ProcessBatch(all.first(1500), recorder);
+
+    auto snapshot = book.GetOrderInfos();
+    auto sequence = book.LevelUpdateSequence();
+    book.ProcessBatch(all.subspan(1500), recorder);
+
+    // The stream starts before the snapshot; updates it already reflects are skipped
+    auto rebuilt = ApplyLevelUpdates(snapshot, sequence, recorder.updates);
+    EXPECT_EQ(rebuilt.GetBids(), book.GetOrderInfos().GetBids());
+    EXPECT_EQ(rebuilt.GetAsks(), book.GetOrderInfos().GetAsks());
+
+    auto gap = recorder.updates;
+    gap.erase(gap.begin() + static_cast<std::ptrdiff_t>(sequence) + 10);
+    EXPECT_THROW(ApplyLevelUpdates(snapshot, sequence, gap), std::runtime_error);
+}
+
+// ===============================
+//      Market-by-Order Tests
+// ===============================
+
+// Rebuilds the visible orders from a feed and checks them against the book's own
+static void ExpectFeedMatchesBook(std::span<const std::byte> received, const Orderbook& book) {
+    struct Resting { Side side; Price price; Quantity quantity; };
+    std::unordered_map<OrderID, Resting> orders;
+    std::uint64_t expected = 1;
+    for (std::size_t offset = 0; offset < received.size(); offset += MarketByOrderMessageSize) {
+        auto message = DecodeMarketByOrder(received.data() + offset);
+        ASSERT_EQ(message.sequence, expected++);
+
+        if (message.type == MarketByOrderType::Add) {
+            ASSERT_TRUE(orders.emplace(message.orderID, Resting{ message.side, message.price, message.quantity }).second);
+            continue;
+        }
+
+        auto it = orders.find(message.orderID);
+        ASSERT_NE(it, orders.end());
+        ASSERT_EQ(it->second.side, message.side);
+        if (message.type == MarketByOrderType::Execute)
+            it->second.quantity -= message.quantity;
+        else if (message.type == MarketByOrderType::Reduce)
+            it->second.quantity = message.quantity;
+        if (message.type == MarketByOrderType::Delete || it->second.quantity == 0)
+            orders.erase(it);
+    }
+
+    EXPECT_EQ(orders.size(), book.Size());
+    for (const auto& [id, order] : orders) {
+        const auto* resting = book.GetOrder(id);
+        ASSERT_NE(resting, nullptr) << "order " << id;
+        EXPECT_EQ(resting->GetSide(), order.side) << "order " << id;
+        EXPECT_EQ(resting->GetPrice(), order.price) << "order " << id;
+        EXPECT_EQ(resting->GetVisibleQuantity(), order.quantity) << "order " << id;
+    }
+}
+
+TEST(MarketByOrderTest, ReportsOnlyVisibleOrders) {
+    Orderbook book;
+    MarketByOrderFeed feed{64};
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 101, 10}, feed);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 0, 5, 90}, feed);     // stop: hidden
+    book.AddOrder(Order{OrderType::FillAndKill, 3, Side::Buy, 101, 4}, feed);           // executes 4
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 102, 8}, feed);        // executes 6, rests 2
+    book.ModifyOrder(OrderModify{4, Side::Buy, 102, 1}, feed);
+    book.CancelOrder(2, feed);
+    book.CancelOrder(4, feed);
+
+    std::array<std::byte, 16 * MarketByOrderMessageSize> buffer;
+    auto bytes = feed.Read(buffer);
+    std::vector<MarketByOrderMessage> messages;
+    for (std::size_t offset = 0; offset < bytes; offset += MarketByOrderMessageSize)
+        messages.push_back(DecodeMarketByOrder(buffer.data() + offset));
+
+    using enum MarketByOrderType;
+    EXPECT_EQ(messages, (std::vector<MarketByOrderMessage>{
+        {1, Add, Side::Sell, 1, 101, 10},
+        {2, Execute, Side::Sell, 1, 101, 4},
+        {3, Execute, Side::Sell, 1, 101, 6},
+        {4, Add, Side::Buy, 4, 102, 2},
+        {5, Reduce, Side::Buy, 4, 102, 1},
+        {6, Delete, Side::Buy, 4, 102, 1}
+    }));
+    EXPECT_EQ(feed.Read(buffer), 0);
+}
+
+TEST(MarketByOrderTest, ConsumerThreadRebuildsBookFromMessages) {
+    auto commands = MakeRandomCommands(21, 4000);
+
+    // A small ring forces the matcher to wait on the consumer now and then
+    MarketByOrderFeed feed{16};
+    std::atomic<bool> done{ false };
+    std::vector<std::byte> received;
+    std::thread consumer([&] {
+        std::array<std::byte, 8 * MarketByOrderMessageSize> buffer;
+        for (;;) {
+            bool finished = done.load(std::memory_order_acquire);
+            auto bytes = feed.Read(buffer);
+            received.insert(received.end(), buffer.begin(), buffer.begin() + bytes);
+            if (bytes == 0 && finished)
+                return;
+            if (bytes == 0)
+                std::this_thread::yield();
+        }
+    });
+
+    Orderbook book;
+    book.ProcessBatch(commands, feed);
+    done = true;
+    consumer.join();
+
+    ExpectFeedMatchesBook(received, book);
+}
+
+TEST(MarketByOrderTest, UncrossExecutesBothSides) {
+    auto commands = MakeRandomCommands(29, 3000);
+    std::span<const OrderCommand> all{ commands };
+
+    Orderbook book;
+    MarketByOrderFeed feed{1 << 16};
+    std::vector<std::byte> received;
+    auto Drain = [&] {
+        std::array<std::byte, 64 * MarketByOrderMessageSize> buffer;
+        while (auto bytes = feed.Read(buffer))
+            received.insert(received.end(), buffer.begin(), buffer.begin() + bytes);
+    };
+
+    // Continuous trading, an auction that collects crossed orders, then continuous again
+    book.ProcessBatch(all.first(1000), feed);
+    Drain();
+    book.StartAuction(100);
+    book.ProcessBatch(all.subspan(1000, 1000), feed);
+    Drain();
+    ASSERT_NE(book.GetIndicativeUncross().volume, 0);
+    ASSERT_NE(book.Uncross(feed).volume, 0);
+    Drain();
+    ASSERT_NO_FATAL_FAILURE(ExpectFeedMatchesBook(received, book));
+
+    book.ProcessBatch(all.subspan(2000), feed);
+    Drain();
+    ExpectFeedMatchesBook(received, book);
+}
+
+TEST(MarketByOrderTest, FlushesToFile) {
+    TempFile file;
+    Orderbook book;
+    MarketByOrderFeed feed{8};
+    for (OrderID id = 1; id <= 6; ++id)
+        book.AddOrder(Order{OrderType::GoodTillCancel, id, Side::Buy, 100, 1}, feed);
+
+    int fd = ::open(file.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(feed.Flush(fd), 6);
+    ::close(fd);
+
+    MappedFile mapped{file.path.string()};
+    ASSERT_EQ(mapped.data().size(), 6 * MarketByOrderMessageSize);
+    auto last = DecodeMarketByOrder(mapped.data().data() + 5 * MarketByOrderMessageSize);
+    EXPECT_EQ(last, (MarketByOrderMessage{6, MarketByOrderType::Add, Side::Buy, 6, 100, 1}));
+}
+
+// ===============================
+//       Order Entry Tests
+// ===============================
+
+static std::vector<std::byte> EncodeMessages(std::span<const OrderCommand> commands) {
+    std::vector<std::byte> buffer(commands.size() * MaxOrderEntryMessageSize);
+    std::size_t size = 0;
+    for (const auto& command : commands)
+        size += EncodeOrderEntry(command, buffer.data() + size);
+    buffer.resize(size);
+    return buffer;
+}
+
+static std::vector<ExecutionReport> DecodeReports(std::span<const std::byte> bytes) {
+    std::vector<ExecutionReport> reports;
+    for (std::size_t offset = 0; offset < bytes.size(); offset += ExecutionReportSize)
+        reports.push_back(DecodeExecutionReport(bytes.data() + offset));
+    return reports;
+}
+
+TEST(OrderEntryTest, ReaderViewsMessagesInPlaceAndKeepsPartialTail) {
+    std::vector<OrderCommand> commands{
+        OrderCommand::Add(OrderType::GoodTillCancel, 7, Side::Sell, 0, 30, 95),
+        OrderCommand::Cancel(8),
+        OrderCommand::Modify(OrderModify{9, Side::Buy, 101, 12})
+    };
+    auto buffer = EncodeMessages(commands);
+    ASSERT_EQ(buffer.size(), NewOrderMessageSize + CancelOrderMessageSize + ModifyOrderMessageSize);
+
+    OrderEntryReader reader{std::span{ buffer }.first(buffer.size() - 5)};
+    OrderEntryMessage message;
+    ASSERT_TRUE(reader.Next(message));
+    EXPECT_EQ(message.GetType(), OrderEntryType::New);
+    EXPECT_EQ(message.GetOrderID(), 7);
+    EXPECT_EQ(message.GetSide(), Side::Sell);
+    EXPECT_EQ(message.GetQuantity(), 30);
+    EXPECT_EQ(message.GetStopPrice(), 95);
+
+    ASSERT_TRUE(reader.Next(message));
+    EXPECT_EQ(message.GetType(), OrderEntryType::Cancel);
+    EXPECT_EQ(message.GetOrderID(), 8);
+
+    EXPECT_FALSE(reader.Next(message));
+    EXPECT_EQ(reader.Consumed(), NewOrderMessageSize + CancelOrderMessageSize);
+
+    OrderEntryReader rest{std::span{ buffer }.subspan(reader.Consumed())};
+    ASSERT_TRUE(rest.Next(message));
+    EXPECT_EQ(message.ToCommand().ToModify().GetPrice(), 101);
+    EXPECT_EQ(message.GetSide(), Side::Buy);
+}
+
+TEST(OrderEntryTest, SessionMatchesDirectProcessing) {
+    auto commands = MakeRandomCommands(31, 5000);
+    auto buffer = EncodeMessages(commands);
+
+    Orderbook book;
+    OrderEntrySession session{book};
+    EXPECT_EQ(session.Process(buffer), buffer.size());
+    EXPECT_EQ(session.MessageCount(), commands.size());
+
+    Orderbook expected;
+    Trades trades;
+    expected.ProcessBatch(commands, trades);
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), expected.GetOrderInfos().GetBids());
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), expected.GetOrderInfos().GetAsks());
+
+    auto reports = DecodeReports(session.Reports());
+    std::size_t fills = 0;
+    for (std::size_t i = 0; i < reports.size(); ++i) {
+        ASSERT_EQ(reports[i].sequence, i + 1);
+        fills += reports[i].type == ExecutionReportType::Fill;
+    }
+    EXPECT_EQ(fills, 2 * trades.size());
+}
+
+TEST(OrderEntryTest, ReportsRejectsAndRefusesMalformedInput) {
+    Orderbook book;
+    OrderEntrySession session{book};
+
+    auto buffer = EncodeMessages(std::vector{
+        OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Buy, 100, 0),
+        OrderCommand::Add(OrderType::FillOrKill, 2, Side::Buy, 100, 5)
+    });
+    session.Process(buffer);
+
+    auto reports = DecodeReports(session.Reports());
+    ASSERT_EQ(reports.size(), 2);
+    EXPECT_EQ(reports[0].type, ExecutionReportType::Rejected);
+    EXPECT_EQ(reports[0].reason, InvalidOrderReason);
+    EXPECT_EQ(reports[1].type, ExecutionReportType::Rejected);
+    EXPECT_EQ(reports[1].reason, static_cast<std::uint8_t>(RejectReason::InsufficientLiquidity));
+
+    std::vector<std::byte> badReport{ session.Reports().begin(), session.Reports().begin() + ExecutionReportSize };
+    badReport[1] = std::byte{ 7 };
+    EXPECT_THROW(DecodeExecutionReport(badReport.data()), std::runtime_error);
+
+    session.ClearReports();
+    auto bad = EncodeMessages(std::vector{ OrderCommand::Cancel(1) });
+    bad[0] = std::byte{ 'Z' };
+    EXPECT_THROW(session.Process(bad), std::runtime_error);
+
+    auto badSide = EncodeMessages(std::vector{ OrderCommand::Add(OrderType::GoodTillCancel, 3, Side::Buy, 100, 5) });
+    badSide[2] = std::byte{ 7 };
+    EXPECT_THROW(session.Process(badSide), std::runtime_error);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(OrderEntryTest, SessionsCannotCancelOrModifyOthersOrders) {
+    Orderbook book;
+    ExecutionReportRouter router{book};
+    OrderEntrySession first{router, 1};
+    OrderEntrySession second{router, 2};
+
+    first.Process(EncodeMessages(std::vector{ OrderCommand::Add(OrderType::GoodTillCancel, 10, Side::Buy, 100, 5) }));
+    second.Process(EncodeMessages(std::vector{
+        OrderCommand::Cancel(10),
+        OrderCommand::Modify(OrderModify{10, Side::Buy, 101, 7}),
+        OrderCommand::Cancel(99)
+    }));
+
+    auto rejects = DecodeReports(second.Reports());
+    ASSERT_EQ(rejects.size(), 2);
+    for (const auto& report : rejects) {
+        EXPECT_EQ(report.type, ExecutionReportType::Rejected);
+        EXPECT_EQ(report.reason, NotOwnerReason);
+        EXPECT_EQ(report.orderID, 10);
+    }
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ {100, 5, 1} }));
+
+    first.ClearReports();
+    first.Process(EncodeMessages(std::vector{ OrderCommand::Cancel(10) }));
+    auto reports = DecodeReports(first.Reports());
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_EQ(reports[0].type, ExecutionReportType::Cancelled);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(OrderEntryTest, EachSessionHearsOfItsOwnFills) {
+    Orderbook book;
+    ExecutionReportRouter router{book};
+    OrderEntrySession maker{router, 1};
+    OrderEntrySession taker{router, 2};
+    EXPECT_THROW((OrderEntrySession{router, 1}), std::invalid_argument);
+    EXPECT_THROW((OrderEntrySession{router, NoOwner}), std::invalid_argument);
+
+    maker.Process(EncodeMessages(std::vector{ OrderCommand::Add(OrderType::GoodTillCancel, 10, Side::Buy, 100, 10) }));
+    taker.Process(EncodeMessages(std::vector{ OrderCommand::Add(OrderType::GoodTillCancel, 20, Side::Sell, 100, 20) }));
+
+    // Each session numbers its own reports, and only sees its own side of the trade
+    EXPECT_EQ(DecodeReports(maker.Reports()), (std::vector<ExecutionReport>{
+        { 1, ExecutionReportType::Accepted, Side::Buy, 0, 10, 100, 10, 1 },
+        { 2, ExecutionReportType::Fill, Side::Buy, 0, 10, 100, 10, 1 }
+    }));
+    EXPECT_EQ(DecodeReports(taker.Reports()), (std::vector<ExecutionReport>{
+        { 1, ExecutionReportType::Accepted, Side::Sell, 0, 20, 100, 20, 2 },
+        { 2, ExecutionReportType::Fill, Side::Sell, 0, 20, 100, 10, 2 }
+    }));
+
+    // A session with the book to itself still reports both sides, each with its owner
+    Orderbook alone;
+    Trades trades;
+    alone.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, std::nullopt, 4}, trades);
+    OrderEntrySession only{alone, 3};
+    only.Process(EncodeMessages(std::vector{ OrderCommand::Add(OrderType::GoodTillCancel, 2, Side::Buy, 100, 5) }));
+    auto reports = DecodeReports(only.Reports());
+    ASSERT_EQ(reports.size(), 3);
+    EXPECT_EQ(reports[1], (ExecutionReport{ 2, ExecutionReportType::Fill, Side::Buy, 0, 2, 100, 5, 3 }));
+    EXPECT_EQ(reports[2], (ExecutionReport{ 3, ExecutionReportType::Fill, Side::Sell, 0, 1, 100, 5, 4 }));
+}
+
+// ===============================
+//     Replay Harness Tests
+// ===============================
+
+TEST(LatencyHistogramTest, KeepsValuesWithinPrecision) {
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 0; value < 256; ++value)
+        histogram.Record(value);
+    EXPECT_EQ(histogram.ValueAtPercentile(50), 127);
+    EXPECT_EQ(histogram.ValueAtPercentile(100), 255);
+
+    std::mt19937_64 rng{ 3 };
+    for (int i = 0; i < 1000; ++i) {
+        auto value = rng() >> (rng() % 64);
+        LatencyHistogram single;
+        single.Record(value);
+        single.Record(0);
+        auto reported = single.ValueAtPercentile(100);
+        EXPECT_EQ(reported, value);
+
+        // Below the maximum a value reads back as the top of its bucket
+        LatencyHistogram pair;
+        pair.Record(value);
+        pair.Record(std::numeric_limits<std::uint64_t>::max());
+        auto bucketTop = pair.ValueAtPercentile(50);
+        EXPECT_GE(bucketTop, value);
+        EXPECT_LE(bucketTop - value, value / 128);
+    }
+}
+
+TEST(LatencyHistogramTest, PercentilesAndMerge) {
+    LatencyHistogram low, high;
+    for (std::uint64_t value = 1; value <= 5000; ++value)
+        low.Record(value * 10);
+    for (std::uint64_t value = 5001; value <= 10000; ++value)
+        high.Record(value * 10);
+
+    low.Merge(high);
+    EXPECT_EQ(low.Count(), 10000);
+    EXPECT_EQ(low.Min(), 10);
+    EXPECT_EQ(low.Max(), 100000);
+    EXPECT_DOUBLE_EQ(low.Mean(), 50005.0);
+
+    for (double percentile : { 50.0, 90.0, 99.0, 99.9 }) {
+        auto expected = static_cast<double>(percentile * 1000);
+        auto actual = static_cast<double>(low.ValueAtPercentile(percentile));
+        EXPECT_NEAR(actual, expected, expected / 128) << percentile;
+    }
+
+    low.Reset();
+    EXPECT_EQ(low.Count(), 0);
+    EXPECT_EQ(low.ValueAtPercentile(99), 0);
+}
+
+TEST(OrderFlowFileTest, ParsesCsv) {
+    auto commands = ParseOrderFlowCsv(
+        "# recorded session\n"
+        "A,GTC,1,B,100,10\r\n"
+        "\n"
+        "A,STOP,2,S,0,5,95\n"
+        "M,1,B,101,8\n"
+        "C,2");
+
+    ASSERT_EQ(commands.size(), 4);
+    EXPECT_EQ(commands[0].type, CommandType::Add);
+    EXPECT_EQ(commands[0].orderType, OrderType::GoodTillCancel);
+    EXPECT_EQ(commands[0].quantity, 10);
+    EXPECT_EQ(commands[1].orderType, OrderType::StopOrder);
+    EXPECT_EQ(commands[1].side, Side::Sell);
+    EXPECT_EQ(commands[1].stopPrice, 95);
+    EXPECT_EQ(commands[2].type, CommandType::Modify);
+    EXPECT_EQ(commands[2].price, 101);
+    EXPECT_EQ(commands[3].type, CommandType::Cancel);
+    EXPECT_EQ(commands[3].orderID, 2);
+
+    auto failsOnLine = [](std::string_view text, std::string_view line) {
+        try {
+            (void)ParseOrderFlowCsv(text);
+        } catch (const std::runtime_error& error) {
+            return std::string_view{ error.what() }.find(line) != std::string_view::npos;
+        }
+        return false;
+    };
+    EXPECT_TRUE(failsOnLine("A,GTC,1,B,100,10\nA,GTC,2,X,100,10\n", "line 2"));
+    EXPECT_TRUE(failsOnLine("C,1\n\nC,1,2\n", "line 3"));
+    EXPECT_TRUE(failsOnLine("A,IOC,1,B,100,10\n", "line 1"));
+    EXPECT_TRUE(failsOnLine("M,1,B,100\n", "line 1"));
+    EXPECT_TRUE(failsOnLine("A,GTC,1,B,100,-5\n", "line 1"));
+}
+
+TEST(OrderFlowFileTest, RoundTripsBothFormats) {
+    auto commands = MakeRandomCommands(37, 2000);
+    auto expected = FormatOrderFlowCsv(commands);
+
+    for (std::string extension : { ".csv", ".bin" }) {
+        TempFile file{extension};
+        SaveOrderFlow(file.path, commands);
+        EXPECT_EQ(FormatOrderFlowCsv(LoadOrderFlow(file.path)), expected) << extension;
+    }
+
+    TempFile truncated;
+    SaveOrderFlow(truncated.path, commands);
+    std::filesystem::resize_file(truncated.path, std::filesystem::file_size(truncated.path) - 1);
+    EXPECT_THROW(LoadOrderFlow(truncated.path), std::runtime_error);
+}
+
+// ===============================
+//     Instrumentation Tests
+// ===============================
+
+TEST(InstrumentationTest, CountsHotPathEvents) {
+    auto before = TakeInstrumentationSnapshot();
+    Orderbook book;
+
+    // Stop at 100 trades at 98, which triggers the stop at 98: one cascade, two generations deep
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 98, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 96, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 10, Side::Sell, 0, 1, 100));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 11, Side::Sell, 0, 1, 98));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 20, Side::Sell, 100, 1));
+
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 30, Side::Buy, 100, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 31, Side::Sell, 101, 1));
+    book.AddOrder(std::make_shared<Order>(OrderType::FillOrKill, 32, Side::Sell, 100, 5));
+    book.AddOrder(std::make_shared<Order>(OrderType::PostOnly, 33, Side::Sell, 100, 1));
+    book.CancelOrder(30);
+    book.ModifyOrder(OrderModify{ 99, Side::Buy, 100, 1 });
+
+    // Another thread's book lands in its own block
+    std::thread other([] {
+        Orderbook book;
+        book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 1));
+        book.CancelOrder(1);
+    });
+    other.join();
+
+    auto after = TakeInstrumentationSnapshot();
+    if constexpr (!InstrumentationEnabled) {
+        EXPECT_EQ(after.threads, 0);
+        EXPECT_EQ(after.adds, 0);
+        EXPECT_EQ(after.matchCycles.Count(), 0);
+        return;
+    }
+
+    EXPECT_EQ(after.adds - before.adds, 11);
+    EXPECT_EQ(after.cancels - before.cancels, 2);
+    EXPECT_EQ(after.modifies - before.modifies, 1);
+    EXPECT_EQ(after.fills - before.fills, 3);
+    EXPECT_EQ(after.rejectedFillAndKill - before.rejectedFillAndKill, 1);
+    EXPECT_EQ(after.rejectedFillOrKill - before.rejectedFillOrKill, 1);
+    EXPECT_EQ(after.rejectedPostOnly - before.rejectedPostOnly, 1);
+    EXPECT_EQ(after.stopTriggers - before.stopTriggers, 2);
+    EXPECT_EQ(after.stopCascades - before.stopCascades, 1);
+    EXPECT_GE(after.maxCascadeDepth, 2);
+    EXPECT_EQ(after.levelsCreated - before.levelsCreated, 5);
+    EXPECT_EQ(after.levelsDestroyed - before.levelsDestroyed, 5);
+    EXPECT_GE(after.threads, before.threads + 1);
+
+    // Eight orders reached matching: four resting adds on this thread, the aggressor,
+    // the two triggered stops and the other thread's add
+    EXPECT_EQ(after.matchCycles.Count() - before.matchCycles.Count(), 8);
+    EXPECT_EQ(after.cancelCycles.Count() - before.cancelCycles.Count(), 2);
+    EXPECT_EQ(after.stopTriggerCycles.Count() - before.stopTriggerCycles.Count(), 1);
+}
+
+TEST(InstrumentationTest, SamplesTimedSections) {
+    EXPECT_THROW(SetInstrumentationSamplePeriod(0), std::invalid_argument);
+
+    auto before = TakeInstrumentationSnapshot();
+    SetInstrumentationSamplePeriod(4);
+
+    // A fresh thread starts its countdown from the first call
+    std::thread worker([] {
+        Orderbook book;
+        for (OrderID id = 1; id <= 8; ++id)
+            book.CancelOrder(id);
+    });
+    worker.join();
+    SetInstrumentationSamplePeriod(1);
+
+    auto after = TakeInstrumentationSnapshot();
+    if constexpr (InstrumentationEnabled) {
+        EXPECT_EQ(after.cancels - before.cancels, 8);
+        EXPECT_EQ(after.cancelCycles.Count() - before.cancelCycles.Count(), 2);
+    }
+}
+
+// ===============================
+//   Self-Trade Prevention Tests
+// ===============================
+
+// Owner 7 rests 5 at 100 ahead of owner 8's 5, then crosses with a buy of `quantity`
+static std::vector<std::string> CrossOwnOrder(SelfTradePrevention mode, Quantity quantity, Orderbook& book) {
+    book.SetSelfTradePrevention(mode);
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, std::nullopt, 7));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 100, 5, std::nullopt, 8));
+
+    RecordingListener listener;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Buy, 100, quantity, std::nullopt, 7}, listener);
+    return listener.events;
+}
+
+TEST(SelfTradePreventionTest, NoneLetsOwnOrdersTrade) {
+    Orderbook book;
+    EXPECT_EQ(CrossOwnOrder(SelfTradePrevention::None, 8, book),
+              (std::vector<std::string>{ "accepted 3", "trade 3/1", "trade 3/2" }));
+    EXPECT_EQ(book.Size(), 1);
+}
+
+TEST(SelfTradePreventionTest, CancelNewestCancelsAggressor) {
+    Orderbook book;
+    EXPECT_EQ(CrossOwnOrder(SelfTradePrevention::CancelNewest, 8, book),
+              (std::vector<std::string>{ "accepted 3", "cancelled 3" }));
+    EXPECT_EQ(book.Size(), 2);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks()[0].quantity_, 10);
+}
+
+TEST(SelfTradePreventionTest, CancelOldestCancelsRestingAndKeepsMatching) {
+    Orderbook book;
+    EXPECT_EQ(CrossOwnOrder(SelfTradePrevention::CancelOldest, 8, book),
+              (std::vector<std::string>{ "accepted 3", "cancelled 1", "trade 3/2" }));
+
+    // Order 2 filled; the remaining 3 of order 3 rests
+    EXPECT_EQ(book.Size(), 1);
+    EXPECT_TRUE(book.GetOrderInfos().GetAsks().empty());
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 100, 3, 1 } }));
+}
+
+TEST(SelfTradePreventionTest, CancelBothStopsAtFirstOwnOrder) {
+    Orderbook book;
+    EXPECT_EQ(CrossOwnOrder(SelfTradePrevention::CancelBoth, 8, book),
+              (std::vector<std::string>{ "accepted 3", "cancelled 1", "cancelled 3" }));
+    EXPECT_EQ(book.Size(), 1);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 5, 1 } }));
+}
+
+TEST(SelfTradePreventionTest, DecrementAndCancelShrinksBothSides) {
+    // Smaller resting order: it is cancelled and the aggressor shrinks by its size, then trades on
+    Orderbook book;
+    EXPECT_EQ(CrossOwnOrder(SelfTradePrevention::DecrementAndCancel, 8, book),
+              (std::vector<std::string>{ "accepted 3", "cancelled 1", "trade 3/2" }));
+    EXPECT_EQ(book.Size(), 1);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 2, 1 } }));
+    EXPECT_TRUE(book.GetOrderInfos().GetBids().empty());
+
+    // Larger resting order: it shrinks in place and the aggressor is cancelled
+    Orderbook larger;
+    EXPECT_EQ(CrossOwnOrder(SelfTradePrevention::DecrementAndCancel, 2, larger),
+              (std::vector<std::string>{ "accepted 3", "reduced 1", "cancelled 3" }));
+    EXPECT_EQ(larger.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 8, 2 } }));
+
+    // Equal sizes cancel each other out
+    Orderbook equal;
+    EXPECT_EQ(CrossOwnOrder(SelfTradePrevention::DecrementAndCancel, 5, equal),
+              (std::vector<std::string>{ "accepted 3", "cancelled 1", "cancelled 3" }));
+    EXPECT_EQ(equal.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 5, 1 } }));
+}
+
+TEST(SelfTradePreventionTest, OtherOwnersAndUnownedOrdersTrade) {
+    Orderbook book;
+    book.SetSelfTradePrevention(SelfTradePrevention::CancelBoth);
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, std::nullopt, 7));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 100, 5));
+
+    EXPECT_EQ(book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 100, 5, std::nullopt, 8)).size(), 1);
+    EXPECT_EQ(book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 4, Side::Buy, 100, 5)).size(), 1);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(SelfTradePreventionTest, FillOrKillDiscountsOwnLiquidity) {
+    auto setup = [](Orderbook& book, SelfTradePrevention mode) {
+        book.SetSelfTradePrevention(mode);
+        book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, std::nullopt, 7));
+        book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 101, 5, std::nullopt, 8));
+    };
+    Order fillOrKill{OrderType::FillOrKill, 3, Side::Buy, 101, 5, std::nullopt, 7};
+
+    // Cancelling the own order leaves enough to fill
+    Orderbook oldest;
+    setup(oldest, SelfTradePrevention::CancelOldest);
+    auto trades = oldest.AddOrder(std::make_shared<Order>(fillOrKill));
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].GetAskTrade().orderID, 2);
+    EXPECT_EQ(oldest.Size(), 0);
+
+    // Any other mode would stop at the own order, so nothing fills
+    Orderbook newest;
+    setup(newest, SelfTradePrevention::CancelNewest);
+    RecordingListener listener;
+    newest.AddOrder(fillOrKill, listener);
+    EXPECT_TRUE(listener.trades.empty());
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "rejected 3 " + std::to_string(static_cast<int>(
+                                                              RejectReason::InsufficientLiquidity)) }));
+    EXPECT_EQ(newest.Size(), 2);
+}
+
+TEST(SelfTradePreventionTest, TriggeredStopIsCancelledLikeAnyAggressor) {
+    Orderbook book;
+    book.SetSelfTradePrevention(SelfTradePrevention::CancelNewest);
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 5));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 99, 5, std::nullopt, 7));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Sell, 0, 5, 100, 7));
+
+    RecordingListener listener;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Sell, 100, 5}, listener);
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "accepted 4", "trade 1/4", "triggered 3", "cancelled 3" }));
+    EXPECT_EQ(book.PendingStopCount(), 0);
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 99, 5, 1 } }));
+}
+
+TEST(SelfTradePreventionTest, OwnerSurvivesModifySnapshotJournalAndFlowFiles) {
+    auto ownCrossTrades = [](Orderbook& book) {
+        book.SetSelfTradePrevention(SelfTradePrevention::CancelNewest);
+        return book.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 99, Side::Buy, 100, 5, std::nullopt, 7)).size();
+    };
+    std::vector<OrderCommand> commands{
+        OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Sell, 101, 5, std::nullopt, 7),
+        OrderCommand::Modify(OrderModify{ 1, Side::Sell, 100, 5 })
+    };
+
+    Orderbook book;
+    Trades trades;
+    book.ProcessBatch(commands, trades);
+
+    Orderbook restored;
+    restored.LoadSnapshot(book.SaveSnapshot());
+    EXPECT_EQ(ownCrossTrades(restored), 0);
+
+    TempFile journal;
+    {
+        JournalWriter writer{journal.path, JournalWriterOptions{ .sync = false }};
+        writer.Append(commands);
+        writer.Commit();
+    }
+    Orderbook replayed;
+    ReplayJournal(journal.path, replayed);
+    EXPECT_EQ(ownCrossTrades(replayed), 0);
+
+    EXPECT_EQ(ownCrossTrades(book), 0);
+    EXPECT_EQ(book.Size(), 1);
+
+    // CSV keeps the owner, leaving the stop price empty when there is none
+    auto csv = FormatOrderFlowCsv(commands);
+    EXPECT_EQ(csv, "A,GTC,1,S,101,5,,7\nM,1,S,100,5\n");
+    auto parsed = ParseOrderFlowCsv(csv);
+    ASSERT_EQ(parsed.size(), 2);
+    EXPECT_EQ(parsed[0].owner, 7);
+    EXPECT_FALSE(parsed[0].stopPrice);
+    EXPECT_EQ(ParseOrderFlowCsv("A,STOP,2,B,0,1,105,9\n")[0].owner, 9);
+}
+
+TEST(SelfTradePreventionTest, SessionStampsOwnerOnItsOrders) {
+    auto buffer = EncodeMessages(std::vector{
+        OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5),
+        OrderCommand::Add(OrderType::GoodTillCancel, 2, Side::Buy, 100, 5)
+    });
+
+    Orderbook book;
+    book.SetSelfTradePrevention(SelfTradePrevention::CancelNewest);
+    OrderEntrySession session{book, 7};
+    session.Process(buffer);
+
+    EXPECT_EQ(book.Size(), 1);
+    auto reports = DecodeReports(session.Reports());
+    EXPECT_TRUE(std::none_of(reports.begin(), reports.end(), [](const ExecutionReport& report) {
+        return report.type == ExecutionReportType::Fill;
+    }));
+}
+
+TEST(SelfTradePreventionTest, MarketByOrderFeedHidesCancelledAggressor) {
+    Orderbook book;
+    book.SetSelfTradePrevention(SelfTradePrevention::CancelBoth);
+    MarketByOrderFeed feed{16};
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, std::nullopt, 7}, feed);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 5, std::nullopt, 7}, feed);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Buy, 99, 5, std::nullopt, 7}, feed);
+
+    std::array<std::byte, 8 * MarketByOrderMessageSize> buffer;
+    auto bytes = feed.Read(buffer);
+    std::vector<MarketByOrderMessage> messages;
+    for (std::size_t offset = 0; offset < bytes; offset += MarketByOrderMessageSize)
+        messages.push_back(DecodeMarketByOrder(buffer.data() + offset));
+
+    // Order 2 never rested, so only the resting order's delete is published
+    using enum MarketByOrderType;
+    EXPECT_EQ(messages, (std::vector<MarketByOrderMessage>{
+        {1, Add, Side::Sell, 1, 100, 5},
+        {2, Delete, Side::Sell, 1, 100, 5},
+        {3, Add, Side::Buy, 3, 99, 5}
+    }));
+}
+
+// ===============================
+//         Iceberg Tests
+// ===============================
+
+TEST(IcebergTest, DisplaysPeakAndReplenishesAtBackOfLevel) {
+    Orderbook book;
+    Trades trades;
+    auto handle = book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 25, std::nullopt, NoOwner, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 100, 5}, trades);
+    const auto* iceberg = book.GetOrder(handle);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 15, 2 } }));
+
+    RecordingListener listener;
+    book.AddOrder(Order{OrderType::FillAndKill, 3, Side::Buy, 100, 12}, listener);
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "accepted 3", "trade 3/1", "replenished 1", "trade 3/2" }));
+    EXPECT_EQ(listener.trades[0].GetAskTrade().quantity, 10);
+
+    // Same order object, refilled from its reserve, now behind order 2
+    EXPECT_EQ(book.GetOrder(handle), iceberg);
+    EXPECT_EQ(iceberg->GetVisibleQuantity(), 10);
+    EXPECT_EQ(iceberg->GetHiddenQuantity(), 5);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 13, 2 } }));
+
+    auto next = book.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 4, Side::Buy, 100, 4));
+    ASSERT_EQ(next.size(), 2);
+    EXPECT_EQ(next[0].GetAskTrade().orderID, 2);
+    EXPECT_EQ(next[1].GetAskTrade().orderID, 1);
+
+    // The last peak is whatever is left
+    book.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 5, Side::Buy, 100, 9));
+    EXPECT_EQ(iceberg->GetVisibleQuantity(), 5);
+    EXPECT_EQ(iceberg->GetHiddenQuantity(), 0);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 5, 1 } }));
+}
+
+TEST(IcebergTest, AggressiveIcebergTradesFullSizeThenRestsWithPeak) {
+    Orderbook book;
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 101, 12));
+
+    auto trades = book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 101, 30,
+                                                        std::nullopt, NoOwner, 10));
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[1].GetBidTrade().quantity, 12);
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 101, 10, 1 } }));
+}
+
+TEST(IcebergTest, FillOrKillAndLevelUpdatesSeeTheRightQuantities) {
+    Orderbook book;
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 30, std::nullopt, NoOwner, 5));
+
+    // Hidden reserve counts towards a FillOrKill, and the level update shows only
+    // what is left of the current peak: 22 takes four peaks and 2 of the fifth
+    LevelUpdateRecorder updates;
+    book.AddOrder(Order{OrderType::FillOrKill, 2, Side::Buy, 100, 22}, updates);
+    EXPECT_EQ(updates.updates.size(), 1);
+    EXPECT_EQ(updates.updates.back().quantity, 3);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 3, 1 } }));
+
+    // 8 remain in all, so 9 is rejected
+    book.AddOrder(Order{OrderType::FillOrKill, 3, Side::Buy, 100, 9}, updates);
+    EXPECT_EQ(updates.updates.size(), 1);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+TEST(IcebergTest, ModifyTakesReserveFirstAndKeepsPeak) {
+    Orderbook book;
+    Trades trades;
+    auto handle = book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 30, std::nullopt, NoOwner, 10}, trades);
+
+    book.ModifyOrder(OrderModify{ 1, Side::Buy, 100, 15 });
+    EXPECT_EQ(book.GetOrder(handle)->GetVisibleQuantity(), 10);
+    EXPECT_EQ(book.GetOrder(handle)->GetHiddenQuantity(), 5);
+
+    book.ModifyOrder(OrderModify{ 1, Side::Buy, 100, 4 });
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 100, 4, 1 } }));
+
+    // Cancel-replace at a new price is still an iceberg
+    book.ModifyOrder(OrderModify{ 1, Side::Buy, 99, 40 });
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 99, 10, 1 } }));
+    auto fills = book.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 2, Side::Sell, 99, 40));
+    EXPECT_EQ(fills.size(), 4);
+}
+
+TEST(IcebergTest, OnlyRestingOrdersCanBeIcebergs) {
+    Orderbook book;
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10));
+
+    EXPECT_THROW(book.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 2, Side::Buy, 100, 10,
+                                                       std::nullopt, NoOwner, 5)), std::invalid_argument);
+    EXPECT_THROW(book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 0, 10, 105,
+                                                       NoOwner, 5)), std::invalid_argument);
+    EXPECT_NO_THROW(book.AddOrder(std::make_shared<Order>(OrderType::PostOnly, 4, Side::Buy, 99, 10,
+                                                          std::nullopt, NoOwner, 5)));
+    EXPECT_EQ(book.Size(), 2);
+
+    // Wire and journal records hold a stop price or a peak, never both
+    auto both = OrderCommand::Add(OrderType::GoodTillCancel, 5, Side::Buy, 0, 10, 105, NoOwner, 5);
+    std::array<std::byte, MaxOrderEntryMessageSize> message;
+    EXPECT_THROW(EncodeOrderEntry(both, message.data()), std::invalid_argument);
+
+    TempFile file;
+    JournalWriter writer{file.path, JournalWriterOptions{ .sync = false }};
+    EXPECT_THROW(writer.Append(both), std::invalid_argument);
+}
+
+TEST(IcebergTest, PeakSurvivesSnapshotJournalWireAndFlowFiles) {
+    std::vector<OrderCommand> commands{
+        OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Sell, 100, 30, std::nullopt, 7, 10),
+        OrderCommand::Add(OrderType::GoodTillCancel, 2, Side::Sell, 100, 5),
+        OrderCommand::Add(OrderType::FillAndKill, 3, Side::Buy, 100, 6)
+    };
+    std::vector<OrderCommand> tail{
+        OrderCommand::Add(OrderType::FillAndKill, 4, Side::Buy, 100, 12),
+        OrderCommand::Add(OrderType::FillAndKill, 5, Side::Buy, 100, 20)
+    };
+
+    Orderbook book;
+    Trades ignored;
+    book.ProcessBatch(commands, ignored);
+    ASSERT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 100, 9, 2 } }));  // 4 of the peak left
+
+    // Snapshot keeps the partly used peak
+    Orderbook restored;
+    restored.LoadSnapshot(book.SaveSnapshot());
+    EXPECT_EQ(restored.GetOrderInfos().GetAsks(), book.GetOrderInfos().GetAsks());
+    EXPECT_EQ(restored.SaveSnapshot(), book.SaveSnapshot());
+
+    TempFile journal;
+    {
+        JournalWriter writer{journal.path, JournalWriterOptions{ .sync = false }};
+        writer.Append(commands);
+        writer.Commit();
+    }
+    Orderbook replayed;
+    ReplayJournal(journal.path, replayed);
+    EXPECT_EQ(replayed.SaveSnapshot(), book.SaveSnapshot());
+
+    Trades expected, fromSnapshot, fromJournal;
+    book.ProcessBatch(tail, expected);
+    restored.ProcessBatch(tail, fromSnapshot);
+    replayed.ProcessBatch(tail, fromJournal);
+    EXPECT_EQ(fromSnapshot, expected);
+    EXPECT_EQ(fromJournal, expected);
+
+    auto wire = EncodeMessages(commands);
+    OrderEntryReader reader{wire};
+    OrderEntryMessage message;
+    ASSERT_TRUE(reader.Next(message));
+    EXPECT_EQ(message.GetPeakQuantity(), 10);
+    EXPECT_FALSE(message.GetStopPrice());
+    EXPECT_EQ(message.ToCommand().peak, 10);
+
+    auto csv = FormatOrderFlowCsv(std::span{ commands }.first(1));
+    EXPECT_EQ(csv, "A,GTC,1,S,100,30,,7,10\n");
+    EXPECT_EQ(ParseOrderFlowCsv(csv)[0].peak, 10);
+    EXPECT_EQ(ParseOrderFlowCsv("A,POST,1,B,99,30,,,6\n")[0].peak, 6);
+}
+
+TEST(IcebergTest, MarketByOrderFeedShowsEachPeakAsNewAdd) {
+    Orderbook book;
+    MarketByOrderFeed feed{16};
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 100, 12, std::nullopt, NoOwner, 5}, feed);
+    book.AddOrder(Order{OrderType::FillAndKill, 2, Side::Buy, 100, 7}, feed);
+    book.CancelOrder(1, feed);
+
+    std::array<std::byte, 8 * MarketByOrderMessageSize> buffer;
+    auto bytes = feed.Read(buffer);
+    std::vector<MarketByOrderMessage> messages;
+    for (std::size_t offset = 0; offset < bytes; offset += MarketByOrderMessageSize)
+        messages.push_back(DecodeMarketByOrder(buffer.data() + offset));
+
+    using enum MarketByOrderType;
+    EXPECT_EQ(messages, (std::vector<MarketByOrderMessage>{
+        {1, Add, Side::Sell, 1, 100, 5},
+        {2, Execute, Side::Sell, 1, 100, 5},
+        {3, Add, Side::Sell, 1, 100, 5},
+        {4, Execute, Side::Sell, 1, 100, 2},
+        {5, Delete, Side::Sell, 1, 100, 3}
+    }));
+}
+
+// ===============================
+//       Time-In-Force Tests
+// ===============================
+
+TEST(TimeInForceTest, MovedFromBookExpiresOnlyItsOwnOrders) {
+    Orderbook book;
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillDate, 1, Side::Sell, 100, 10, std::nullopt, NoOwner, 0, 100}, trades);
+
+    // The reused book has an order 1 of its own, expiring later
+    Orderbook moved{std::move(book)};
+    book.AddOrder(Order{OrderType::GoodTillDate, 1, Side::Sell, 101, 5, std::nullopt, NoOwner, 0, 200}, trades);
+
+    RecordingListener listener;
+    book.AdvanceTime(150, listener);
+    EXPECT_TRUE(listener.events.empty());
+    EXPECT_EQ(book.Size(), 1);
+
+    moved.AdvanceTime(150, listener);
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "cancelled 1" }));
+    EXPECT_EQ(moved.Size(), 0);
+
+    book.AdvanceTime(200, listener);
+    EXPECT_EQ(listener.events.size(), 2);
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(TimeInForceTest, GoodTillDateRestsUntilItsExpiry) {
+    Orderbook book;
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillDate, 1, Side::Sell, 100, 10, std::nullopt, NoOwner, 0, 100));
+    book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 101, 5));
+
+    book.AdvanceTime(99);
+    EXPECT_EQ(book.Size(), 2);
+    EXPECT_EQ(book.GetTime(), 99);
+
+    RecordingListener listener;
+    book.AdvanceTime(100, listener);
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "cancelled 1" }));
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 101, 5, 1 } }));
+    EXPECT_EQ(book.GetTime(), 100);
+
+    // Expiry leaves through the cancel path, level update included
+    LevelUpdateRecorder updates;
+    book.AddOrder(Order{OrderType::GoodTillDate, 3, Side::Buy, 99, 4, std::nullopt, NoOwner, 0, 150}, updates);
+    book.AdvanceTime(1000, updates);
+    ASSERT_EQ(updates.updates.size(), 2);
+    EXPECT_EQ(updates.updates.back().price, 99);
+    EXPECT_EQ(updates.updates.back().quantity, 0);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+TEST(TimeInForceTest, MassExpiryReportsOneUpdatePerLevel) {
+    Orderbook book;
+    Trades trades;
+    OrderID id = 1;
+    for (Price i = 0; i < 100; ++i) {
+        for (auto [side, price] : { std::pair{ Side::Buy, 1000 - i }, std::pair{ Side::Sell, 2000 + i } }) {
+            book.AddOrder(Order{OrderType::GoodTillDate, id++, side, price, 1, std::nullopt, NoOwner, 0, 10}, trades);
+            book.AddOrder(Order{OrderType::GoodTillDate, id++, side, price, 2, std::nullopt, NoOwner, 0, 10}, trades);
+            if (i % 2 == 0)
+                book.AddOrder(Order{OrderType::GoodTillCancel, id++, side, price, 5}, trades);
+        }
+    }
+
+    // Hundreds of touches fold to one net update per level, in the order the levels were first touched
+    LevelUpdateRecorder recorder;
+    book.AdvanceTime(10, recorder);
+    ASSERT_EQ(recorder.updates.size(), 200);
+    for (Price i = 0; i < 100; ++i) {
+        Quantity left = i % 2 == 0 ? 5 : 0;
+        std::uint32_t orders = i % 2 == 0 ? 1 : 0;
+        EXPECT_EQ(recorder.updates[2 * i],
+                  (LevelUpdate{ recorder.updates[0].sequence + 2 * i, Side::Buy, 1000 - i, left, orders }));
+        EXPECT_EQ(recorder.updates[2 * i + 1],
+                  (LevelUpdate{ recorder.updates[0].sequence + 2 * i + 1, Side::Sell, 2000 + i, left, orders }));
+    }
+    EXPECT_EQ(book.Size(), 100);
+}
+
+TEST(TimeInForceTest, ReportsExpiriesInExpiryOrder) {
+    Orderbook book;
+    Trades trades;
+    Timestamp expiries[] = { 5, 3, Timestamp{ 1 } << 40, 70, 4097, 3 };
+    for (OrderID id = 1; id <= std::size(expiries); ++id)
+        book.AddOrder(Order{OrderType::GoodTillDate, id, Side::Buy, 100, 1, std::nullopt, NoOwner, 0, expiries[id - 1]},
+                      trades);
+
+    // One jump spans most of the wheel's levels; ties go by order ID
+    RecordingListener listener;
+    book.AdvanceTime(Timestamp{ 1 } << 41, listener);
+    EXPECT_EQ(listener.events, (std::vector<std::string>{
+        "cancelled 2", "cancelled 6", "cancelled 1", "cancelled 4", "cancelled 5", "cancelled 3" }));
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(TimeInForceTest, MatchesBruteForceUnderRandomExpiriesAndAdvances) {
+    std::mt19937_64 rng{41};
+    Orderbook book;
+    Trades trades;
+    std::map<OrderID, Timestamp> live;
+    Timestamp now = 0;
+    OrderID nextID = 1;
+
+    for (int step = 0; step < 20000; ++step) {
+        auto roll = rng() % 10;
+        if (roll < 6) {
+            // Expiries from just after now to far in the future, so every level of the wheel is used
+            auto expiry = now + 1 + (rng() >> (8 + rng() % 56));
+            book.AddOrder(Order{OrderType::GoodTillDate, nextID, Side::Buy, 100, 1, std::nullopt, NoOwner, 0, expiry},
+                          trades);
+            live[nextID++] = expiry;
+        } else if (roll < 8 && !live.empty()) {
+            auto it = live.lower_bound(1 + rng() % nextID);
+            if (it == live.end())
+                continue;
+            book.CancelOrder(it->first);
+            live.erase(it);
+        } else {
+            now += rng() >> (24 + rng() % 40);
+            std::vector<std::pair<Timestamp, OrderID>> due;
+            for (auto it = live.begin(); it != live.end();) {
+                if (it->second <= now) {
+                    due.emplace_back(it->second, it->first);
+                    it = live.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            std::sort(due.begin(), due.end());
+
+            RecordingListener listener;
+            book.AdvanceTime(now, listener);
+            std::vector<std::string> expected;
+            for (const auto& [expiry, id] : due)
+                expected.push_back("cancelled " + std::to_string(id));
+            ASSERT_EQ(listener.events, expected) << "at step " << step;
+        }
+        ASSERT_EQ(book.Size(), live.size());
+    }
+}
+
+TEST(TimeInForceTest, ValidatesExpiriesAndTime) {
+    Orderbook book;
+    EXPECT_THROW(book.AddOrder(std::make_shared<Order>(OrderType::GoodTillDate, 1, Side::Buy, 100, 10)),
+                 std::invalid_argument);
+    EXPECT_THROW(book.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 100, 10,
+                                                       std::nullopt, NoOwner, 0, 500)), std::invalid_argument);
+    EXPECT_THROW(book.AddOrder(std::make_shared<Order>(OrderType::Day, 3, Side::Buy, 100, 10)), std::invalid_argument);
+
+    book.AdvanceTime(50);
+    RecordingListener listener;
+    book.AddOrder(Order{OrderType::GoodTillDate, 4, Side::Buy, 100, 10, std::nullopt, NoOwner, 0, 50}, listener);
+    book.AddOrder(Order{OrderType::GoodTillDate, 5, Side::Buy, 100, 10, std::nullopt, NoOwner, 0, 51}, listener);
+    EXPECT_EQ(listener.events, (std::vector<std::string>{
+        "rejected 4 " + std::to_string(static_cast<int>(RejectReason::Expired)), "accepted 5" }));
+
+    EXPECT_THROW(book.AdvanceTime(49), std::invalid_argument);
+    EXPECT_NO_THROW(book.AdvanceTime(50));
+    EXPECT_THROW(book.SetSessionSchedule(100, 0), std::invalid_argument);
+}
+
+TEST(TimeInForceTest, DayOrdersExpireAtTheNextSessionClose) {
+    Orderbook book;
+    Trades trades;
+    book.SetSessionSchedule(1000, 500);
+
+    auto first = book.AddOrder(Order{OrderType::Day, 1, Side::Buy, 100, 10}, trades);
+    EXPECT_EQ(book.GetOrder(first)->GetExpiry(), 1000);
+
+    book.AdvanceTime(999);
+    EXPECT_EQ(book.Size(), 1);
+    book.AdvanceTime(1000);
+    EXPECT_EQ(book.Size(), 0);
+
+    // Accepted at or after a close, an order belongs to the next session
+    auto second = book.AddOrder(Order{OrderType::Day, 2, Side::Buy, 100, 10}, trades);
+    EXPECT_EQ(book.GetOrder(second)->GetExpiry(), 1500);
+    book.AdvanceTime(2200);
+    auto third = book.AddOrder(Order{OrderType::Day, 3, Side::Sell, 101, 10}, trades);
+    EXPECT_EQ(book.GetOrder(third)->GetExpiry(), 2500);
+    EXPECT_EQ(book.Size(), 1);
+}
+
+TEST(TimeInForceTest, OrdersLeavingTheBookOtherwiseDoNotExpire) {
+    Orderbook book;
+    Trades trades;
+    auto Gtd = [](OrderType type, OrderID id, Side side, Price price, Quantity quantity,
+                  std::optional<Price> stop = std::nullopt) {
+        return Order{type, id, side, price, quantity, stop, NoOwner, 0, 100};
+    };
+    book.AddOrder(Gtd(OrderType::GoodTillDate, 1, Side::Sell, 100, 5), trades);   // filled
+    book.AddOrder(Gtd(OrderType::GoodTillDate, 2, Side::Sell, 101, 5), trades);   // cancelled
+    book.AddOrder(Gtd(OrderType::GoodTillDate, 3, Side::Buy, 100, 5, 100), trades); // stop, triggered
+    book.AddOrder(Gtd(OrderType::GoodTillDate, 4, Side::Buy, 98, 10), trades);    // reduced, then replaced
+    book.AddOrder(Gtd(OrderType::GoodTillDate, 5, Side::Sell, 0, 5, 90), trades); // stop, stays pending
+    book.AddOrder(Order{OrderType::GoodTillCancel, 6, Side::Sell, 100, 5}, trades);
+
+    book.AddOrder(Order{OrderType::FillAndKill, 7, Side::Buy, 100, 5}, trades);
+    book.CancelOrder(2);
+    book.ModifyOrder(OrderModify{ 4, Side::Buy, 98, 6 });
+    book.ModifyOrder(OrderModify{ 4, Side::Buy, 97, 6 });
+    ASSERT_EQ(book.Size(), 1);
+    ASSERT_EQ(book.PendingStopCount(), 1);
+
+    // Only the replaced order, which kept its expiry, and the pending stop are left to expire
+    RecordingListener listener;
+    book.AdvanceTime(100, listener);
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "cancelled 4", "cancelled 5" }));
+    EXPECT_EQ(book.Size(), 0);
+    EXPECT_EQ(book.PendingStopCount(), 0);
+}
+
+TEST(TimeInForceTest, ExpirySurvivesSnapshotJournalWireAndFlowFiles) {
+    std::vector<OrderCommand> commands{
+        OrderCommand::Add(OrderType::GoodTillDate, 1, Side::Sell, 100, 30, std::nullopt, NoOwner, 10, 500),
+        OrderCommand::Add(OrderType::Day, 2, Side::Sell, 101, 5),
+        OrderCommand::Add(OrderType::GoodTillDate, 3, Side::Buy, 0, 5, 120, NoOwner, 0, 300),
+        OrderCommand::Add(OrderType::GoodTillDate, 4, Side::Buy, 99, 5, std::nullopt, NoOwner, 0, 150),
+        OrderCommand::AdvanceTime(200)
+    };
+    std::vector<OrderCommand> tail{
+        OrderCommand::AdvanceTime(400),
+        OrderCommand::Add(OrderType::FillAndKill, 5, Side::Buy, 101, 40),
+        OrderCommand::Add(OrderType::Day, 6, Side::Buy, 90, 5),
+        OrderCommand::AdvanceTime(600),
+        OrderCommand::AdvanceTime(1000)
+    };
+
+    Orderbook book;
+    book.SetSessionSchedule(1000, 1000);
+    Trades ignored;
+    book.ProcessBatch(commands, ignored);
+    ASSERT_EQ(book.Size(), 2);
+    ASSERT_EQ(book.PendingStopCount(), 1);
+
+    // Both carry the schedule, so neither book needs it set again
+    Orderbook restored;
+    restored.LoadSnapshot(book.SaveSnapshot());
+    EXPECT_EQ(restored.GetTime(), 200);
+    EXPECT_EQ(restored.GetSessionSchedule(), (SessionSchedule{ 1000, 1000 }));
+    EXPECT_EQ(restored.SaveSnapshot(), book.SaveSnapshot());
+
+    TempFile journal;
+    {
+        JournalWriter writer{journal.path, JournalWriterOptions{ .sync = false, .session = SessionSchedule{ 1000, 1000 } }};
+        writer.Append(commands);
+    }
+    Orderbook replayed;
+    ReplayJournal(journal.path, replayed);
+    EXPECT_EQ(replayed.GetSessionSchedule(), (SessionSchedule{ 1000, 1000 }));
+    EXPECT_EQ(replayed.SaveSnapshot(), book.SaveSnapshot());
+
+    RecordingListener expected, fromSnapshot, fromJournal;
+    book.ProcessBatch(tail, expected);
+    restored.ProcessBatch(tail, fromSnapshot);
+    replayed.ProcessBatch(tail, fromJournal);
+    EXPECT_EQ(fromSnapshot.events, expected.events);
+    EXPECT_EQ(fromJournal.events, expected.events);
+    EXPECT_EQ(std::count(expected.events.begin(), expected.events.end(), "cancelled 3"), 1);
+    EXPECT_EQ(std::count(expected.events.begin(), expected.events.end(), "cancelled 6"), 1);
+
+    auto wire = EncodeMessages(std::span{ commands }.first(4));
+    OrderEntryReader reader{wire};
+    OrderEntryMessage message;
+    ASSERT_TRUE(reader.Next(message));
+    EXPECT_EQ(message.GetExpiry(), 500);
+    EXPECT_EQ(message.ToCommand().time, 500);
+    std::array<std::byte, MaxOrderEntryMessageSize> buffer;
+    EXPECT_THROW(EncodeOrderEntry(commands.back(), buffer.data()), std::invalid_argument);
+
+    auto csv = FormatOrderFlowCsv(commands);
+    EXPECT_EQ(csv, "A,GTD,1,S,100,30,,,10,500\n"
+                   "A,DAY,2,S,101,5\n"
+                   "A,GTD,3,B,0,5,120,,,300\n"
+                   "A,GTD,4,B,99,5,,,,150\n"
+                   "T,200\n");
+    auto parsed = ParseOrderFlowCsv(csv);
+    ASSERT_EQ(parsed.size(), commands.size());
+    EXPECT_EQ(parsed[0].time, 500);
+    EXPECT_EQ(parsed[2].stopPrice, 120);
+    EXPECT_EQ(parsed[4].type, CommandType::AdvanceTime);
+    EXPECT_EQ(parsed[4].time, 200);
+}
+
+TEST(TimeInForceTest, EnginesPipelinesAndJournalsAgreeOnTheSessionSchedule) {
+    constexpr SessionSchedule Session{ 1000, 500 };
+    auto Day = OrderCommand::Add(OrderType::Day, 1, Side::Buy, 100, 5);
+
+    MatchingEngine engine;
+    engine.AddInstrument(1, std::nullopt, nullptr, nullptr, Session);
+    EXPECT_THROW(engine.AddInstrument(2, std::nullopt, nullptr, nullptr, SessionSchedule{ 1000, 0 }),
+                 std::invalid_argument);
+    engine.Start();
+    engine.Submit(1, Day);
+    engine.WaitIdle();
+    engine.Stop();
+    ASSERT_EQ(engine.GetBook(1).Size(), 1);
+    EXPECT_EQ(engine.GetBook(1).GetOrder(1)->GetExpiry(), 1000);
+
+    TempFile file;
+    {
+        JournalWriter journal{file.path, JournalWriterOptions{ .sync = false, .session = Session }};
+        EXPECT_THROW((OrderPipeline{OrderPipelineConfig{}, &journal, {}}), std::invalid_argument);
+
+        OrderPipeline pipeline{OrderPipelineConfig{ .session = Session }, &journal, {}};
+        pipeline.Start();
+        pipeline.Submit(Day);
+        pipeline.Stop();
+        EXPECT_EQ(pipeline.GetBook().GetOrder(1)->GetExpiry(), 1000);
+    }
+
+    // Reopening keeps the header's schedule, and refuses a different one
+    EXPECT_THROW(JournalWriter(file.path, JournalWriterOptions{ .sync = false, .session = SessionSchedule{ 1000, 600 } }),
+                 std::runtime_error);
+    EXPECT_EQ(JournalWriter(file.path, JournalWriterOptions{ .sync = false }).Session(), Session);
+    EXPECT_EQ(JournalReader(file.path).Session(), Session);
+
+    // A version 4 snapshot has a 64-byte header and no schedule
+    Orderbook book;
+    book.SetSessionSchedule(Session);
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 5}, trades);
+    auto snapshot = book.SaveSnapshot();
+    snapshot.erase(snapshot.begin() + 64, snapshot.begin() + snapshot_format::HeaderSize);
+    StoreLE(snapshot.data() + 8, std::uint32_t{ 4 });
+    Orderbook restored;
+    restored.LoadSnapshot(snapshot);
+    EXPECT_EQ(restored.Size(), 1);
+    EXPECT_FALSE(restored.GetSessionSchedule());
+}
+
+TEST(TimeInForceTest, ReadsOlderJournalsButAppendsOnlyToCurrentOnes) {
+    // A version 3 journal: 32-byte header and records, one GTC add
+    std::array<std::byte, 64> bytes{};
+    std::memcpy(bytes.data(), "OBJOURNL", 8);
+    StoreLE(bytes.data() + 8, std::uint32_t{ 3 });
+    StoreLE(bytes.data() + 12, std::uint32_t{ 32 });
+    auto* record = bytes.data() + 32;
+    record[0] = std::byte{ 1 };
+    record[2] = static_cast<std::byte>(OrderType::GoodTillCancel);
+    StoreLE(record + 8, OrderID{ 1 });
+    StoreLE(record + 16, Price{ 100 });
+    StoreLE(record + 20, Quantity{ 5 });
+
+    TempFile file;
+    {
+        std::ofstream out{file.path, std::ios::binary};
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    Orderbook book;
+    auto result = ReplayJournal(file.path, book);
+    EXPECT_EQ(result.commands, 1);
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 100, 5, 1 } }));
+
+    EXPECT_THROW(JournalWriter(file.path, JournalWriterOptions{ .sync = false }), std::runtime_error);
+}
+
+// ===============================
+//          Policy Tests
+// ===============================
+
+template <typename Book>
+concept HasSelfTradePrevention = requires(Book& book) { book.SetSelfTradePrevention(SelfTradePrevention::CancelOldest); };
+
+static_assert(HasSelfTradePrevention<Orderbook>);
+static_assert(!HasSelfTradePrevention<LeanOrderbook>);
+static_assert(std::constructible_from<LeanOrderbook, const LadderConfig&>);
+
+// Instantiated here from OrderbookImpl.h rather than taken from the library
+struct StopsOnlyPolicy : DefaultOrderbookPolicy {
+    static constexpr bool EnableSelfTradePrevention = false;
+};
+static_assert(!HasSelfTradePrevention<BasicOrderbook<StopsOnlyPolicy>>);
+
+TEST(PolicyTest, LeanBookMatchesFullBookWithoutStops) {
+    auto commands = MakeRandomCommands(31, 20000);
+    std::erase_if(commands, [](const OrderCommand& command) { return command.stopPrice.has_value(); });
+
+    Orderbook full;
+    LeanOrderbook lean{LadderConfig{80, 1, 40}};
+    Trades fullTrades, leanTrades;
+    full.ProcessBatch(commands, fullTrades);
+    lean.ProcessBatch(commands, leanTrades);
+
+    EXPECT_FALSE(fullTrades.empty());
+    EXPECT_EQ(leanTrades, fullTrades);
+    EXPECT_EQ(lean.LevelUpdateSequence(), full.LevelUpdateSequence());
+    // Same orders in the same priority, down to the bytes
+    EXPECT_EQ(lean.SaveSnapshot(), full.SaveSnapshot());
+}
+
+TEST(PolicyTest, LeanBookRefusesStops) {
+    LeanOrderbook lean;
+    Trades trades;
+    EXPECT_THROW(lean.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 5, 101}, trades),
+                 std::invalid_argument);
+    EXPECT_EQ(lean.Size() + lean.PendingStopCount(), 0);
+
+    Orderbook full;
+    full.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 99, 5));
+    auto withoutStops = full.SaveSnapshot();
+    full.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 100, 5, 101));
+
+    EXPECT_THROW(lean.LoadSnapshot(full.SaveSnapshot()), std::runtime_error);
+    EXPECT_EQ(lean.Size(), 0);
+    lean.LoadSnapshot(withoutStops);
+    EXPECT_EQ(lean.GetOrderInfos().GetBids(), (LevelInfos{ { 99, 5, 1 } }));
+}
+
+TEST(PolicyTest, LeanBookLeavesInstrumentationOut) {
+    auto before = TakeInstrumentationSnapshot();
+    LeanOrderbook lean;
+    lean.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 100, 5));
+    lean.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 2, Side::Sell, 100, 2));
+    lean.CancelOrder(1);
+
+    auto after = TakeInstrumentationSnapshot();
+    EXPECT_EQ(after.adds, before.adds);
+    EXPECT_EQ(after.fills, before.fills);
+    EXPECT_EQ(after.cancels, before.cancels);
+}
+
+TEST(PolicyTest, CustomPolicyKeepsStopsWithoutOwnerChecks) {
+    BasicOrderbook<StopsOnlyPolicy> book;
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 98, 6, std::nullopt, 7}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 0, 5, 99, 7}, trades);
+    EXPECT_EQ(book.PendingStopCount(), 1);
+
+    // Every order has the same owner and still trades: a trade at 99 triggers the stop into order 1
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Buy, 99, 1, std::nullopt, 7}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Sell, 99, 1, std::nullopt, 7}, trades);
+    EXPECT_EQ(book.PendingStopCount(), 0);
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades.back().GetBidTrade().orderID, 1);
+    EXPECT_EQ(trades.back().GetAskTrade().orderID, 2);
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 98, 1, 1 } }));
+}
+
+// ===============================
+//        Depth Query Tests
+// ===============================
+
+template <typename Book>
+concept HasDepthQueries = requires(const Book& book) { book.GetCostToFill(Side::Buy, 1); };
+
+static_assert(HasDepthQueries<Orderbook>);
+static_assert(!HasDepthQueries<LeanOrderbook>);
+
+// What the depth queries should answer, walked level by level over GetOrderInfos
+static std::optional<FillCost> WalkCostToFill(const LevelInfos& levels, std::uint64_t quantity) {
+    FillCost cost;
+    for (const auto& level : levels) {
+        if (cost.quantity == quantity)
+            break;
+        auto take = std::min<std::uint64_t>(level.quantity_, quantity - cost.quantity);
+        cost.quantity += take;
+        cost.notional += static_cast<std::uint64_t>(level.price_) * take;
+        cost.worstPrice = level.price_;
+    }
+    if (quantity == 0 || cost.quantity < quantity)
+        return std::nullopt;
+    return cost;
+}
+
+static std::uint64_t WalkDepthTo(const LevelInfos& levels, Side side, Price limit) {
+    std::uint64_t depth = 0;
+    for (const auto& level : levels)
+        if (side == Side::Buy ? level.price_ <= limit : level.price_ >= limit)
+            depth += level.quantity_;
+    return depth;
+}
+
+static void ExpectDepthQueriesMatchLevelWalk(const Orderbook& book, std::mt19937_64& rng) {
+    auto infos = book.GetOrderInfos();
+    for (auto side : { Side::Buy, Side::Sell }) {
+        const auto& levels = side == Side::Buy ? infos.GetAsks() : infos.GetBids();
+        std::uint64_t total = 0;
+        for (const auto& level : levels)
+            total += level.quantity_;
+
+        for (std::uint64_t quantity : { std::uint64_t{ 0 }, std::uint64_t{ 1 }, 1 + rng() % (total + 1), total, total + 1 }) {
+            auto expected = WalkCostToFill(levels, quantity);
+            ASSERT_EQ(book.GetCostToFill(side, quantity), expected) << "quantity " << quantity;
+            ASSERT_EQ(book.GetPriceForQuantity(side, quantity),
+                      expected ? std::optional{ expected->worstPrice } : std::nullopt);
+        }
+        for (Price limit = 85; limit <= 115; ++limit)
+            ASSERT_EQ(book.GetDepthTo(side, limit), WalkDepthTo(levels, side, limit)) << "limit " << limit;
+    }
+}
+
+TEST(DepthQueryTest, PricesASweepAcrossLevels) {
+    Orderbook book;
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 101, 5}, trades);
+    // An iceberg shows its peak only, and so do the queries
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 102, 10, std::nullopt, NoOwner, 3}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 105, 4}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 99, 7}, trades);
+
+    EXPECT_EQ(book.GetCostToFill(Side::Buy, 6), (FillCost{ 6, 5 * 101 + 102, 102 }));
+    EXPECT_EQ(book.GetCostToFill(Side::Buy, 12), (FillCost{ 12, 5 * 101 + 3 * 102 + 4 * 105, 105 }));
+    EXPECT_DOUBLE_EQ(book.GetCostToFill(Side::Buy, 6)->Vwap(), 607.0 / 6);
+    EXPECT_EQ(book.GetCostToFill(Side::Buy, 13), std::nullopt);
+    EXPECT_EQ(book.GetCostToFill(Side::Buy, 0), std::nullopt);
+    EXPECT_EQ(book.GetPriceForQuantity(Side::Buy, 8), 102);
+    EXPECT_EQ(book.GetPriceForQuantity(Side::Sell, 7), 99);
+    EXPECT_EQ(book.GetPriceForQuantity(Side::Sell, 8), std::nullopt);
+
+    EXPECT_EQ(book.GetDepthTo(Side::Buy, 100), 0);
+    EXPECT_EQ(book.GetDepthTo(Side::Buy, 104), 8);
+    EXPECT_EQ(book.GetDepthTo(Side::Sell, 99), 7);
+    EXPECT_EQ(book.GetDepthTo(Side::Sell, 100), 0);
+
+    // Trading and cancelling move the answers with the book
+    book.AddOrder(Order{OrderType::FillAndKill, 5, Side::Buy, 102, 6}, trades);
+    book.CancelOrder(3);
+    // The iceberg's peak is down to 2 and only replenishes once taken whole
+    EXPECT_EQ(book.GetDepthTo(Side::Buy, 200), 2);
+    EXPECT_EQ(book.GetCostToFill(Side::Buy, 2), (FillCost{ 2, 2 * 102, 102 }));
+}
+
+TEST(DepthQueryTest, MatchesLevelWalkUnderRandomFlow) {
+    // Levels all in the map, split between band and map, and on a coarser ladder tick
+    for (auto config : { LadderConfig{ 0, 1, 0 }, LadderConfig{ 95, 1, 10 }, LadderConfig{ 90, 2, 11 } }) {
+        SCOPED_TRACE("ladder from " + std::to_string(config.basePrice) + " by " + std::to_string(config.tickSize));
+        std::mt19937_64 rng{ 43 };
+        auto commands = MakeRandomCommands(43, 20000);
+        auto book = config.levelCount == 0 ? std::make_unique<Orderbook>() : std::make_unique<Orderbook>(config);
+        Trades trades;
+
+        Timestamp now = 0;
+        for (std::size_t i = 0; i < commands.size(); i += 100) {
+            auto end = std::min(i + 100, commands.size());
+            book->ProcessBatch(std::span{ commands }.subspan(i, end - i), trades);
+            // Expiries leave the book through their own path
+            now += 40;
+            book->AdvanceTime(now);
+            ExpectDepthQueriesMatchLevelWalk(*book, rng);
+        }
+    }
+}
+
+TEST(DepthQueryTest, RestoredBookAnswersLikeTheOriginal) {
+    auto commands = MakeRandomCommands(47, 5000);
+    Orderbook original;
+    Trades trades;
+    original.ProcessBatch(commands, trades);
+
+    Orderbook restored{LadderConfig{95, 1, 10}};
+    restored.LoadSnapshot(original.SaveSnapshot());
+    std::mt19937_64 rng{ 47 };
+    ExpectDepthQueriesMatchLevelWalk(restored, rng);
+    EXPECT_EQ(restored.GetCostToFill(Side::Buy, 50), original.GetCostToFill(Side::Buy, 50));
+    EXPECT_EQ(restored.GetDepthTo(Side::Sell, 95), original.GetDepthTo(Side::Sell, 95));
+}
+
+// ===============================
+//          Auction Tests
+// ===============================
+
+struct AuctionListener : RecordingListener {
+    std::vector<AuctionIndication> indications;
+
+    void OnAuctionIndication(const AuctionIndication& indication) override { indications.push_back(indication); }
+};
+
+TEST(AuctionTest, CollectsCrossedOrdersAndUncrossesAtOnePrice) {
+    Orderbook book;
+    Trades trades;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 99, 5}, trades);
+    book.StartAuction(100);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 102, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 101, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 100, 4}, trades);
+    EXPECT_TRUE(trades.empty());
+    EXPECT_TRUE(book.InAuction());
+
+    // 101 and 102 both trade 10 leaving 5 unsold; 101 is nearer the reference price
+    EXPECT_EQ(book.GetIndicativeUncross(), (AuctionIndication{ 101, 10, -5 }));
+    EXPECT_EQ(book.Uncross(trades), (AuctionIndication{ 101, 10, -5 }));
+    EXPECT_FALSE(book.InAuction());
+    EXPECT_EQ(book.GetIndicativeUncross(), AuctionIndication{});
+    EXPECT_EQ(trades, (Trades{ Trade{ TradeInfo{ 2, 101, 5 }, TradeInfo{ 1, 101, 5 } },
+                               Trade{ TradeInfo{ 2, 101, 5 }, TradeInfo{ 3, 101, 5 } } }));
+    EXPECT_EQ(book.GetOrderInfos().GetBids(), (LevelInfos{ { 100, 4, 1 } }));
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 101, 5, 1 } }));
+
+    // Back to continuous matching
+    book.AddOrder(Order{OrderType::FillAndKill, 5, Side::Buy, 101, 2}, trades);
+    EXPECT_EQ(trades.size(), 3);
+}
+
+TEST(AuctionTest, ImbalanceThenReferencePriceBreakTies) {
+    Orderbook book;
+    Trades trades;
+    book.StartAuction(102);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 102, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Buy, 100, 2}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 100, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Sell, 101, 3}, trades);
+    // Every crossed price trades 10; 100 leaves the smallest surplus, whatever the reference
+    EXPECT_EQ(book.GetIndicativeUncross(), (AuctionIndication{ 100, 10, 2 }));
+
+    Orderbook other;
+    other.StartAuction(105);
+    other.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 102, 10}, trades);
+    other.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 99, 5}, trades);
+    other.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 101, 10}, trades);
+    EXPECT_EQ(other.GetIndicativeUncross(), (AuctionIndication{ 102, 10, -5 }));
+    EXPECT_TRUE(trades.empty());
+}
+
+TEST(AuctionTest, RejectsOrdersThatCannotWaitAndParksStops) {
+    Orderbook book;
+    AuctionListener listener;
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Sell, 101, 3}, listener);
+    book.StartAuction(100);
+
+    book.AddOrder(Order{OrderType::FillAndKill, 2, Side::Buy, 101, 1}, listener);
+    book.AddOrder(Order{OrderType::FillOrKill, 3, Side::Buy, 101, 1}, listener);
+    book.AddOrder(Order{OrderType::Market, 4, Side::Buy, 0, 1}, listener);
+    book.AddOrder(Order{OrderType::PostOnly, 5, Side::Sell, 120, 1}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 6, Side::Buy, 101, 2, 100}, listener);
+    auto reject = " " + std::to_string(static_cast<int>(RejectReason::AuctionInProgress));
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "accepted 1", "rejected 2" + reject, "rejected 3" + reject,
+                                                          "rejected 4" + reject, "rejected 5" + reject,
+                                                          "accepted 6" }));
+    EXPECT_EQ(book.PendingStopCount(), 1);
+
+    // The uncross prints at 100, which sets the stop off against the ask left at 101
+    book.AddOrder(Order{OrderType::GoodTillCancel, 7, Side::Buy, 100, 5}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 8, Side::Sell, 100, 5}, listener);
+    listener.events.clear();
+    EXPECT_EQ(book.Uncross(listener), (AuctionIndication{ 100, 5, 0 }));
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "trade 7/8", "triggered 6", "trade 6/1" }));
+    EXPECT_EQ(book.PendingStopCount(), 0);
+    EXPECT_EQ(book.GetOrderInfos().GetAsks(), (LevelInfos{ { 101, 1, 1 } }));
+}
+
+TEST(AuctionTest, PublishesIndicationOnlyWhenItMoves) {
+    Orderbook book;
+    AuctionListener listener;
+    book.StartAuction(100);
+
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10}, listener);
+    EXPECT_TRUE(listener.indications.empty());
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 100, 4}, listener);
+    EXPECT_EQ(listener.indications, (std::vector<AuctionIndication>{ { 100, 4, 6 } }));
+
+    // Levels outside the crossed band cannot move the equilibrium
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 110, 5}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 4, Side::Buy, 95, 2}, listener);
+    // An iceberg counts with its reserve
+    book.AddOrder(Order{OrderType::GoodTillCancel, 5, Side::Sell, 100, 8, std::nullopt, NoOwner, 2}, listener);
+    book.CancelOrder(2, listener);
+    EXPECT_EQ(listener.indications, (std::vector<AuctionIndication>{ { 100, 4, 6 }, { 100, 10, -2 }, { 100, 8, 2 } }));
+
+    book.CancelOrder(5, listener);
+    EXPECT_EQ(listener.indications.back(), AuctionIndication{});
+    EXPECT_EQ(book.GetIndicativeUncross(), AuctionIndication{});
+}
+
+TEST(AuctionTest, MatchesBruteForceEquilibriumUnderRandomFlow) {
+    for (std::uint64_t seed = 0; seed < 20; ++seed) {
+        std::mt19937_64 rng{ seed };
+        auto book = seed % 2 ? std::make_unique<Orderbook>(LadderConfig{ 95, 1, 10 }) : std::make_unique<Orderbook>();
+        Price reference = 95 + Price(rng() % 11);
+        book->StartAuction(reference);
+
+        // Quantity per level, reserves included; nothing matches until the uncross
+        std::map<std::pair<Side, Price>, std::uint64_t> levels;
+        std::map<OrderID, std::pair<Order, OrderHandle>> live;
+        Trades none;
+        for (OrderID id = 1; id <= 300; ++id) {
+            if (rng() % 4 == 0 && !live.empty()) {
+                auto it = live.lower_bound(1 + rng() % id);
+                if (it == live.end())
+                    continue;
+                const auto& order = it->second.first;
+                levels[{ order.GetSide(), order.GetPrice() }] -= order.GetRemainingQuantity();
+                book->CancelOrder(it->first);
+                live.erase(it);
+            } else {
+                auto side = rng() % 2 ? Side::Buy : Side::Sell;
+                Price price = 90 + Price(rng() % 21);
+                Quantity quantity = 1 + Quantity(rng() % 20);
+                Quantity peak = rng() % 5 == 0 ? 1 + Quantity(rng() % 3) : 0;
+                Order order{OrderType::GoodTillCancel, id, side, price, quantity, std::nullopt, NoOwner, peak};
+                live.emplace(id, std::pair{ order, book->AddOrder(order, none) });
+                levels[{ side, price }] += quantity;
+            }
+
+            AuctionIndication expected;
+            auto Key = [&](const AuctionIndication& indication) {
+                return std::tuple{ indication.volume, -std::abs(indication.imbalance),
+                                   -std::abs(std::int64_t{ indication.price } - reference), -indication.price };
+            };
+            for (const auto& [key, level] : levels) {
+                if (level == 0)
+                    continue;
+                std::uint64_t demand = 0, supply = 0;
+                for (const auto& [other, quantity] : levels) {
+                    if (other.first == Side::Buy && other.second >= key.second)
+                        demand += quantity;
+                    if (other.first == Side::Sell && other.second <= key.second)
+                        supply += quantity;
+                }
+                AuctionIndication candidate{ key.second, std::min(demand, supply),
+                                             std::int64_t(demand) - std::int64_t(supply) };
+                if (candidate.volume != 0 && Key(candidate) > Key(expected))
+                    expected = candidate;
+            }
+            ASSERT_EQ(book->GetIndicativeUncross(), expected) << "seed " << seed << " order " << id;
+        }
+
+        ASSERT_TRUE(none.empty());
+        auto indicated = book->GetIndicativeUncross();
+        std::uint64_t before = 0;
+        for (const auto& [id, entry] : live)
+            before += entry.first.GetRemainingQuantity();
+
+        Trades trades;
+        ASSERT_EQ(book->Uncross(trades), indicated);
+        std::uint64_t traded = 0;
+        for (const auto& trade : trades) {
+            EXPECT_EQ(trade.GetBidTrade().price, indicated.price);
+            EXPECT_EQ(trade.GetAskTrade().price, indicated.price);
+            traded += trade.GetBidTrade().quantity;
+        }
+        EXPECT_EQ(traded, indicated.volume);
+
+        // Nothing crosses afterwards, and every traded lot left the book from both sides
+        auto infos = book->GetOrderInfos();
+        if (!infos.GetBids().empty() && !infos.GetAsks().empty()) {
+            EXPECT_LT(infos.GetBids().front().price_, infos.GetAsks().front().price_);
+        }
+        std::uint64_t after = 0;
+        for (const auto& [id, entry] : live)
+            if (const auto* order = book->GetOrder(entry.second))
+                after += order->GetRemainingQuantity();
+        EXPECT_EQ(after, before - 2 * traded);
+    }
+}
+
+TEST(AuctionTest, SameOwnerPairShrinksInsteadOfTrading) {
+    Orderbook book;
+    AuctionListener listener;
+    book.SetSelfTradePrevention(SelfTradePrevention::CancelOldest);
+    book.StartAuction(100);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 100, 10, std::nullopt, 7}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 100, 4, std::nullopt, 7}, listener);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 3, Side::Sell, 100, 6, std::nullopt, 8}, listener);
+    EXPECT_EQ(book.GetIndicativeUncross(), (AuctionIndication{ 100, 10, 0 }));
+
+    listener.events.clear();
+    EXPECT_EQ(book.Uncross(listener), (AuctionIndication{ 100, 6, 0 }));
+    EXPECT_EQ(listener.events, (std::vector<std::string>{ "reduced 1", "cancelled 2", "trade 1/3" }));
+    EXPECT_EQ(book.Size(), 0);
+}
+
+TEST(AuctionTest, ValidatesPhase) {
+    Orderbook book;
+    Trades trades;
+    EXPECT_THROW(book.Uncross(trades), std::logic_error);
+    book.StartAuction(100);
+    EXPECT_THROW(book.StartAuction(100), std::logic_error);
+    EXPECT_EQ(book.Uncross(trades), AuctionIndication{});
+    EXPECT_FALSE(book.InAuction());
+}
+
+TEST(AuctionTest, AuctionDayReplaysFromJournalFlowFileAndPipeline) {
+    // Opening auction, continuous trading, closing auction; the stray Uncross and
+    // second StartAuction come in the wrong phase and are ignored
+    auto flow = MakeRandomCommands(53, 3000);
+    std::vector<OrderCommand> commands{ OrderCommand::Uncross(), OrderCommand::StartAuction(100) };
+    commands.insert(commands.end(), flow.begin(), flow.begin() + 1000);
+    commands.push_back(OrderCommand::StartAuction(90));
+    commands.push_back(OrderCommand::Uncross());
+    commands.insert(commands.end(), flow.begin() + 1000, flow.begin() + 2000);
+    commands.push_back(OrderCommand::StartAuction(101));
+    commands.insert(commands.end(), flow.begin() + 2000, flow.end());
+    commands.push_back(OrderCommand::Uncross());
+
+    TempFile file;
+    Orderbook live;
+    TradeChecksum liveTrades;
+    std::vector<AuctionIndication> liveUncrosses;
+    {
+        JournalWriter writer{file.path, JournalWriterOptions{ .sync = false }};
+        for (std::size_t i = 0; i < commands.size(); i += 100) {
+            std::span batch{ commands.data() + i, std::min<std::size_t>(100, commands.size() - i) };
+            writer.Append(batch);
+            Trades trades;
+            live.ProcessBatch(batch, trades);
+            liveTrades.Add(trades);
+            writer.AppendCheckpoint(liveTrades);
+        }
+    }
+    EXPECT_FALSE(live.InAuction());
+
+    Orderbook oneByOne;
+    TradeChecksum oneByOneTrades;
+    oneByOneTrades.Add(ApplyOneByOne(oneByOne, commands));
+    EXPECT_EQ(oneByOneTrades.Value(), liveTrades.Value());
+
+    Orderbook replayed;
+    auto result = ReplayJournal(file.path, replayed);
+    EXPECT_EQ(result.commands, commands.size());
+    EXPECT_EQ(result.trades.Value(), liveTrades.Value());
+    EXPECT_EQ(replayed.SaveSnapshot(), live.SaveSnapshot());
+
+    auto parsed = ParseOrderFlowCsv(FormatOrderFlowCsv(commands));
+    ASSERT_EQ(parsed.size(), commands.size());
+    EXPECT_EQ(parsed[1].type, CommandType::StartAuction);
+    EXPECT_EQ(parsed[1].price, 100);
+    EXPECT_EQ(parsed.back().type, CommandType::Uncross);
+    Orderbook fromFlow;
+    TradeChecksum flowTrades;
+    Trades trades;
+    fromFlow.ProcessBatch(parsed, trades);
+    flowTrades.Add(trades);
+    EXPECT_EQ(flowTrades.Value(), liveTrades.Value());
+
+    OrderPipeline pipeline{OrderPipelineConfig{}, nullptr, {}};
+    pipeline.Start();
+    for (const auto& command : commands)
+        pipeline.Submit(command);
+    pipeline.WaitIdle();
+    pipeline.Stop();
+    EXPECT_EQ(pipeline.GetBook().SaveSnapshot(), live.SaveSnapshot());
+
+    EXPECT_THROW(EncodeMessages(std::vector{ OrderCommand::Uncross() }), std::invalid_argument);
+}
+
+TEST(AuctionTest, SnapshotKeepsTheAuctionAndRefusesACrossedBookOutsideOne) {
+    Orderbook book;
+    Trades trades;
+    book.StartAuction(99);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 1, Side::Buy, 105, 10}, trades);
+    book.AddOrder(Order{OrderType::GoodTillCancel, 2, Side::Sell, 95, 10}, trades);
+    auto snapshot = book.SaveSnapshot();
+
+    Orderbook restored;
+    restored.LoadSnapshot(snapshot);
+    EXPECT_TRUE(restored.InAuction());
+    EXPECT_EQ(restored.GetIndicativeUncross(), book.GetIndicativeUncross());
+    EXPECT_EQ(restored.SaveSnapshot(), snapshot);
+
+    Trades expected, uncrossed;
+    EXPECT_EQ(restored.Uncross(uncrossed), book.Uncross(expected));
+    EXPECT_EQ(uncrossed, expected);
+    EXPECT_EQ(restored.Size(), 0);
+
+    // The same orders saved outside an auction could never have rested
+    auto continuous = snapshot;
+    continuous[64] = std::byte{ 0 };
+    Orderbook target;
+    EXPECT_THROW(target.LoadSnapshot(continuous), std::runtime_error);
+    EXPECT_EQ(target.Size(), 0);
+    EXPECT_FALSE(target.InAuction());
+
+    // A book already in an auction can take them, and uncrosses by its own reference price
+    target.StartAuction(104);
+    target.LoadSnapshot(continuous);
+    EXPECT_EQ(target.Size(), 2);
+    EXPECT_EQ(target.Uncross(trades), (AuctionIndication{ 105, 10, 0 }));
+}
+
+// ===============================
+//          Pipeline Tests
+// ===============================
+
+struct CollectingStage : PipelineStage {
+    std::vector<PipelineEvent> events;
+    std::size_t batches{ 0 };
+
+    void OnEvent(const PipelineEvent& event) override { events.push_back(event); }
+    void OnBatchEnd() override { ++batches; }
+
+    std::vector<ExecutionReport> Reports() const {
+        std::vector<ExecutionReport> reports;
+        for (const auto& event : events)
+            if (event.kind == PipelineEvent::Kind::Report)
+                reports.push_back(event.report);
+        return reports;
+    }
+
+    LevelUpdates Updates() const {
+        LevelUpdates updates;
+        for (const auto& event : events)
+            if (event.kind == PipelineEvent::Kind::LevelUpdate)
+                updates.push_back(event.level);
+        return updates;
+    }
+};
+
+TEST(PipelineTest, StagesSeeWhatASynchronousSessionReports) {
+    auto commands = MakeRandomCommands(41, 5000);
+
+    // Rings far smaller than the flow, and than some commands' events, force
+    // wrap-around and back-pressure at every stage
+    CollectingStage reports, marketData;
+    OrderPipeline pipeline{OrderPipelineConfig{ .commandCapacity = 16, .eventCapacity = 4 }, nullptr,
+                           { &reports, &marketData }};
+    pipeline.Start();
+    for (std::size_t i = 0; i < commands.size(); ++i)
+        ASSERT_EQ(pipeline.Submit(commands[i]), i + 1);
+    pipeline.WaitIdle();
+
+    Orderbook expected;
+    ExecutionReportEncoder encoder;
+    for (const auto& command : commands) {
+        try {
+            expected.ProcessBatch({ &command, 1 }, encoder);
+        } catch (const std::invalid_argument&) {
+            encoder.RejectInvalid(command);
+        }
+    }
+
+    EXPECT_EQ(reports.Reports(), DecodeReports(encoder.Reports()));
+    EXPECT_EQ(pipeline.GetBook().GetOrderInfos().GetBids(), expected.GetOrderInfos().GetBids());
+    EXPECT_EQ(pipeline.GetBook().GetOrderInfos().GetAsks(), expected.GetOrderInfos().GetAsks());
+
+    auto rebuilt = ApplyLevelUpdates(OrderbookLevelInfos{ {}, {} }, 0, marketData.Updates());
+    EXPECT_EQ(rebuilt.GetBids(), expected.GetOrderInfos().GetBids());
+    EXPECT_EQ(rebuilt.GetAsks(), expected.GetOrderInfos().GetAsks());
+
+    ASSERT_EQ(reports.events.size(), marketData.events.size());
+    for (std::size_t i = 1; i < reports.events.size(); ++i)
+        ASSERT_LE(reports.events[i - 1].command, reports.events[i].command);
+    EXPECT_GT(reports.batches, 1);
+
+    pipeline.Stop();
+}
+
+TEST(PipelineTest, FillReportsCarryEachSidesOwner) {
+    CollectingStage reports;
+    OrderPipeline pipeline{OrderPipelineConfig{}, nullptr, { &reports }};
+    pipeline.Start();
+    pipeline.Submit(OrderCommand::Add(OrderType::GoodTillCancel, 10, Side::Buy, 100, 10, std::nullopt, 1));
+    pipeline.Submit(OrderCommand::Add(OrderType::GoodTillCancel, 20, Side::Sell, 100, 20, std::nullopt, 2));
+    pipeline.WaitIdle();
+    pipeline.Stop();
+
+    std::vector<std::pair<OrderID, OwnerID>> fills;
+    for (const auto& report : reports.Reports())
+        if (report.type == ExecutionReportType::Fill)
+            fills.emplace_back(report.orderID, report.owner);
+    EXPECT_EQ(fills, (std::vector<std::pair<OrderID, OwnerID>>{ { 10, 1 }, { 20, 2 } }));
+}
+
+TEST(PipelineTest, JournalsEveryCommandAheadOfItsReports) {
+    TempFile file;
+    auto commands = MakeRandomCommands(43, 3000);
+
+    // Counts events that arrive before their command is in the file
+    struct JournalCheckingStage : CollectingStage {
+        std::filesystem::path path;
+        std::size_t early{ 0 };
+
+        void OnEvent(const PipelineEvent& event) override {
+            CollectingStage::OnEvent(event);
+            early += std::filesystem::file_size(path) < JournalRecordSize * (1 + event.command);
+        }
+    } reports;
+    reports.path = file.path;
+    {
+        JournalWriter journal{file.path.string(), JournalWriterOptions{ .sync = false }};
+        OrderPipeline pipeline{OrderPipelineConfig{ .commandCapacity = 8, .eventCapacity = 64 }, &journal,
+                               { &reports }};
+        pipeline.Start();
+        for (const auto& command : commands)
+            pipeline.Submit(command);
+        pipeline.Stop();
+
+        EXPECT_EQ(journal.CommandCount(), commands.size());
+        EXPECT_EQ(reports.events.back().command, commands.size());
+        EXPECT_EQ(reports.early, 0);
+
+        Orderbook replayed;
+        ReplayJournal(file.path.string(), replayed);
+        EXPECT_EQ(replayed.GetOrderInfos().GetBids(), pipeline.GetBook().GetOrderInfos().GetBids());
+        EXPECT_EQ(replayed.GetOrderInfos().GetAsks(), pipeline.GetBook().GetOrderInfos().GetAsks());
+    }
+}
+
+TEST(PipelineTest, SequencerRefusesWhatNoBookCouldAccept) {
+    CollectingStage reports;
+    OrderPipeline pipeline{OrderPipelineConfig{ .commandCapacity = 4, .eventCapacity = 4 }, nullptr, { &reports }};
+    pipeline.Start();
+
+    EXPECT_THROW(pipeline.Submit(OrderCommand::Add(OrderType::GoodTillCancel, 1, Side::Buy, 100, 0)),
+                 std::invalid_argument);
+    EXPECT_THROW(pipeline.Submit(OrderCommand::Add(OrderType::FillAndKill, 1, Side::Buy, 100, 5, std::nullopt,
+                                                   NoOwner, 2)),
+                 std::invalid_argument);
+    EXPECT_EQ(pipeline.Submit(OrderCommand::AdvanceTime(50)), 1);
+    EXPECT_THROW(pipeline.Submit(OrderCommand::AdvanceTime(40)), std::invalid_argument);
+
+    // Valid on its own; this book has no session schedule, so the matcher refuses it
+    EXPECT_EQ(pipeline.Submit(OrderCommand::Add(OrderType::Day, 2, Side::Buy, 100, 5)), 2);
+    EXPECT_EQ(pipeline.Submit(OrderCommand::Add(OrderType::GoodTillCancel, 3, Side::Buy, 100, 5)), 3);
+    pipeline.WaitIdle();
+
+    auto received = reports.Reports();
+    ASSERT_EQ(received.size(), 2);
+    EXPECT_EQ(received[0].type, ExecutionReportType::Rejected);
+    EXPECT_EQ(received[0].reason, InvalidOrderReason);
+    EXPECT_EQ(received[0].orderID, 2);
+    EXPECT_EQ(received[1].type, ExecutionReportType::Accepted);
+    EXPECT_EQ(received[1].sequence, 2);
+    EXPECT_EQ(pipeline.FailedCommands(), 1);
+    EXPECT_EQ(pipeline.GetBook().Size(), 1);
+
+    EXPECT_THROW((OrderPipeline{OrderPipelineConfig{ .eventCapacity = 0 }, nullptr, {}}), std::invalid_argument);
+}
+
+TEST(PipelineTest, FailingStageHaltsPipeline) {
+    struct FailingStage : PipelineStage {
+        void OnEvent(const PipelineEvent& event) override {
+            if (event.command >= 3)
+                throw std::runtime_error("stage failed");
+        }
+    } failing;
+
+    OrderPipeline pipeline{OrderPipelineConfig{ .commandCapacity = 4, .eventCapacity = 4 }, nullptr, { &failing }};
+    pipeline.Start();
+    auto commands = MakeRandomCommands(47, 100);
+    EXPECT_THROW({
+        for (const auto& command : commands)
+            pipeline.Submit(command);
+        pipeline.WaitIdle();
+    }, std::runtime_error);
+    EXPECT_THROW(pipeline.Stop(), std::runtime_error);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,77 @@
+#include "Journal.h"
+#include "Orderbook.h"
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+    Timestamp ParseTimestamp(std::string_view text, const char* what) {
+        Timestamp value{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc{} || end != text.data() + text.size())
+            throw std::invalid_argument(std::format("bad {} '{}'", what, text));
+        return value;
+    }
+
+    SessionSchedule ParseSession(std::string_view text) {
+        auto comma = text.find(',');
+        if (comma == std::string_view::npos)
+            throw std::invalid_argument(std::format("bad session '{}'", text));
+        return { ParseTimestamp(text.substr(0, comma), "session close"),
+                 ParseTimestamp(text.substr(comma + 1), "session length") };
+    }
+}
+
+// Rebuilds a book from a command journal, verifying every checkpoint on the way.
+// Day orders expire by the schedule in the journal's header; --session supplies
+// one for journals written without it.
+int main(int argc, char** argv) {
+    std::string_view path;
+    std::optional<SessionSchedule> session;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg == "--session" && i + 1 < argc)
+                session = ParseSession(argv[++i]);
+            else if (arg.starts_with("--") || !path.empty())
+                throw std::invalid_argument(std::format("unexpected argument '{}'", arg));
+            else
+                path = arg;
+        }
+        if (path.empty())
+            throw std::invalid_argument("a journal is required");
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n"
+                  << "usage: " << argv[0] << " <journal> [--session FIRST_CLOSE,LENGTH]\n";
+        return 2;
+    }
+
+    Orderbook book;
+    try {
+        if (session)
+            book.SetSessionSchedule(*session);
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = ReplayJournal(std::string{ path }, book);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "commands:      " << result.commands << " (" << result.failedCommands << " failed)\n"
+                  << "trades:        " << result.trades.Count() << "\n"
+                  << "checksum:      " << std::hex << result.trades.Value() << std::dec << "\n"
+                  << "checkpoints:   " << result.checkpoints << " verified\n"
+                  << "resting:       " << book.Size() << " orders, " << book.PendingStopCount() << " stops\n"
+                  << "elapsed:       " << elapsed.count() << " s ("
+                  << static_cast<std::uint64_t>(result.commands / elapsed.count()) << " commands/s)\n";
+    } catch (const std::exception& error) {
+        std::cerr << "replay failed: " << error.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "FileIO.h"
+#include "OrderEntry.h"
+#include "Orderbook.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Pushes a recorded order-entry capture through a book as fast as it decodes,
+// optionally writing the execution reports it produces to a file
+int main(int argc, char** argv) {
+    if (argc != 2 && argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <capture> [reports-out]\n";
+        return 2;
+    }
+
+    constexpr std::size_t ChunkSize = 1 << 20;
+
+    int out = -1;
+    try {
+        MappedFile capture{argv[1]};
+        if (argc == 3) {
+            out = ::open(argv[2], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (out < 0)
+                throw std::system_error(errno, std::generic_category(), std::string{"open "} + argv[2]);
+        }
+
+        Orderbook book;
+        OrderEntrySession session{book};
+        std::uint64_t reports = 0;
+
+        auto input = capture.data();
+        std::size_t offset = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        // Chunked so the report buffer stays bounded; a chunk boundary may split a
+        // message, which the next chunk then starts with
+        while (offset < input.size()) {
+            auto chunk = input.subspan(offset, std::min(ChunkSize, input.size() - offset));
+            auto consumed = session.Process(chunk);
+            if (consumed == 0)
+                break;
+            offset += consumed;
+
+            reports += session.Reports().size() / ExecutionReportSize;
+            if (out >= 0)
+                WriteAll(out, session.Reports(), argv[2]);
+            session.ClearReports();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (out >= 0)
+            ::close(out);
+
+        std::cout << "messages:      " << session.MessageCount() << "\n"
+                  << "reports:       " << reports << "\n"
+                  << "resting:       " << book.Size() << " orders, " << book.PendingStopCount() << " stops\n"
+                  << "elapsed:       " << elapsed.count() << " s ("
+                  << static_cast<std::uint64_t>(session.MessageCount() / elapsed.count()) << " messages/s)\n";
+
+        if (offset != input.size()) {
+            std::cerr << "capture ends with a partial message (" << input.size() - offset << " bytes)\n";
+            return 1;
+        }
+    } catch (const std::exception& error) {
+        if (out >= 0)
+            ::close(out);
+        std::cerr << "replay failed: " << error.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+#include "Instrumentation.h"
+#include "LatencyHistogram.h"
+#include "OrderFlowFile.h"
+#include "Orderbook.h"
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+    struct Options {
+        std::string path;
+        std::size_t runs{ 1 };
+        std::size_t depth{ 5 };
+        std::optional<std::uint64_t> expectedChecksum;
+        SelfTradePrevention selfTradePrevention{ SelfTradePrevention::None };
+        std::optional<SessionSchedule> session;
+    };
+
+    struct RunResult {
+        TradeChecksum trades;
+        std::uint64_t rejects{ 0 };
+        std::uint64_t failedCommands{ 0 };
+        double seconds{ 0 };
+    };
+
+    class ReplayListener final : public OrderbookListener {
+    public:
+        explicit ReplayListener(RunResult& result) : result_{ result } { }
+
+        void OnTrade(const Trade& trade) override { result_.trades.Add(trade); }
+        void OnOrderRejected(const Order&, RejectReason) override { ++result_.rejects; }
+
+    private:
+        RunResult& result_;
+    };
+
+    template <typename T>
+    T ParseNumber(std::string_view text, const char* what, int base = 10) {
+        T value{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+        if (error != std::errc{} || end != text.data() + text.size())
+            throw std::invalid_argument(std::format("bad {} '{}'", what, text));
+        return value;
+    }
+
+    SelfTradePrevention ParseSelfTradePrevention(std::string_view text) {
+        if (text == "none")
+            return SelfTradePrevention::None;
+        if (text == "newest")
+            return SelfTradePrevention::CancelNewest;
+        if (text == "oldest")
+            return SelfTradePrevention::CancelOldest;
+        if (text == "both")
+            return SelfTradePrevention::CancelBoth;
+        if (text == "decrement")
+            return SelfTradePrevention::DecrementAndCancel;
+        throw std::invalid_argument(std::format("bad self-trade prevention mode '{}'", text));
+    }
+
+    SessionSchedule ParseSession(std::string_view text) {
+        auto comma = text.find(',');
+        if (comma == std::string_view::npos)
+            throw std::invalid_argument(std::format("bad session '{}'", text));
+        return { ParseNumber<Timestamp>(text.substr(0, comma), "session close"),
+                 ParseNumber<Timestamp>(text.substr(comma + 1), "session length") };
+    }
+
+    Options ParseOptions(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            auto value = [&]() -> std::string_view {
+                if (i + 1 == argc)
+                    throw std::invalid_argument(std::format("{} needs a value", arg));
+                return argv[++i];
+            };
+
+            if (arg == "--runs")
+                options.runs = ParseNumber<std::size_t>(value(), "run count");
+            else if (arg == "--depth")
+                options.depth = ParseNumber<std::size_t>(value(), "depth");
+            else if (arg == "--expect-checksum")
+                options.expectedChecksum = ParseNumber<std::uint64_t>(value(), "checksum", 16);
+            else if (arg == "--stp")
+                options.selfTradePrevention = ParseSelfTradePrevention(value());
+            else if (arg == "--session")
+                options.session = ParseSession(value());
+            else if (arg.starts_with("--") || !options.path.empty())
+                throw std::invalid_argument(std::format("unexpected argument '{}'", arg));
+            else
+                options.path = arg;
+        }
+
+        if (options.path.empty() || options.runs == 0)
+            throw std::invalid_argument("a flow file and a positive run count are required");
+        return options;
+    }
+
+    // Applies every command through the book's single-command API, timing each one.
+    // Commands the book refuses count as failed, as they would have live.
+    RunResult Replay(Orderbook& book, std::span<const OrderCommand> commands,
+                     std::array<LatencyHistogram, 6>& latencies) {
+        using Clock = std::chrono::steady_clock;
+
+        RunResult result;
+        ReplayListener listener{result};
+
+        auto runStart = Clock::now();
+        for (const auto& command : commands) {
+            auto start = Clock::now();
+            try {
+                switch (command.type) {
+                case CommandType::Add:
+                    book.AddOrder(command.ToOrder(), listener);
+                    break;
+                case CommandType::Cancel:
+                    book.CancelOrder(command.orderID, listener);
+                    break;
+                case CommandType::Modify:
+                    book.ModifyOrder(command.ToModify(), listener);
+                    break;
+                case CommandType::AdvanceTime:
+                    book.AdvanceTime(command.time, listener);
+                    break;
+                case CommandType::StartAuction:
+                case CommandType::Uncross:
+                    // Through the batch API, which skips a start or uncross in the wrong phase
+                    book.ProcessBatch({ &command, 1 }, listener);
+                    break;
+                }
+            } catch (const std::invalid_argument&) {
+                ++result.failedCommands;
+            }
+            auto end = Clock::now();
+            latencies[static_cast<std::size_t>(command.type)].Record(
+                static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+
+        return result;
+    }
+
+    void PrintLatencies(const std::array<LatencyHistogram, 6>& latencies) {
+        LatencyHistogram all;
+        for (const auto& histogram : latencies)
+            all.Merge(histogram);
+
+        std::cout << std::format("{:<14}{:>12}{:>9}{:>9}{:>9}{:>9}{:>9}{:>9}{:>10}\n", "latency (ns)", "count",
+                                 "mean", "p50", "p90", "p99", "p99.9", "p99.99", "max");
+        auto row = [](std::string_view name, const LatencyHistogram& histogram) {
+            std::cout << std::format("  {:<12}{:>12}{:>9.0f}{:>9}{:>9}{:>9}{:>9}{:>9}{:>10}\n", name,
+                                     histogram.Count(), histogram.Mean(), histogram.ValueAtPercentile(50),
+                                     histogram.ValueAtPercentile(90), histogram.ValueAtPercentile(99),
+                                     histogram.ValueAtPercentile(99.9), histogram.ValueAtPercentile(99.99),
+                                     histogram.Max());
+        };
+
+        row("add", latencies[static_cast<std::size_t>(CommandType::Add)]);
+        row("cancel", latencies[static_cast<std::size_t>(CommandType::Cancel)]);
+        row("modify", latencies[static_cast<std::size_t>(CommandType::Modify)]);
+        row("time", latencies[static_cast<std::size_t>(CommandType::AdvanceTime)]);
+        row("auction", latencies[static_cast<std::size_t>(CommandType::StartAuction)]);
+        row("uncross", latencies[static_cast<std::size_t>(CommandType::Uncross)]);
+        row("all", all);
+    }
+
+    // Counters and cycle histograms from an ORDERBOOK_INSTRUMENTATION build, summed over all runs
+    void PrintInstrumentation() {
+        auto stats = TakeInstrumentationSnapshot();
+        std::cout << "instrumentation:\n"
+                  << "  adds " << stats.adds << ", cancels " << stats.cancels << ", modifies " << stats.modifies
+                  << ", fills " << stats.fills << "\n"
+                  << "  rejected FAK " << stats.rejectedFillAndKill << ", FOK " << stats.rejectedFillOrKill
+                  << ", post-only " << stats.rejectedPostOnly << "\n"
+                  << "  stop triggers " << stats.stopTriggers << " in " << stats.stopCascades
+                  << " cascades, max depth " << stats.maxCascadeDepth << "\n"
+                  << "  self-trades prevented " << stats.selfTradesPrevented << ", iceberg replenishments "
+                  << stats.icebergReplenishments << ", orders expired " << stats.ordersExpired << "\n"
+                  << "  levels created " << stats.levelsCreated << ", destroyed " << stats.levelsDestroyed << "\n";
+
+        std::cout << std::format("  {:<28}{:>12}{:>9}{:>9}{:>9}{:>10}\n", "cycles", "count", "p50", "p99", "p99.9",
+                                 "max");
+        auto row = [](std::string_view name, const LatencyHistogram& histogram) {
+            std::cout << std::format("  {:<28}{:>12}{:>9}{:>9}{:>9}{:>10}\n", name, histogram.Count(),
+                                     histogram.ValueAtPercentile(50), histogram.ValueAtPercentile(99),
+                                     histogram.ValueAtPercentile(99.9), histogram.Max());
+        };
+        row("MatchAggressiveOrder", stats.matchCycles);
+        row("CancelOrder", stats.cancelCycles);
+        row("CheckAndTriggerStopOrders", stats.stopTriggerCycles);
+    }
+
+    void PrintDepth(const Orderbook& book, std::size_t depth) {
+        auto levels = book.GetTopLevels(depth);
+        const auto& bids = levels.GetBids();
+        const auto& asks = levels.GetAsks();
+
+        std::cout << std::format("{:>12}{:>10}  {:<10}{:<12}\n", "bid qty", "bid", "ask", "ask qty");
+        for (std::size_t i = 0; i < std::max(bids.size(), asks.size()); ++i) {
+            auto bid = i < bids.size() ? std::format("{:>12}{:>10}", bids[i].quantity_, bids[i].price_)
+                                       : std::string(22, ' ');
+            auto ask = i < asks.size() ? std::format("{:<10}{:<12}", asks[i].price_, asks[i].quantity_)
+                                       : std::string{};
+            std::cout << bid << "  " << ask << "\n";
+        }
+    }
+}
+
+// Replays recorded order flow through a fresh book as fast as it will go and
+// reports throughput, per-operation latency, final depth and a trade checksum.
+// With --runs N the flow is replayed N times and every run must produce the
+// same trades; --expect-checksum fails the run if the trades differ from a
+// known-good build's. --stp sets the book's self-trade prevention mode for
+// flows that carry owners, and --session the session schedule Day orders
+// expire by.
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n"
+                  << "usage: " << argv[0] << " <flow.csv|flow.bin> [--runs N] [--depth N] [--expect-checksum HEX]"
+                  << " [--stp none|newest|oldest|both|decrement] [--session FIRST_CLOSE,LENGTH]\n";
+        return 2;
+    }
+
+    try {
+        auto commands = LoadOrderFlow(options.path);
+
+        std::array<LatencyHistogram, 6> latencies;
+        std::optional<RunResult> first;
+        double bestSeconds = 0;
+        Orderbook book;
+
+        for (std::size_t run = 0; run < options.runs; ++run) {
+            book = Orderbook{};
+            book.SetSelfTradePrevention(options.selfTradePrevention);
+            if (options.session)
+                book.SetSessionSchedule(*options.session);
+            auto result = Replay(book, commands, latencies);
+            bestSeconds = run == 0 ? result.seconds : std::min(bestSeconds, result.seconds);
+
+            if (!first) {
+                first = result;
+            } else if (result.trades.Value() != first->trades.Value() || result.trades.Count() != first->trades.Count()) {
+                std::cerr << "run " << run + 1 << " produced different trades than run 1: replay is not deterministic\n";
+                return 1;
+            }
+        }
+
+        std::cout << "commands:      " << commands.size() << " (" << first->failedCommands << " failed, "
+                  << first->rejects << " rejected)\n"
+                  << "runs:          " << options.runs << "\n"
+                  << "best run:      " << bestSeconds << " s ("
+                  << static_cast<std::uint64_t>(commands.size() / bestSeconds) << " commands/s)\n";
+        PrintLatencies(latencies);
+        std::cout << "trades:        " << first->trades.Count() << "\n"
+                  << "checksum:      " << std::hex << first->trades.Value() << std::dec << "\n"
+                  << "resting:       " << book.Size() << " orders, " << book.PendingStopCount() << " stops\n";
+        PrintDepth(book, options.depth);
+        if constexpr (InstrumentationEnabled)
+            PrintInstrumentation();
+
+        if (options.expectedChecksum && *options.expectedChecksum != first->trades.Value()) {
+            std::cerr << "checksum mismatch: expected " << std::hex << *options.expectedChecksum << ", got "
+                      << first->trades.Value() << std::dec << "\n";
+            return 1;
+        }
+    } catch (const std::exception& error) {
+        std::cerr << "replay failed: " << error.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}